@@ -0,0 +1,16 @@
+/**
+ * @file LinkDef.h
+ * @brief Selection of the ROOT dictionary of libAndiCommon, see Makefile
+ * @details Everything declared in common.h goes into the dictionary, so the helpers can be used from the ROOT prompt and macros as if common.cpp was interpreted.
+ */
+#ifdef __CLING__
+#pragma link off all globals;
+#pragma link off all classes;
+#pragma link off all functions;
+#pragma link C++ nestedclasses;
+#pragma link C++ nestedtypedefs;
+
+#pragma link C++ namespace andi;
+#pragma link C++ namespace andi::cuts;
+#pragma link C++ defined_in "common.h";
+#endif
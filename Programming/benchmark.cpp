@@ -0,0 +1,520 @@
+/**
+ * @file benchmark.cpp
+ * @brief Benchmarks for the functions of common.cpp
+ * @details Includes only the declarations of common.h and is linked against libAndiCommon, so it measures the compiled library. Run with `make benchmark`, or with the library loaded (e.g. through .rootrc)
+ *
+ *     root -l -b -q -e 'gSystem->AddLinkedLibs("-L. -lAndiCommon")' benchmark.cpp+
+ *
+ * or `root -l -b -q -e 'gSystem->AddLinkedLibs("-L. -lAndiCommon")' 'benchmark.cpp+(1000000, "results.json")'` for other sample sizes and to keep the results.
+ *
+ * All inputs are generated with fixed seeds, so the numbers of different runs (and versions of common.cpp) can be compared with each other. Every benchmark prints one line of JSON with its wall time and, where they apply, events/s, MB/s and fits/s.
+ */
+
+#include "TRandom3.h"
+#include "TStopwatch.h"
+#include "TH1D.h"
+#include "TCanvas.h"
+#include "TSystem.h"
+#include "TFile.h"
+#include "TTree.h"
+
+#include "common.h"
+
+namespace andi {
+namespace benchmark {
+	/**
+	 * @name Reporting
+	 * @{
+	 */
+	/**
+	 * @brief File the results are additionally written to, see report(); none if empty
+	 */
+	TString & reportFileName() {
+		static TString fileName = "";
+		return fileName;
+	}
+	/**
+	 * @brief Prints the result of one benchmark as one line of JSON, and appends it to reportFileName()
+	 * @details Rates which do not apply (count 0) are left out.
+	 *
+	 * @param name Name of the benchmark
+	 * @param seconds Wall time
+	 * @param nEvents Number of processed entries (for events/s)
+	 * @param nBytes Number of read or written bytes (for MB/s)
+	 * @param nFits Number of fits (for fits/s)
+	 */
+	void report(TString name, double seconds, double nEvents = 0, double nBytes = 0, double nFits = 0) {
+		TString line = TString::Format("{\"benchmark\": \"%s\", \"seconds\": %g", name.Data(), seconds);
+		if (nEvents > 0) line += TString::Format(", \"events\": %.0f, \"events_per_s\": %g", nEvents, nEvents / seconds);
+		if (nBytes > 0) line += TString::Format(", \"MB\": %g, \"MB_per_s\": %g", nBytes / 1e6, nBytes / 1e6 / seconds);
+		if (nFits > 0) line += TString::Format(", \"fits\": %.0f, \"fits_per_s\": %g", nFits, nFits / seconds);
+		line += "}";
+		std::cout << line << std::endl;
+		if (reportFileName() != "") {
+			std::ofstream file(reportFileName().Data(), std::ios::app);
+			file << line << std::endl;
+		}
+	}
+	/**
+	 * @}
+	 */
+	/**
+	 * @name Reference histograms and fit comparisons
+	 * @{
+	 */
+	/**
+	 * @brief Creates a reference set of histograms with double Gaussian distributions
+	 * @details Core and tail widths, tail fractions and centers are varied; every third histogram has an asymmetric axis.
+	 *
+	 * @param nHistograms Number of histograms
+	 * @param nEntries Number of entries per histogram
+	 * @param seed Seed of the random generator
+	 * @return Vector of histograms, owned by the caller
+	 */
+	std::vector<TH1*> doubleGaussHistograms(int nHistograms = 200, int nEntries = 20000, unsigned int seed = 4357) {
+		TRandom3 random(seed);
+		std::vector<TH1*> histograms;
+		for (int i = 0; i < nHistograms; i++) {
+			double center = random.Uniform(-0.5, 0.5);
+			double sigmaCore = random.Uniform(0.5, 1.5);
+			double sigmaTail = sigmaCore * random.Uniform(2, 5);
+			double tailFraction = random.Uniform(0.1, 0.4);
+			double lower = -15, upper = 15;
+			if (i % 3 == 2) {
+				lower = -8;
+				upper = 25;
+			}
+			TH1D * hist = new TH1D(Form("hBenchmarkGauss%d", i), "", 150, lower, upper);
+			hist->SetDirectory(0);
+			for (int j = 0; j < nEntries; j++) {
+				hist->Fill((random.Rndm() < tailFraction) ? random.Gaus(center, sigmaTail) : random.Gaus(center, sigmaCore));
+			}
+			histograms.push_back(hist);
+		}
+		return histograms;
+	}
+	/**
+	 * @brief The double Gaussian fit with pre-fits, as doubleGaussFitNonZero() did it before seeding: doubleGaussPrefit(), then the fit of doubleGaussFit()
+	 * @return The fitted function of defaultFitWorkspace()
+	 */
+	TF1 * doubleGaussFitPrefitted(TH1 * hist) {
+		double parameters[6] = {0, 0, 0, 0, 0, 0};
+		double centralValue = hist->GetMean();
+		double innerRangeMax = fabs(centralValue - hist->GetXaxis()->GetXmax()) / 10;
+		double outerRangeMax = innerRangeMax * 8;
+		doubleGaussPrefit(hist, parameters, centralValue, innerRangeMax, outerRangeMax);
+		return doubleGaussFit(hist, false, centralValue - outerRangeMax, centralValue + outerRangeMax, parameters);
+	}
+	/**
+	 * @brief Compares the double Gaussian fit with pre-fits (doubleGaussFitPrefitted()) with the one seeded by doubleGaussSeed() (doubleGaussFitSeeded())
+	 * @details Both use the TFormula functions of the single fit functions, so the baseline is the fit as it was done before seeding. Prints the number of function calls (pre-fits included) and the time per fit, the number of fits which did not converge and how well the resulting parameters of the two approaches agree.
+	 *
+	 * @param nHistograms Number of histograms to fit
+	 */
+	void fitSeeding(int nHistograms = 200) {
+		std::vector<TH1*> histograms = doubleGaussHistograms(nHistograms);
+		const char * fitNames[2] = {"preFits", "seeded"};
+		std::vector<std::vector<double> > parameters[2], errors[2];
+		std::vector<bool> failed[2];
+		bool wasEnabled = instruments().enabled;
+		instruments().enabled = true;  // for the counters of function calls and failed fits
+		for (int t = 0; t < 2; t++) {
+			double callsBefore = instruments().counters["fit function calls"];
+			TStopwatch watch;
+			for (unsigned int i = 0; i < histograms.size(); i++) {
+				double failedBefore = instruments().counters["failed fits"];
+				TF1 * fit = (t == 0) ? doubleGaussFitPrefitted(histograms[i]) : doubleGaussFitSeeded(histograms[i]);
+				failed[t].push_back(instruments().counters["failed fits"] > failedBefore);
+				parameters[t].push_back(std::vector<double>(fit->GetParameters(), fit->GetParameters() + 6));
+				errors[t].push_back(std::vector<double>(fit->GetParErrors(), fit->GetParErrors() + 6));
+			}
+			watch.Stop();
+			double nCalls = instruments().counters["fit function calls"] - callsBefore;
+			int nFailed = std::count(failed[t].begin(), failed[t].end(), true);
+			report(TString("fitSeeding_") + fitNames[t], watch.RealTime(), 0, 0, histograms.size());
+			std::cout << "fitSeeding " << fitNames[t] << ": " << nCalls / histograms.size() << " calls/fit, " << nFailed << " failed" << std::endl;
+		}
+		instruments().enabled = wasEnabled;
+		// agreement of the two approaches, relative to the fit error
+		double maxPull[3] = {0, 0, 0};  // constant, mean, sigma of the narrower Gaussian
+		for (unsigned int i = 0; i < histograms.size(); i++) {
+			if (failed[0][i] || failed[1][i]) continue;
+			int core[2];
+			for (int t = 0; t < 2; t++) core[t] = (fabs(parameters[t][i][2]) < fabs(parameters[t][i][5])) ? 0 : 1;
+			for (int k = 0; k < 3; k++) {
+				double a = parameters[0][i][3 * core[0] + k], b = parameters[1][i][3 * core[1] + k];
+				if (k == 2) {
+					a = fabs(a);
+					b = fabs(b);
+				}
+				double error = std::max(errors[1][i][3 * core[1] + k], 1e-12);
+				maxPull[k] = std::max(maxPull[k], fabs(a - b) / error);
+			}
+		}
+		std::cout << "fitSeeding agreement (max |difference|/error of the core Gaussian): constant " << maxPull[0] << ", mean " << maxPull[1] << ", sigma " << maxPull[2] << std::endl;
+
+		for (unsigned int i = 0; i < histograms.size(); i++) delete histograms[i];
+	}
+	/**
+	 * @brief Compares the unbinned double Gaussian fit (doubleGaussFitUnbinned()) with the binned one of a histogram (fill + doubleGaussFitSeeded())
+	 * @details Prints the time per fit and the fitted inner sigma for samples of increasing size.
+	 */
+	void unbinnedFit() {
+		TRandom3 random(4357);
+		Long64_t sizes[4] = {1000, 100000, 1000000, 10000000};
+		for (int s = 0; s < 4; s++) {
+			std::vector<double> values(sizes[s]);
+			for (Long64_t i = 0; i < sizes[s]; i++) values[i] = (random.Rndm() < 0.25) ? random.Gaus(0.1, 3) : random.Gaus(0.1, 1);
+
+			TStopwatch watch;
+			TH1D * hist = new TH1D("hBenchmarkUnbinned", "", 150, -15, 15);
+			hist->SetDirectory(0);
+			for (Long64_t i = 0; i < sizes[s]; i++) hist->Fill(values[i]);
+			TF1 * binned = doubleGaussFitSeeded(hist);
+			watch.Stop();
+			double timeBinned = watch.RealTime();
+
+			watch.Start();
+			TF1 * unbinned = doubleGaussFitUnbinned(values, hist->GetBinWidth(1), -15, 15);
+			watch.Stop();
+			report(TString::Format("binnedFit_%lld", sizes[s]), timeBinned, sizes[s], 0, 1);
+			report(TString::Format("unbinnedFit_%lld", sizes[s]), watch.RealTime(), sizes[s], 0, 1);
+			std::cout << "unbinnedFit " << sizes[s] << " values: sigma binned " << binned->GetParameter(2) << ", unbinned " << unbinned->GetParameter(2) << std::endl;
+			delete unbinned;
+			delete hist;
+		}
+	}
+	/**
+	 * @}
+	 */
+	/**
+	 * @name Synthetic ntuples
+	 * @{
+	 */
+	/**
+	 * @brief Writes a tree with D -> K pi pi candidates in the branch layout of setBranchAddresses()
+	 * @details Branches `baseString + {"", "d0", "d1", "d2"} + {"pt", "px", "py", "pz", "p", "e", "m", "chg", "pdg"}`, all Float_t. Signal has a mother mass peak (double Gaussian around 1.8696 GeV), background is flat in mass; the daughters share the mother momentum randomly.
+	 *
+	 * @param fileName ROOT file to create
+	 * @param treeName Name of the tree
+	 * @param baseString Prefix of all branches
+	 * @param nEntries Number of entries
+	 * @param signal Signal or background
+	 * @param seed Seed of the random generator
+	 * @return Size of the file in bytes
+	 */
+	Long64_t generateTree(TString fileName, TString treeName, TString baseString, Long64_t nEntries, bool signal, unsigned int seed) {
+		TRandom3 random(seed);
+		TDirectory * previousDirectory = gDirectory;
+		TFile file(fileName, "RECREATE");
+		TTree * tree = new TTree(treeName, treeName);
+		DInfoContainer container;
+		for (int iParticle = 0; iParticle < nDInfoParticles; iParticle++) {
+			for (int iField = 0; iField < nPropertiesFields; iField++) {
+				TString branchName = baseString + DInfoParticleNames[iParticle] + propertiesFieldNames[iField];
+				tree->Branch(branchName, &(container.*DInfoParticles[iParticle].*propertiesFields[iField]), branchName + "/F");
+			}
+		}
+		const double daughterMasses[3] = {0.493677, 0.13957, 0.13957};
+		const double daughterPdg[3] = {-321, 211, 211};
+		for (Long64_t i = 0; i < nEntries; i++) {
+			properties & m = container.m;
+			m.m = signal ? ((random.Rndm() < 0.8) ? random.Gaus(1.8696, 0.008) : random.Gaus(1.8696, 0.025)) : random.Uniform(1.7, 2.05);
+			m.px = random.Gaus(0, 2);
+			m.py = random.Gaus(0, 2);
+			m.pz = random.Gaus(0, 10);
+			double fractions[3] = {random.Uniform(0.2, 0.5), random.Uniform(0.2, 0.4), 0};
+			fractions[2] = 1 - fractions[0] - fractions[1];
+			for (int j = 0; j < 3; j++) {
+				properties & d = container.*DInfoParticles[j + 1];
+				d.px = fractions[j] * m.px + random.Gaus(0, 0.1);
+				d.py = fractions[j] * m.py + random.Gaus(0, 0.1);
+				d.pz = fractions[j] * m.pz + random.Gaus(0, 0.3);
+				d.m = daughterMasses[j];
+				d.chg = (daughterPdg[j] > 0) ? 1 : -1;
+				d.pdg = daughterPdg[j];
+			}
+			m.chg = 1;
+			m.pdg = 411;
+			for (int j = 0; j < nDInfoParticles; j++) {
+				properties & p = container.*DInfoParticles[j];
+				p.pt = std::sqrt(p.px * p.px + p.py * p.py);
+				p.p = std::sqrt(p.pt * p.pt + p.pz * p.pz);
+				p.E = std::sqrt(p.p * p.p + p.m * p.m);
+			}
+			tree->Fill();
+		}
+		tree->Write();
+		file.Close();
+		if (previousDirectory) previousDirectory->cd();
+		FileStat_t fileStat;
+		return (gSystem->GetPathInfo(fileName, fileStat) == 0) ? fileStat.fSize : 0;
+	}
+	/**
+	 * @brief Writes a random tree ensemble model (see cuts::treeEnsemble) with complete trees on six D variables
+	 * 
+	 * @param fileName Model file to write
+	 * @param nTrees Number of trees
+	 * @param depth Depth of every tree
+	 * @param seed Seed of the random generator
+	 */
+	void writeEnsembleModel(TString fileName, int nTrees = 300, int depth = 6, unsigned int seed = 4357) {
+		TRandom3 random(seed);
+		const char * variables[6] = {"Dpt", "Dm", "Dp", "Dd0pt", "Dd1pt", "Dd2pt"};
+		const double lower[6] = {0, 1.7, 0, 0, 0, 0}, upper[6] = {8, 2.05, 25, 4, 3, 3};
+		std::ofstream file(fileName.Data());
+		file << "baseString D" << std::endl;
+		for (int i = 0; i < 6; i++) file << "variable " << variables[i] << std::endl;
+		file << "objective binary:logistic" << std::endl;
+		for (int iTree = 0; iTree < nTrees; iTree++) {
+			file << "booster[" << iTree << "]:" << std::endl;
+			for (int id = 0; id < (1 << (depth + 1)) - 1; id++) {
+				if (id >= (1 << depth) - 1) {
+					file << id << ":leaf=" << random.Gaus(0, 0.1) << std::endl;
+				} else {
+					int feature = random.Integer(6);
+					file << id << ":[f" << feature << "<" << random.Uniform(lower[feature], upper[feature]) << "] yes=" << 2 * id + 1 << ",no=" << 2 * id + 2 << ",missing=" << 2 * id + 1 << std::endl;
+				}
+			}
+		}
+	}
+	/**
+	 * @brief Synthetic signal and background samples, each split into several files with a file list for treeFromMultipleFiles()
+	 */
+	struct sample {
+		TString directory; ///< Directory of all files, ending with /
+		TString treeName; ///< Name of the trees
+		TString baseString; ///< Prefix of the branches
+		Long64_t nEntries; ///< Entries per sample (signal or background)
+		Long64_t bytes[2]; ///< Size of all files of signal, background
+		TString fileList[2]; ///< File lists of signal, background
+
+		/**
+		 * @brief Generates the samples, unless they already exist with the same size
+		 *
+		 * @param directory Directory to put the files into
+		 * @param nEntries Entries of signal and of background
+		 * @param nFiles Number of files per sample
+		 */
+		sample(TString directory = "benchmarkData/", Long64_t nEntries = 200000, int nFiles = 4) : directory(directory), treeName("DInfo"), baseString("D"), nEntries(nEntries) {
+			gSystem->mkdir(directory, kTRUE);
+			const char * kinds[2] = {"sig", "bkg"};
+			for (int k = 0; k < 2; k++) {
+				bytes[k] = 0;
+				fileList[k] = directory + TString::Format("%s_%lld.txt", kinds[k], nEntries);
+				std::ofstream list(fileList[k].Data());
+				for (int iFile = 0; iFile < nFiles; iFile++) {
+					TString fileName = directory + TString::Format("%s_%lld_%d.root", kinds[k], nEntries, iFile);
+					FileStat_t fileStat;
+					if (gSystem->GetPathInfo(fileName, fileStat) == 0) {
+						bytes[k] += fileStat.fSize;
+					} else {
+						Long64_t first = nEntries * iFile / nFiles, last = nEntries * (iFile + 1) / nFiles;
+						bytes[k] += generateTree(fileName, treeName, baseString, last - first, k == 0, 1000 * k + iFile + 1);
+					}
+					list << fileName << std::endl;
+				}
+			}
+		}
+		/**
+		 * @brief Chain of signal (0) or background (1), owned by the caller
+		 */
+		TTree * tree(int kind) const {
+			return treeFromMultipleFiles(treeName, fileList[kind]);
+		}
+	};
+	/**
+	 * @}
+	 */
+	/**
+	 * @name Benchmarks of common.cpp
+	 * @{
+	 */
+	/**
+	 * @brief Reads all entries of the chained signal sample, once with all branches, once with only the mother mass bound via setBranchAddresses() and the others pruned
+	 */
+	void reading(const sample & s) {
+		TTree * tree = s.tree(0);
+		TStopwatch watch;
+		Long64_t nBytes = 0;
+		for (Long64_t i = 0; i < tree->GetEntries(); i++) nBytes += tree->GetEntry(i);
+		watch.Stop();
+		report("treeFromMultipleFiles_GetEntry_all", watch.RealTime(), tree->GetEntries(), nBytes);
+		delete tree;
+
+		for (int pruned = 0; pruned < 2; pruned++) {
+			tree = s.tree(0);
+			DInfoContainer container;
+			double sum = 0;
+			watch.Start();
+			setBranchAddresses(tree, container, s.baseString, pruned == 0, pruned ? kFieldM : kFieldsAll, pruned == 1);
+			nBytes = 0;
+			for (Long64_t i = 0; i < tree->GetEntries(); i++) {
+				nBytes += tree->GetEntry(i);
+				sum += container.m.m;
+			}
+			watch.Stop();
+			report(pruned ? "setBranchAddresses_pruned_mass" : "setBranchAddresses_all", watch.RealTime(), tree->GetEntries(), nBytes);
+			delete tree;
+		}
+	}
+	/**
+	 * @brief Runs the cut benchmarks with 100 steps in the mother pt, classic (two TTree::GetEntries() per step) and single pass, and the symmetric one in the mass, the adaptive search, the quick look and a compiled cut; then scans with a preselection, with and without enablePreselectionCache()
+	 */
+	void cutBenchmarks(const sample & s) {
+		TTree * treeSig = s.tree(0);
+		TTree * treeBkg = s.tree(1);
+		std::vector<double> steps;
+		for (int i = 0; i < 100; i++) steps.push_back(i * 0.05);
+		for (int singlePass = 0; singlePass < 2; singlePass++) {
+			double bestRatio = 0;
+			TStopwatch watch;
+			TGraph * graph = cuts::cutBenchmark(treeSig, treeBkg, 1., s.baseString + "pt", "", steps, bestRatio, singlePass);
+			watch.Stop();
+			report(singlePass ? "cutBenchmark_singlePass" : "cutBenchmark", watch.RealTime(), treeSig->GetEntries() + treeBkg->GetEntries());
+			delete graph;
+		}
+		for (int singlePass = 0; singlePass < 2; singlePass++) {
+			double lower = 0, upper = 0;
+			TStopwatch watch;
+			TGraph * graph = cuts::cutBenchmarkSymmetric(treeSig, treeBkg, 1., s.baseString + "m", "", 1.8696, 0.1, 50, lower, upper, singlePass);
+			watch.Stop();
+			report(singlePass ? "cutBenchmarkSymmetric_singlePass" : "cutBenchmarkSymmetric", watch.RealTime(), treeSig->GetEntries() + treeBkg->GetEntries());
+			delete graph;
+		}
+		// adaptive search to the resolution of the 100 steps above
+		double bestAdaptive = 0;
+		TStopwatch watchAdaptive;
+		delete cuts::cutBenchmarkAdaptive(treeSig, treeBkg, 1., s.baseString + "pt", "", std::make_pair(0., 4.95), 0.05, bestAdaptive);
+		watchAdaptive.Stop();
+		report("cutBenchmarkAdaptive", watchAdaptive.RealTime(), treeSig->GetEntries() + treeBkg->GetEntries());
+		// quick look on samples of 20000 entries per tree
+		TStopwatch watchQuickLook;
+		cuts::quickLookResult quickLook = cuts::cutBenchmarkQuickLook(treeSig, treeBkg, 1., s.baseString + "pt", "", steps, 20000);
+		watchQuickLook.Stop();
+		report("cutBenchmarkQuickLook", watchQuickLook.RealTime(), quickLook.sampleSize[0] + quickLook.sampleSize[1]);
+		delete quickLook.estimate;
+		// compiled cut on the columns, instead of a new TTreeFormula per step
+		cuts::compiledCut compiled(s.baseString + "pt > [0]", s.baseString);
+		double bestCompiled = 0;
+		TStopwatch watchCompiled;
+		delete cuts::cutBenchmark(treeSig, treeBkg, 1., compiled, steps, bestCompiled);
+		watchCompiled.Stop();
+		report("cutBenchmark_compiled", watchCompiled.RealTime(), treeSig->GetEntries() + treeBkg->GetEntries());
+		// the same preselection for scans of two quantities, evaluated every step or once per tree
+		TCut preselection = TString::Format("%spt > 1 && %sm > 1.75", s.baseString.Data(), s.baseString.Data()).Data();
+		for (int cached = 0; cached < 2; cached++) {
+			enablePreselectionCache(cached);
+			double bestRatio = 0;
+			TStopwatch watch;
+			delete cuts::cutBenchmark(treeSig, treeBkg, 1., s.baseString + "pt", preselection, steps, bestRatio);
+			delete cuts::cutBenchmark(treeSig, treeBkg, 1., s.baseString + "p", preselection, steps, bestRatio);
+			watch.Stop();
+			report(cached ? "cutBenchmark_preselection_cached" : "cutBenchmark_preselection", watch.RealTime(), 2 * (treeSig->GetEntries() + treeBkg->GetEntries()));
+		}
+		enablePreselectionCache(false);
+		preselections().clear();
+		delete treeSig;
+		delete treeBkg;
+	}
+	/**
+	 * @brief Times the fit helpers on the reference histograms of doubleGaussHistograms()
+	 */
+	void fits(int nHistograms = 200) {
+		std::vector<TH1*> histograms = doubleGaussHistograms(nHistograms);
+		TStopwatch watch;
+		for (unsigned int i = 0; i < histograms.size(); i++) gaussFit(histograms[i]);  // function owned by the histogram
+		watch.Stop();
+		report("gaussFit", watch.RealTime(), 0, 0, histograms.size());
+		watch.Start();
+		for (unsigned int i = 0; i < histograms.size(); i++) doubleGaussFitPrefitted(histograms[i]);
+		watch.Stop();
+		report("doubleGaussFitPrefitted", watch.RealTime(), 0, 0, histograms.size());
+		watch.Start();
+		for (unsigned int i = 0; i < histograms.size(); i++) doubleGaussFitNonZero(histograms[i]);  // function owned by the histogram
+		watch.Stop();
+		report("doubleGaussFitNonZero", watch.RealTime(), 0, 0, histograms.size());
+		watch.Start();
+		for (unsigned int i = 0; i < histograms.size(); i++) doubleGaussFitSeeded(histograms[i]);
+		watch.Stop();
+		report("doubleGaussFitSeeded", watch.RealTime(), 0, 0, histograms.size());
+		int fitTypes[2] = {kFitDoubleGauss, kFitDoubleGaussSeeded};
+		const char * names[2] = {"fitHistograms_doubleGauss", "fitHistograms_doubleGaussSeeded"};
+		for (int t = 0; t < 2; t++) {
+			watch.Start();
+			fitHistograms(histograms, fitTypes[t]);
+			watch.Stop();
+			report(names[t], watch.RealTime(), 0, 0, histograms.size());
+		}
+		for (unsigned int i = 0; i < histograms.size(); i++) delete histograms[i];
+	}
+	/**
+	 * @brief Scores the signal sample with a random tree ensemble (writeEnsembleModel()) and scans thresholds on the score
+	 */
+	void ensemble(const sample & s) {
+		TString modelFile = s.directory + "ensemble.txt";
+		writeEnsembleModel(modelFile);
+		cuts::treeEnsemble model(modelFile);
+		TTree * treeSig = s.tree(0);
+		TTree * treeBkg = s.tree(1);
+		DColumnStore store;
+		loadColumns(treeSig, store, s.baseString, true, model.fieldMask);
+		TStopwatch watch;
+		std::vector<Float_t> scores = cuts::ensembleScores(store, model);
+		watch.Stop();
+		report(TString::Format("ensembleScores_%dtrees", model.nTrees()), watch.RealTime(), scores.size());
+		std::vector<double> steps;
+		for (int i = 0; i < 100; i++) steps.push_back(i * 0.01);
+		double bestRatio = 0;
+		watch.Start();
+		delete cuts::cutBenchmark(treeSig, treeBkg, 1., model, steps, bestRatio);
+		watch.Stop();
+		report("cutBenchmark_ensemble", watch.RealTime(), treeSig->GetEntries() + treeBkg->GetEntries());
+		delete treeSig;
+		delete treeBkg;
+	}
+	/**
+	 * @brief Saves canvases of the reference histograms with saveCanvas(), directly and with enableAsyncExport()
+	 */
+	void canvasExport(const sample & s, int nCanvases = 20) {
+		std::vector<TH1*> histograms = doubleGaussHistograms(nCanvases, 2000);
+		for (int async = 0; async < 2; async++) {
+			enableAsyncExport(async);
+			TStopwatch watch;
+			for (int i = 0; i < nCanvases; i++) {
+				TCanvas * c = new TCanvas(TString::Format("cBenchmark%d", i), TString::Format("benchmark%d", i), 0, 0, 800, 500);
+				histograms[i]->Draw("HIST");
+				saveCanvas(c, s.directory + (async ? "async" : "direct"), false);
+				delete c;
+			}
+			flushExports();
+			watch.Stop();
+			report(async ? "saveCanvas_async" : "saveCanvas", watch.RealTime(), nCanvases);
+		}
+		enableAsyncExport(false);
+		for (int i = 0; i < nCanvases; i++) delete histograms[i];
+	}
+	/**
+	 * @}
+	 */
+}
+}
+
+/**
+ * @brief Runs all benchmarks
+ * @details Generates the synthetic samples on first use (in benchmarkData/), everything runs offline.
+ *
+ * @param nEntries Entries of the signal and of the background sample
+ * @param outputFile File to append the results to, one JSON object per line; only printed if empty
+ */
+void benchmark(Long64_t nEntries = 200000, TString outputFile = "") {
+	andi::benchmark::reportFileName() = outputFile;
+	andi::benchmark::sample s("benchmarkData/", nEntries);
+	andi::benchmark::reading(s);
+	andi::benchmark::cutBenchmarks(s);
+	andi::benchmark::fits();
+	andi::benchmark::fitSeeding();
+	andi::benchmark::unbinnedFit();
+	andi::benchmark::ensemble(s);
+	andi::benchmark::canvasExport(s);
+}
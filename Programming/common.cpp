@@ -9,55 +9,219 @@
  *
  * Although they are intended to be used from ROOT macros, they included the `#include`s to let it compile as well.
  * 
- * If you want to use the methods as well from ROOT's command line, make sure to include this file in your `~/.rootrc` file with
+ * If you want to use the methods as well from ROOT's command line, build the library with `make` (see Makefile) and load it through `loadAndiCommon.C` in your `~/.rootrc` file with
  * ~~~
- * Rint.Load: ~/Documents/Coding/PhysicsAnalysis/common.cpp
+ * Rint.Load: ~/Documents/Coding/PhysicsAnalysis/loadAndiCommon.C
  * ~~~
+ * Without the library, loadAndiCommon.C falls back to interpreting this file, which is much slower to start.
  * See also [this link](https://github.com/AndiH/PhD/blob/master/Programming/.rootrc).
  *
- * Most of the content is put into a namespace, see @ref andi.
+ * Most of the content is put into a namespace, see @ref andi. The declarations are in common.h, which is what compiled code includes (linking against libAndiCommon, see Makefile); this file holds the definitions.
  *
  * Use at own risk, participation welcome. 
  * -Andreas
  */
 
-#include "TROOT.h"
-#include "TSystem.h"
-#include "TStyle.h"
-#include "TTree.h"
+#ifndef ANDI_COMMON_CPP
+#define ANDI_COMMON_CPP
 
-#include "TCanvas.h"
-#include "TPad.h"
+#include "common.h"
+#include "tableau_colors.cpp"
 
-#include "TLegend.h"
-#include "TPaveText.h"
-#include "TPaveStats.h"
-#include "TPaletteAxis.h"
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+// Vector instructions for the batch kinematics and unbinned fits; only when compiled, define ANDI_NO_SIMD to switch them off
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(__CLING__) && !defined(ANDI_NO_SIMD)
+#define ANDI_SIMD_X86 1
+#include <immintrin.h>
+#endif
 
-#include "TH1.h"
-#include "TH2.h"
-#include "THStack.h"
-#include "TF1.h"
-#include "tableau_colors.cpp"
 
-/**
- * @namespace andi A namespace to structure my things better
- */
 namespace andi {
 	// some constants
-	double crossSig = 0.1; ///< Signal cross section, in mu barn
-	double crossBkg = 45737; ///< Background cross section, in mu barn
-	double brSig = 0.0931; ///< Brancing ratio D --> K π π 
-	/**
-	 * @brief Set my custom ROOT canvas style
-	 * @details Gets rid of the margins and sets some other stuff
-	 */
-	void setCustomStyle(bool showStats = true) {
+	double crossSig = 0.1;
+	double crossBkg = 45737;
+	double brSig = 0.0931;
+
+	// Threads
+	int numberOfThreads(int nThreads) {
+		if (nThreads > 0) return nThreads;
+		int nCores = std::thread::hardware_concurrency();
+		return (nCores > 0) ? nCores : 1;
+	}
+
+	void runInThreads(int nThreads, const std::function<void(int)> & work) {
+		if (nThreads <= 1) {
+			work(0);
+			return;
+		}
+		std::vector<std::thread> threads;
+		for (int iThread = 0; iThread < nThreads; iThread++) threads.push_back(std::thread(work, iThread));
+		for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+	}
+
+	std::pair<Long64_t, Long64_t> threadRange(Long64_t nItems, int iThread, int nThreads) {
+		return std::make_pair(nItems * iThread / nThreads, nItems * (iThread + 1) / nThreads);
+	}
+
+	threadPool::threadPool(int nThreads) : job(0), generation(0), nBusy(0), stopping(false) {
+		for (int iThread = 1; iThread < nThreads; iThread++) workers.push_back(std::thread(&threadPool::loop, this, iThread));
+	}
+
+	threadPool::~threadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+	}
+
+	void threadPool::run(const std::function<void(int)> & work) {
+		if (workers.empty()) {
+			work(0);
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = &work;
+			nBusy = workers.size();
+			generation++;
+		}
+		wake.notify_all();
+		work(0);
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this] { return nBusy == 0; });
+	}
+
+	void threadPool::loop(int iThread) {
+		unsigned long seen = 0;
+		while (true) {
+			const std::function<void(int)> * current;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&] { return stopping || generation != seen; });
+				if (stopping) return;
+				seen = generation;
+				current = job;
+			}
+			(*current)(iThread);
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--nBusy == 0) done.notify_one();
+		}
+	}
+
+	// Instrumentation
+	instrumentation::~instrumentation() {
+		if (enabled && reportAtExit) {
+			report();
+			if (jsonFileName != "") writeJson(jsonFileName);
+		}
+	}
+
+	void instrumentation::addTime(const std::string & timer, double wallTime) {
+		std::lock_guard<std::mutex> lock(mutex);
+		seconds[timer] += wallTime;
+		calls[timer]++;
+	}
+
+	void instrumentation::count(const std::string & counter, double value) {
+		if (!enabled) return;
+		std::lock_guard<std::mutex> lock(mutex);
+		counters[counter] += value;
+	}
+
+	void instrumentation::reset() {
+		std::lock_guard<std::mutex> lock(mutex);
+		seconds.clear();
+		calls.clear();
+		counters.clear();
+	}
+
+	void instrumentation::report(std::ostream & out) {
+		std::lock_guard<std::mutex> lock(mutex);
+		std::vector<std::pair<double, std::string> > sorted;
+		for (std::map<std::string, double>::iterator it = seconds.begin(); it != seconds.end(); ++it) sorted.push_back(std::make_pair(it->second, it->first));
+		std::sort(sorted.rbegin(), sorted.rend());
+		out << "andi instrumentation report" << std::endl;
+		for (size_t i = 0; i < sorted.size(); i++) out << TString::Format("  %-40s %10lld calls %12.3f s", sorted[i].second.c_str(), calls[sorted[i].second], sorted[i].first) << std::endl;
+		for (std::map<std::string, double>::iterator it = counters.begin(); it != counters.end(); ++it) out << TString::Format("  %-40s %18.0f", it->first.c_str(), it->second) << std::endl;
+	}
+
+	bool instrumentation::writeJson(TString fileName) {
+		std::lock_guard<std::mutex> lock(mutex);
+		std::ofstream file(fileName.Data());
+		if (!file) return false;
+		file << "{\"timers\": {";
+		for (std::map<std::string, double>::iterator it = seconds.begin(); it != seconds.end(); ++it) {
+			file << ((it == seconds.begin()) ? "" : ", ") << "\"" << it->first << "\": {\"calls\": " << calls[it->first] << ", \"seconds\": " << it->second << "}";
+		}
+		file << "}, \"counters\": {";
+		for (std::map<std::string, double>::iterator it = counters.begin(); it != counters.end(); ++it) {
+			file << ((it == counters.begin()) ? "" : ", ") << "\"" << it->first << "\": " << std::fixed << it->second;
+		}
+		file << "}}" << std::endl;
+		return true;
+	}
+
+	instrumentation & instruments() {
+		static instrumentation instance;
+		return instance;
+	}
+
+	scopedTimer::scopedTimer(const char * name) : name(name), running(instruments().enabled) {
+		if (running) start = std::chrono::steady_clock::now();
+	}
+
+	scopedTimer::~scopedTimer() {
+		if (running) instruments().addTime(name, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	scopedTreeStats::scopedTreeStats(TTree * tree) : tree(tree), running(instruments().enabled && tree), stats(0), previousStats(0), bytesBefore(0), readCallsBefore(0) {
+		if (!running) return;
+		bytesBefore = TFile::GetFileBytesRead();
+		readCallsBefore = TFile::GetFileReadCalls();
+		if (tree->InheritsFrom("TChain")) return;
+		previousStats = tree->GetPerfStats();
+		stats = new TTreePerfStats("andiPerfStats", tree);
+	}
+
+	scopedTreeStats::~scopedTreeStats() {
+		if (!running) return;
+		instruments().count("bytes read", TFile::GetFileBytesRead() - bytesBefore);
+		instruments().count("read calls", TFile::GetFileReadCalls() - readCallsBefore);
+		if (!stats) return;
+		// the unzip counters are summed up on every unzipped basket, no TTreePerfStats::Finish() needed
+		instruments().count("unzip seconds", stats->GetUnzipTime());
+		instruments().count("bytes unzipped", stats->GetUnzipInputSize());
+		instruments().count("bytes decompressed", stats->GetUnzipObjSize());
+		tree->SetPerfStats(previousStats);
+		delete stats;
+	}
+
+	void enableInstrumentation(bool enable, bool trace, bool reportAtExit, TString jsonFileName) {
+		instrumentation & i = instruments();
+		i.reset();
+		i.enabled = enable;
+		i.trace = trace;
+		i.reportAtExit = reportAtExit;
+		i.jsonFileName = jsonFileName;
+	}
+
+	void instrumentationReport(TString jsonFileName) {
+		instruments().report();
+		if (jsonFileName != "" && !instruments().writeJson(jsonFileName)) std::cerr << "andi::instrumentationReport: Could not write " << jsonFileName << std::endl;
+	}
+
+	void setCustomStyle(bool showStats) {
 		TStyle* customStyle = new TStyle("customStyle", "customStyle"); 
 		// TStyle * plainStyle = gROOT->GetStyle("Plain");
 		// TStyle * customStyle = new TStyle(*plainStyle); 
 		// customStyle->SetName("customStyle");
-
 		// Normalize
 		customStyle->SetOptStat(0);  // Don't display statbox
 		customStyle->SetOptDate(0);  // Don't display any date anywhere
@@ -121,75 +285,34 @@ namespace andi {
 		gROOT->SetStyle("customStyle");
 	}
 
-	/**
-	 * @name MoveLeft
-	 * Methods for moving a box on the canvas **to the left**.
-	 * @{
-	 */
-	/**
-	 * @brief Abstract method for moving any TPave left
-	 * @details Is used by moveStatBoxLeft() and moveZAxisLeft() to move stuff left
-	 * 
-	 * @param pave Pointer to TPave to be moved
-	 * @param moveToLeft Value, the box should be moved left. In NDC.
-	 */
-	void moveTPaveLeft(TPave * pave, float moveToLeft = 0) {
+	// MoveLeft
+	void moveTPaveLeft(TPave * pave, float moveToLeft) {
 		// gPad->Update();
 		float oldValue1 = pave->GetX1NDC();
 		float oldValue2 = pave->GetX2NDC();
 		pave->SetX1NDC(oldValue1 - moveToLeft);
 		pave->SetX2NDC(oldValue2 - moveToLeft);
 	}
-	/**
-	 * @brief Moves a statbox to the left
-	 * 
-	 * @param hist Pointer to histogram with statbox inside
-	 * @param moveToLeft Percentage of how much to move it left. Negative numbers to move it right.
-	 */
-	void moveStatBoxLeft(TH1 * hist, float moveToLeft = 0) {
+
+	void moveStatBoxLeft(TH1 * hist, float moveToLeft) {
 		TPaveStats * stats = (TPaveStats *)hist->GetListOfFunctions()->FindObject("stats");
 		if (stats != NULL) moveTPaveLeft((TPave *)stats, moveToLeft);
 	}
-	/**
-	 * @brief Moves a Z axis left
-	 * @details Ever got the problem that your z axis is too far to the right so that the numbers are not displayed correctly? Fear not, for there is this method.
-	 * 
-	 * @param hist Point to histogram containing Z axis. It's a TH2 as only those should have a z axis
-	 * @param moveToLeft The amount to be moved left. In NDC.
-	 */
-	void moveZAxisLeft(TH2 * hist, float moveToLeft = 0) {
+
+	void moveZAxisLeft(TH2 * hist, float moveToLeft) {
 		TPaletteAxis * axis = (TPaletteAxis *)hist->GetListOfFunctions()->FindObject("palette");
 		moveTPaveLeft((TPave *)axis, moveToLeft);
 	}
-	/**
-	 *@}
-	 */
 
-	/**
-	 * @name MoveDown
-	 * Methods for moving a box on the canvas **down**.
-	 * @{
-	 */
-	/**
-	 * @brief Abstract method for moving any TPave down
-	 * @details Is used by moveStatBoxDown() to move stuff down
-	 * 
-	 * @param pave Pointer to TPave to be moved
-	 * @param moveDown Value, the box should be moved down. In NDC.
-	 */
-	void moveTPaveDown(TPave * pave, float moveDown = 0) {
+	// MoveDown
+	void moveTPaveDown(TPave * pave, float moveDown) {
 		float oldValue1 = pave->GetY1NDC();
 		float oldValue2 = pave->GetY2NDC();
 		pave->SetY1NDC(oldValue1 - moveDown);
 		pave->SetY2NDC(oldValue2 - moveDown);
 	}
-	/**
-	 * @brief Moves a statbox down
-	 * 
-	 * @param hist Pointer to histogram with statbox inside
-	 * @param moveDown Percentage of how much to move the statbox down. Negative values to move it up.
-	 */
-	void moveStatBoxDown(TH1 * hist, float moveDown = 0) {
+
+	void moveStatBoxDown(TH1 * hist, float moveDown) {
 		TPaveStats * stats = (TPaveStats *)hist->GetListOfFunctions()->FindObject("stats");
 		moveTPaveDown((TPave*) stats, moveDown);
 		// float oldValue1 = stats->GetY1NDC();
@@ -197,22 +320,8 @@ namespace andi {
 		// stats->SetY1NDC(oldValue1 - moveDown);
 		// stats->SetY2NDC(oldValue2 - moveDown);
 	}
-	/**
-	 * @}
-	 */
 
-	/**
-	 * @name ShrinkBox
-	 * Methods for shrinking a box.
-	 * @{
-	 */
-	/**
-	 * @brief Abstract class for shrinking boxes
-	 * @details Shrinks boxes by manipulating the lower left corner. Is used by shrinkStatBox().
-	 * 
-	 * @param box A TPave box.
-	 * @param xShrinkFactor The shrinkage factor.
-	 */
+	// ShrinkBox
 	void shrinkBox(TPave * box, float xShrinkFactor) {
 		float length = box->GetX2NDC() - box->GetX1NDC();
 		float height = box->GetY2NDC() - box->GetY1NDC();
@@ -225,38 +334,15 @@ namespace andi {
 		box->SetY1NDC(newY1);
 		box->SetX1NDC(newX1);
 	}
-	/**
-	 * @brief Shrinks a statbox, keeping its aspect ratio. length_new = factor * length_old.
-	 * @details Shrinks both the width as well as the height to factor*oldvalue. So, e.g., use 0.8 to shrink your statbox to a 80% side length in relation to the original side length.
-	 * 
-	 * @param hist Histogram containing the statbox
-	 * @param xShrinkFactor Factor of shrinkage: length_new = factor * length_old
-	 */
+
 	void shrinkStatBox(TH1 * hist, float xShrinkFactor) {
 		TPaveStats * stats = (TPaveStats *)hist->GetListOfFunctions()->FindObject("stats");
 		shrinkBox(stats, xShrinkFactor);
 
 	}
-	/**
-	 * @}
-	 */
 
-	/**
-	 * @name Pad Titles
-	 * @{
-	 */
-	/**
-	 * @brief Create a box with the TObject's title
-	 * @details Puts the title of a histogram into a box, formats it and returns it.
-	 *
-	 * The box is placed on top of the histogram, at the usual position.
-	 * 
-	 * @param hist Pointer to histogram with title info inside
-	 * @param rightBorder Right border of where the box should end
-	 * 
-	 * @return pointer to a TPaveText
-	 */
-	TPaveText * makePadTitle(TObject * obj, double rightBorder = 0.96) {
+	// Pad Titles
+	TPaveText * makePadTitle(TObject * obj, double rightBorder) {
 		// canvas->SetTopMargin(0.075);
 		TPaveText *pt = new TPaveText(0.16, 0.932, rightBorder, 0.99, "NDC");
 		TString objName(obj->GetName()), objTitle(obj->GetTitle());
@@ -269,24 +355,11 @@ namespace andi {
 		return pt;
 	}
 
-	/**
-	 * @brief Draws an objects's title at default position. Convenience function for makePadTitle().
-	 * 
-	 * @param hist Pointer to TObject (e.g. TH1)
-	 */
 	void makePadTitleAndDraw(TObject * obj) {
 		TPaveText *pt = makePadTitle(obj);
 		pt->Draw();
 	}
-	/**
-	 * @brief Draws a **2D** histogram's title at default position
-	 * @details Draws title and also moves the right pad's border a bit to the left to make space for z axis.
-	 *
-	 * You probably need to cast your pad to a `(TPad *)` - the last argument. E.g. `(TPad *) c1->GetPad(0)`.
-	 * 
-	 * @param hist Pointer to histogram (2D)
-	 * @param canvas Pointer to canvas where it's drawn upon, needed for margin movement
-	 */
+
 	void makePadTitleAndDraw(TH2 * hist, TPad * pad) {  // You probably need to cast your pad to (TPad *), because they usually return a more abstract TVirtualPad
 		pad->SetRightMargin(0.08);
 		gPad->Update();
@@ -298,13 +371,7 @@ namespace andi {
 
 		pt->Draw();
 	}
-	/**
-	 * @brief Draws a histogram's title at default position and moves statbox and z axis for **LARGE** datasets (= long numbers on Z)
-	 * @details Draws title and moves pad's right margin, the statbox and the z axis to the left. For large datasets, where the numbers on z have four (five?) digits.
-	 * 
-	 * @param hist Pointer to histogram (2D)
-	 * @param canvas Pointer to canvas where it's drawn upon, needed for margin movement (probably something like `(TPad*)c1->GetPad(0))`
-	 */
+
 	void makePadTitleAndDrawLarge(TH2 * hist, TPad * pad) {
 		pad->SetRightMargin(0.15);
 		gPad->Update();
@@ -314,66 +381,290 @@ namespace andi {
 		andi::shrinkStatBox((TH1*)hist, 0.8);
 		gPad->Update();
 	}
-	/**
-	 * @}
-	 */
-	/**
-	 * @name Saving of Canvas
-	 * @{
-	 */
-	/**
-	 * @brief Saves a canvas in three vector image formats plus root file
-	 * @details Creates four files for a given canvas: SVG, PDF, EPS - and ROOT.
-	 * 
-	 * @param canvas Pointer to canvas as it should be saved (everything drawn already)
-	 * @param name The file name with which the files are saved
-	 */
+
+	// Saving of Canvas
 	void saveCanvas_allFileNames(TCanvas * canvas, TString name) {
-		canvas->SaveAs(name + ".pdf");
-		canvas->SaveAs(name + ".eps");
-		canvas->SaveAs(name + ".svg");
-		canvas->SaveAs(name + ".root");
+		const char * extensions[4] = {".pdf", ".eps", ".svg", ".root"};
+		const char * timers[4] = {"export .pdf", "export .eps", "export .svg", "export .root"};
+		for (int i = 0; i < 4; i++) {
+			scopedTimer timer(timers[i]);
+			canvas->SaveAs(name + extensions[i]);
+		}
+	}
+
+	exportQueue::exportQueue(int maxWorkers) : maxWorkers(numberOfThreads(maxWorkers)), nJobs(0), nFailed(0) {
+		formats.push_back(".pdf");
+		formats.push_back(".eps");
+		formats.push_back(".svg");
+	}
+
+	exportQueue::~exportQueue() {
+		flush();
+	}
+
+	void exportQueue::waitForWorkers(size_t maxRunning) {
+		while (workers.size() > maxRunning) {
+			int status = 0;
+			bool saved = (waitpid(workers.front(), &status, 0) >= 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+			if (!saved) nFailed++;
+			size_t iJob = workerJobs.front();
+			workers.erase(workers.begin());
+			workerJobs.erase(workerJobs.begin());
+			finishFile(iJob, saved);
+		}
+	}
+
+	void exportQueue::finishFile(size_t iJob, bool saved) {
+		std::map<size_t, job>::iterator it = jobs.find(iJob);
+		if (it == jobs.end()) return;
+		if (!saved) it->second.failed = true;
+		if (--it->second.nRunning > 0) return;
+		if (!it->second.failed && it->second.onSaved) it->second.onSaved();
+		jobs.erase(it);
+	}
+
+	int exportQueue::processThreads() {
+		std::ifstream status("/proc/self/status");
+		std::string key;
+		while (status >> key) {
+			int nThreads = 0;
+			if (key == "Threads:" && status >> nThreads) return nThreads;
+		}
+		return 0;
+	}
+
+	bool exportQueue::canFork() {
+		static bool warnedInteractive = false, warnedThreads = false;
+		if (!gROOT->IsBatch()) {
+			if (!warnedInteractive) std::cerr << "andi::exportQueue: Not in batch mode (root -b), saving all canvases directly" << std::endl;
+			warnedInteractive = true;
+			return false;
+		}
+		if (processThreads() > 1) {
+			if (!warnedThreads) std::cerr << "andi::exportQueue: Other threads are running, saving canvases directly while they do" << std::endl;
+			warnedThreads = true;
+			return false;
+		}
+		return true;
+	}
+
+	void exportQueue::add(TCanvas * canvas, TString name, TString rootFileName, TString key, const std::function<void()> & onSaved) {
+		size_t iJob = nJobs++;
+		job & thisJob = jobs[iJob];
+		thisJob.nRunning = 1;  // held until all workers are started, so waitForWorkers() cannot finish the job before
+		thisJob.failed = !writeToRootFile(canvas, rootFileName, key);
+		thisJob.onSaved = onSaved;
+		bool useWorkers = canFork();
+		for (size_t i = 0; i < formats.size(); i++) {
+			TString fileName = name + formats[i];
+			if (!useWorkers) {
+				canvas->SaveAs(fileName);
+				if (gSystem->AccessPathName(fileName)) thisJob.failed = true;
+				continue;
+			}
+			waitForWorkers(maxWorkers - 1);
+			std::cout.flush();
+			std::cerr.flush();
+			fflush(0);
+			pid_t pid = fork();
+			if (pid == 0) {
+				// worker: save and leave without any cleanup, which would e.g. close the ROOT files of the parent
+				canvas->SaveAs(fileName);
+				_exit(gSystem->AccessPathName(fileName) ? 1 : 0);
+			}
+			if (pid < 0) {
+				std::cerr << "andi::exportQueue::add: Could not start worker, saving " << fileName << " directly" << std::endl;
+				canvas->SaveAs(fileName);
+				if (gSystem->AccessPathName(fileName)) thisJob.failed = true;
+				continue;
+			}
+			workers.push_back(pid);
+			workerJobs.push_back(iJob);
+			thisJob.nRunning++;
+			instruments().count("export workers");
+		}
+		finishFile(iJob, true);
+	}
+
+	bool exportQueue::writeToRootFile(TCanvas * canvas, TString rootFileName, TString key) {
+		scopedTimer timer("export .root (queue)");
+		TDirectory * previousDirectory = gDirectory;
+		TFile * file = rootFiles[rootFileName];
+		if (!file) {
+			file = TFile::Open(rootFileName, "UPDATE");
+			rootFiles[rootFileName] = file;
+		}
+		bool opened = (file && !file->IsZombie());
+		if (opened) {
+			file->cd();
+			canvas->Write(key, TObject::kOverwrite);
+		} else {
+			std::cerr << "andi::exportQueue::writeToRootFile: Could not open " << rootFileName << std::endl;
+		}
+		if (previousDirectory) previousDirectory->cd();
+		return opened;
+	}
+
+	int exportQueue::flush() {
+		waitForWorkers(0);
+		for (std::map<TString, TFile*>::iterator it = rootFiles.begin(); it != rootFiles.end(); ++it) {
+			if (it->second) it->second->Close();
+			delete it->second;
+		}
+		rootFiles.clear();
+		int failed = nFailed;
+		if (failed > 0) std::cerr << "andi::exportQueue::flush: " << failed << " files could not be saved" << std::endl;
+		nFailed = 0;
+		return failed;
 	}
 	/**
-	 * @brief Saves a canvas in some file format at right location
-	 * @details Will, in default call, save every canvas in four file extensions in img/BASENAME/FILENAME.{svg,pdf,eps,root}
-	 * 
-	 * @param canvas The canvas as it should be saved
-	 * @param macroname A basenme, e.g. your macro name, to sort the images into folder
-	 * @param prefixImg Will create a img subdirectory in the current directory to put all the images in, if true.
+	 * @brief Owner of an object created on demand, which is deleted at the end of the job
+	 * @details For the global settings (e.g. activeExportQueue()): the destructor of the object does its last work then, like waiting for workers and closing files, even if the macro never calls the matching flush function. As a function-local static, the owner is destroyed before ROOT's own cleanup at exit.
 	 */
-	void saveCanvas(TCanvas * canvas, TString macroname, bool prefixImg = true) {
+	template <typename T>
+	struct globalOwner {
+		T * object;
+		globalOwner() : object(0) {}
+		~globalOwner() {
+			delete object;
+			object = 0;
+		}
+	};
+
+	exportQueue *& activeExportQueue() {
+		static globalOwner<exportQueue> owner;
+		return owner.object;
+	}
+
+	void enableAsyncExport(bool enable, int maxWorkers) {
+		exportQueue *& queue = activeExportQueue();
+		delete queue;
+		queue = enable ? new exportQueue(maxWorkers) : 0;
+	}
+
+	exportManifest::~exportManifest() {
+		flush();
+	}
+
+	TString exportManifest::manifestFileName(TString directory) {
+		return directory + ".exportManifest";
+	}
+
+	TString exportManifest::fingerprint(TCanvas * canvas) {
+		TBufferFile buffer(TBuffer::kWrite);
+		buffer.WriteObject(canvas);
+		buffer.WriteObject(gStyle);
+		TMD5 md5;
+		md5.Update((const UChar_t *) buffer.Buffer(), buffer.Length());
+		md5.Final();
+		return md5.AsString();
+	}
+
+	std::map<TString, TString> & exportManifest::directoryFingerprints(TString directory) {
+		if (fingerprints.find(directory) == fingerprints.end()) {
+			std::map<TString, TString> & entries = fingerprints[directory];
+			std::ifstream file(manifestFileName(directory).Data());
+			std::string hash, name;
+			while (file >> hash >> name) entries[name.c_str()] = hash.c_str();
+		}
+		return fingerprints[directory];
+	}
+
+	void exportManifest::write(TString directory) {
+		std::ofstream file(manifestFileName(directory).Data());
+		std::map<TString, TString> & entries = directoryFingerprints(directory);
+		for (std::map<TString, TString>::iterator it = entries.begin(); it != entries.end(); ++it) file << it->second << " " << it->first << std::endl;
+	}
+
+	void exportManifest::flush() {
+		if (exportQueue * queue = activeExportQueue()) queue->waitForWorkers(0);  // records the fingerprints of the canvases still being saved
+		for (std::set<TString>::iterator it = changed.begin(); it != changed.end(); ++it) write(*it);
+		changed.clear();
+	}
+
+	bool exportManifest::filesExist(TString directory, TString filename, const std::vector<TString> & extensions) {
+		for (size_t i = 0; i < extensions.size(); i++) {
+			if (gSystem->AccessPathName(directory + filename + extensions[i])) return false;
+		}
+		return true;
+	}
+
+	bool exportManifest::unchanged(TCanvas * canvas, TString directory, TString filename, const std::vector<TString> & extensions, TString & currentFingerprint) {
+		currentFingerprint = fingerprint(canvas);
+		std::map<TString, TString> & entries = directoryFingerprints(directory);
+		if (filesExist(directory, filename, extensions) && entries[filename] == currentFingerprint) {
+			nSkipped++;
+			instruments().count("export skipped (unchanged)");
+			return true;
+		}
+		return false;
+	}
+
+	void exportManifest::record(TString directory, TString filename, TString currentFingerprint) {
+		directoryFingerprints(directory)[filename] = currentFingerprint;
+		changed.insert(directory);
+	}
+
+	exportManifest *& activeExportManifest() {
+		activeExportQueue();  // the queue is created first and so deleted last, the manifest waits for its workers when deleted
+		static globalOwner<exportManifest> owner;
+		return owner.object;
+	}
+
+	void enableIncrementalExport(bool enable) {
+		exportManifest *& manifest = activeExportManifest();
+		if (manifest && manifest->nSkipped > 0) std::cout << "andi::enableIncrementalExport: " << manifest->nSkipped << " unchanged canvases were not saved again" << std::endl;
+		delete manifest;
+		manifest = enable ? new exportManifest() : 0;
+	}
+
+	int flushExports() {
+		exportQueue * queue = activeExportQueue();
+		if (activeExportManifest()) activeExportManifest()->flush();
+		return queue ? queue->flush() : 0;
+	}
+
+	void privateSaveCanvas(TCanvas * canvas, TString directory, TString filename, TString rootFileName) {
+		exportQueue * queue = activeExportQueue();
+		exportManifest * manifest = activeExportManifest();
+		std::vector<TString> extensions;
+		extensions.push_back(".pdf");
+		extensions.push_back(".eps");
+		extensions.push_back(".svg");
+		if (!queue) extensions.push_back(".root");
+		TString currentFingerprint;
+		if (manifest && manifest->unchanged(canvas, directory, filename, extensions, currentFingerprint)) return;
+		if (queue) {
+			std::function<void()> onSaved;
+			if (manifest) onSaved = [manifest, directory, filename, currentFingerprint]() { manifest->record(directory, filename, currentFingerprint); };
+			queue->add(canvas, directory + filename, rootFileName, filename, onSaved);
+		} else {
+			saveCanvas_allFileNames(canvas, directory + filename);
+			if (manifest && exportManifest::filesExist(directory, filename, extensions)) manifest->record(directory, filename, currentFingerprint);
+		}
+	}
+
+	void saveCanvas(TCanvas * canvas, TString macroname, bool prefixImg) {
+		scopedTimer timer("saveCanvas");
 		TString filename = canvas->GetTitle();
 		filename.ReplaceAll(" ", "_");
 		macroname.ReplaceAll(" ", "_");
 		TString basedir = macroname + "/";
 		if (prefixImg) basedir = "img/" + basedir;
 		gSystem->mkdir(basedir, kTRUE);
-		saveCanvas_allFileNames(canvas, basedir + filename);
+		privateSaveCanvas(canvas, basedir, filename, basedir + macroname + ".root");
 	}
-	/**
-	 * @brief Saves a canvas, no subdirectories; rest is equal as in saveCanvas()
-	 */
-	void saveCanvasFlat(TCanvas * canvas, TString macroPrefix = "") {
+
+	void saveCanvasFlat(TCanvas * canvas, TString macroPrefix) {
+		scopedTimer timer("saveCanvasFlat");
 		TString filename = canvas->GetTitle();
 		filename.ReplaceAll(" ", "_");
+		TString rootFileName = (macroPrefix != "") ? macroPrefix + ".root" : TString("canvases.root");
 		if (macroPrefix != "") filename = macroPrefix + "--" + filename;
-		saveCanvas_allFileNames(canvas, filename);
+		privateSaveCanvas(canvas, "", filename, rootFileName);
 	}
-	/**
-	 * @}
-	 */
-	/**
-	 * @brief Creates a legend at my favorite position, formats it
-	 * @details Just a wrapper around the TLegend constructor to already have it configured with text size, background color etc.
-	 * 
-	 * @param x1 Start point of box on x axis
-	 * @param y1 Start point of box on y axis
-	 * @param x2 End point of box on x axis
-	 * @param y2 End point of box on y axis
-	 * @return Pointer to the legend, ready to be filled
-	 */
-	TLegend * plainLegend(float x1 = 0.7, float y1 = 0.62, float x2 = 0.96, float y2 = 0.695) {
+
+	TLegend * plainLegend(float x1, float y1, float x2, float y2) {
 		TLegend * legend = new TLegend(x1, y1, x2, y2);
 		legend->SetFillColor(kWhite);
 		legend->SetTextSize(0.04);
@@ -381,30 +672,14 @@ namespace andi {
 		legend->SetBorderSize(1);
 		return legend;
 	}
-	/**
-	 * @name Stack helper functions
-	 * @details Working with > 1 histogram at a time can become very cumbersome, if you're not using them in a THStack.
-	 * These helper functions here should make it easy to handle the stacks.
-	 * @{
-	 */
-	/**
-	 * @brief Converts an array of histograms (as `TObjArray`) into a THStack
-	 * @details Gives the stack proper name, tile, and axes on the way, so it can be manipulated as a usual ROOT object (because usually, it can't, as the stuff is only defined after drawing).
-	 *
-	 * The histograms are provided as a list in `TObjArray` to be more flexible and not deal with the overhead of more-complex constructors. At least for the time being the flexibilty is not made use of since only TH1D are used.
-	 *
-	 * For ROOT to generate axes, the histogram first needs to be drawn. In theory, `"goff"` should not print the canvas on your screen. Instead, a kind of empty canvas is drawn.
-	 * 
-	 * @param histos TObjArray with histograms. Take care of the order!
-	 * @param stackAddOption Optional string which is used when stack->Add(hist, option)
-	 * @return THStack of histograms
-	 */
-	THStack * histogramsToStack(TObjArray * histos, TString stackAddOption = "") {
+
+	// Stack helper functions
+	THStack * histogramsToStack(TObjArray * histos, TString stackAddOption) {
 		bool useSafeButStupidMethod = true;
-		if (useSafeButStupidMethod) TCanvas cTemp;
+		TCanvas * cTemp = useSafeButStupidMethod ? new TCanvas() : 0;
 		THStack * myStack = new THStack();
 		int nHistograms = histos->GetEntries();
-		TH1D * firstHist;
+		TH1D * firstHist = 0;
 		for (int i = 0; i < nHistograms; i++) {
 			myStack->Add((TH1D*)(histos->At(i)), stackAddOption);
 			if (i == 0) firstHist = (TH1D*)(histos->At(0));
@@ -419,23 +694,14 @@ namespace andi {
 		myStack->GetXaxis()->SetTitle(firstHist->GetXaxis()->GetTitle());
 		myStack->GetYaxis()->SetTitle(firstHist->GetYaxis()->GetTitle());
 		
-		if (useSafeButStupidMethod) cTemp.Close();
+		if (cTemp) {
+			cTemp->Close();
+			delete cTemp;
+		}
 		return myStack;
 	}
 
-	/**
-	 * @brief Creates a legend for a stack
-	 * @details Make sure the histograms in the stack have proper and short titles, as those are used for the legend
-	 * 
-	 * @param stack A stack of histograms
-	 * @param header The header of the legend
-	 * @param height y lower position of box
-	 * @param width x lower position of box
-	 * @param y2 y upper position of box
-	 * 
-	 * @return A legend. Dont' forget to Draw()
-	 */
-	TLegend * stackLegend(THStack * stack, TString header = "Histograms", double height = 0.75, double width = 0.7, double y2 = 0.93) {
+	TLegend * stackLegend(THStack * stack, TString header, double height, double width, double y2) {
 		TLegend * tempLegend = andi::plainLegend(width, height, 0.96, y2);
 		tempLegend->SetHeader(header);
 		int nHists = stack->GetHists()->GetEntries();
@@ -447,27 +713,205 @@ namespace andi {
 
 		return tempLegend;
 	}
-	/**
-	 * @}
-	 */
 
-	/**
-	 * @name Gauss Fits
-	 * @details Helper functions for single and double Gauss fits.
-	 * @{
-	 */
-	/**
-	 * @brief Fits a Gaussian distribution to a histogram
-	 * @details Fits a Gaussian to the whole range of a histogram, formats the function and returns it. If verbose, it also prints out some information on it
-	 * 
-	 * @param hist Pointer to the histogram to fit the gaussian on
-	 * @param verbose If true, some output of the guassian fit is shown
-	 * 
-	 * @return Pointer to the function holding the fit, readily formatted
-	 */
-	TF1 * gaussFit(TH1 * hist, bool verbose = false) {
+	// Streaming statistics
+	void runningMoments::add(double x) {
+		n++;
+		double delta = x - mean;
+		mean += delta / n;
+		m2 += delta * (x - mean);
+		min = std::min(min, x);
+		max = std::max(max, x);
+	}
+
+	void runningMoments::merge(const runningMoments & other) {
+		if (other.n == 0) return;
+		double total = n + other.n;
+		double delta = other.mean - mean;
+		mean += delta * other.n / total;
+		m2 += other.m2 + delta * delta * n * other.n / total;
+		n = total;
+		min = std::min(min, other.min);
+		max = std::max(max, other.max);
+	}
+
+	size_t quantileSketch::capacity(size_t level) const {
+		return std::max(2, (int) std::ceil(k * std::pow(2. / 3., (double) (levels.size() - 1 - level))));
+	}
+
+	void quantileSketch::add(double x) {
+		levels[0].push_back(x);
+		n++;
+		if (levels[0].size() >= capacity(0)) compress();
+	}
+
+	void quantileSketch::compress() {
+		for (size_t h = 0; h < levels.size(); h++) {
+			if (levels[h].size() < capacity(h)) continue;
+			if (h + 1 == levels.size()) levels.push_back(std::vector<double>());
+			std::vector<double> & level = levels[h];
+			std::sort(level.begin(), level.end());
+			randomState ^= randomState << 13;
+			randomState ^= randomState >> 7;
+			randomState ^= randomState << 17;
+			size_t nCompacted = level.size() - level.size() % 2;  // with an odd number, the largest value stays
+			for (size_t i = randomState & 1; i < nCompacted; i += 2) levels[h + 1].push_back(level[i]);
+			level.erase(level.begin(), level.begin() + nCompacted);
+		}
+	}
+
+	void quantileSketch::merge(const quantileSketch & other) {
+		if (other.levels.size() > levels.size()) levels.resize(other.levels.size());
+		for (size_t h = 0; h < other.levels.size(); h++) levels[h].insert(levels[h].end(), other.levels[h].begin(), other.levels[h].end());
+		n += other.n;
+		compress();
+	}
+
+	std::vector<double> quantileSketch::quantiles(const std::vector<double> & probabilities) const {
+		std::vector<std::pair<double, double> > weighted;  // value, weight
+		for (size_t h = 0; h < levels.size(); h++) {
+			for (size_t i = 0; i < levels[h].size(); i++) weighted.push_back(std::make_pair(levels[h][i], std::ldexp(1., h)));
+		}
+		std::sort(weighted.begin(), weighted.end());
+		double totalWeight = 0;
+		for (size_t i = 0; i < weighted.size(); i++) totalWeight += weighted[i].second;
+		std::vector<double> results(probabilities.size(), NAN);
+		for (size_t j = 0; j < probabilities.size() && !weighted.empty(); j++) {
+			double target = probabilities[j] * totalWeight, cumulative = 0;
+			size_t i = 0;
+			for (; i + 1 < weighted.size(); i++) {
+				cumulative += weighted[i].second;
+				if (cumulative >= target) break;
+			}
+			results[j] = weighted[i].first;
+		}
+		return results;
+	}
+
+	double quantileSketch::quantile(double p) const {
+		return quantiles(std::vector<double>(1, p))[0];
+	}
+
+	void streamingStats::add(double x) {
+		if (!std::isfinite(x)) return;
+		moments.add(x);
+		sketch.add(x);
+	}
+
+	void streamingStats::merge(const streamingStats & other) {
+		moments.merge(other.moments);
+		sketch.merge(other.sketch);
+	}
+
+	double streamingStats::coreWidth() const {
+		std::vector<double> q = sketch.quantiles({0.308538, 0.691462});
+		return q[1] - q[0];
+	}
+
+	double streamingStats::tailWidth() const {
+		std::vector<double> q = sketch.quantiles({0.02275, 0.97725});
+		return (q[1] - q[0]) / 4;
+	}
+
+	std::pair<double, double> streamingStats::fitRange(double nTailWidths) const {
+		double c = center(), w = tailWidth();
+		return std::make_pair(std::max(c - nTailWidths * w, moments.min), std::min(c + nTailWidths * w, moments.max));
+	}
+
+	void streamingStats::doubleGaussParameters(double * parameters, double binWidth) const {
+		double c = center(), core = coreWidth(), tail = std::max(tailWidth(), 1.1 * core);
+		double fraction = (tail * tail - moments.variance()) / (tail * tail - core * core);
+		fraction = std::min(std::max(fraction, 0.3), 0.95);
+		parameters[0] = n() * fraction * binWidth / (core * std::sqrt(2 * M_PI));
+		parameters[1] = c;
+		parameters[2] = core;
+		parameters[3] = n() * (1 - fraction) * binWidth / (tail * std::sqrt(2 * M_PI));
+		parameters[4] = c;
+		parameters[5] = tail;
+	}
+
+	TH1D * streamingStats::bookHistogram(TString name, TString title, int maxBins, double coverage) const {
+		std::vector<double> q = sketch.quantiles({(1 - coverage) / 2, 0.25, 0.75, (1 + coverage) / 2});
+		double lower = q[0], upper = q[3];
+		if (!(upper > lower)) {
+			lower = (n() > 0) ? moments.mean - 1 : 0;
+			upper = lower + 2;
+		}
+		double margin = 0.05 * (upper - lower);
+		lower -= margin;
+		upper += margin;
+		double binWidth = 2 * (q[2] - q[1]) / std::cbrt(std::max(n(), 1.));
+		int nBins = (binWidth > 0) ? (int) std::ceil((upper - lower) / binWidth) : maxBins;
+		nBins = std::min(std::max(nBins, 10), maxBins);
+		return new TH1D(name, title, nBins, lower, upper);
+	}
+
+	// Gauss Fits
+	double gaussFunction(double * x, double * p) {
+		double arg = (p[2] != 0) ? (x[0] - p[1]) / p[2] : 0;
+		return p[0] * std::exp(-0.5 * arg * arg);
+	}
+
+	double doubleGaussFunction(double * x, double * p) {
+		return gaussFunction(x, p) + gaussFunction(x, p + 3);
+	}
+
+	double gaussExcludeCenterFunction(double * x, double * p) {
+		if (std::fabs(x[0]) <= p[4]) {
+			TF1::RejectPoint();
+			return 0;
+		}
+		return gaussFunction(x, p);
+	}
+
+	TF1 * privateFunction(TString name, double (*function)(double *, double *), int nParameters, double rangeStart, double rangeEnd) {
+		bool oldAddToGlobalList = TF1::DefaultAddToGlobalList(kFALSE);
+		TF1 * f = new TF1(name, function, rangeStart, rangeEnd, nParameters);
+		TF1::DefaultAddToGlobalList(oldAddToGlobalList);
+		return f;
+	}
+
+	TF1 * privateFunction(TString name, TString formula, double rangeStart, double rangeEnd) {
+		bool oldAddToGlobalList = TF1::DefaultAddToGlobalList(kFALSE);
+		TF1 * f = new TF1(name, formula, rangeStart, rangeEnd);
+		TF1::DefaultAddToGlobalList(oldAddToGlobalList);
+		return f;
+	}
+
+	fitWorkspace::fitWorkspace(TString suffix, bool useFormulas) {
+		if (useFormulas) {
+			pre1 = privateFunction("fitPre1" + suffix, "gaus");
+			pre2 = privateFunction("fitPre2" + suffix, "gaus");
+			single = privateFunction("fitSingle" + suffix, "gaus");
+			proper = privateFunction("fitProper" + suffix, "gaus(0)+gaus(3)");
+		} else {
+			pre1 = privateFunction("fitPre1" + suffix, gaussFunction, 3);
+			pre2 = privateFunction("fitPre2" + suffix, gaussFunction, 3);
+			single = privateFunction("fitSingle" + suffix, gaussFunction, 3);
+			proper = privateFunction("fitProper" + suffix, doubleGaussFunction, 6);
+		}
+		cut = privateFunction("cutFit" + suffix, gaussExcludeCenterFunction, 5);
+	}
+
+	fitWorkspace::~fitWorkspace() {
+		delete pre1;
+		delete pre2;
+		delete single;
+		delete proper;
+		delete cut;
+	}
+
+	fitWorkspace & defaultFitWorkspace() {
+		static fitWorkspace workspace("", true);  // no suffix: the fitted function keeps its old name "fitProper"
+		return workspace;
+	}
+
+	TF1 * gaussFit(TH1 * hist, bool verbose) {
+		scopedTimer timer("gaussFit");
 		gStyle->SetOptFit(1);
 		TFitResultPtr r = hist->Fit("gaus","QS0");
+		instruments().count("fits");
+		if (r.Get()) instruments().count("fit function calls", r->NCalls());
 		TF1 * myfunc = hist->GetFunction("gaus");
 		if (verbose) {
 			std::cout << "Gauss fit to " << hist->GetTitle() << " (" << hist->GetName() << ")" << std::endl;
@@ -480,42 +924,37 @@ namespace andi {
 		myfunc->SetLineStyle(2);
 		return myfunc;
 	}
-	/**
-	 * @brief Function for fitting a sum of two Gaussians (not coupled)
-	 * @details Fits the sum of two Gaussian distributions on a histogram. Can try to determine the ranges automatically by pre-fitting two individual Gaussians in, each, +- 10 percent of the center (inner), and +- 80 percent of the center (outer). Or, ranges of the inner and outer fits can be given. There's a dedicated function to specify the parameters of the double Gaussian fit manually, which is also called by this function.
-	 * 
-	 * @param hist Histogram with the data to fit to
-	 * @param verbose Print fitting parameters
-	 * @param useAutoRange Defined the ranges of the pre-fits automatically to be 10% and 80% around zero
-	 * @param innerRangeMax The positive half of the range of the inner Gauss pre-fit
-	 * @param outerRange The positive half of the range of the outer Gauss pre-fit. For non-zero-centered histograms, please use the manual function
-	 * @return A TF1 with a double Gaussian. First three parameters are the parameters of the inner Gaussian, second set of three parameters are those of the outer.
-	 */
-	TF1 * doubleGaussFit(TH1 * hist, bool verbose = false, bool useAutoRange = true, double innerRangeMax = 0.05, double outerRangeMax = 0.3) {
+
+	void doubleGaussPrefit(TH1 * hist, double * parameters, double centralValue, double innerRangeMax, double outerRangeMax) {
+		TF1 * fitPre1 = defaultFitWorkspace().pre1;
+		fitPre1->SetRange(centralValue - innerRangeMax, centralValue + innerRangeMax);
+		TFitResultPtr r1 = hist->Fit(fitPre1, "Q0RNS");
+		fitPre1->GetParameters(&parameters[0]);
+		TF1 * fitPre2 = defaultFitWorkspace().pre2;
+		fitPre2->SetRange(centralValue - outerRangeMax, centralValue + outerRangeMax);
+		TFitResultPtr r2 = hist->Fit(fitPre2, "Q0RNS");
+		fitPre2->GetParameters(&parameters[3]);
+		instruments().count("fits", 2);
+		if (r1.Get()) instruments().count("fit function calls", r1->NCalls());
+		if (r2.Get()) instruments().count("fit function calls", r2->NCalls());
+	}
+
+	TF1 * doubleGaussFit(TH1 * hist, bool verbose, bool useAutoRange, double innerRangeMax, double outerRangeMax) {
+		scopedTimer timer("doubleGaussFit");
 		Double_t parameters[6] = {0, 0, 0, 0, 0, 0};
 		gStyle->SetOptFit(1);
 		if (useAutoRange) {
 			innerRangeMax = hist->GetXaxis()->GetXmax() / 10;
 			outerRangeMax = innerRangeMax * 8;
 		}
-		TF1 * fitPre1 = new TF1("fitPre1", "gaus", -innerRangeMax, innerRangeMax);
-		hist->Fit(fitPre1, "Q0R");
-		fitPre1->GetParameters(&parameters[0]);
-// std::cout << parameters[0] << ", " << parameters[3] << std::endl;
-		TF1 * fitPre2 = new TF1("fitPre2", "gaus", -outerRangeMax, outerRangeMax);
-		hist->Fit(fitPre2, "Q0R");
-		fitPre2->GetParameters(&parameters[3]);
-		// startParameters = &parameters;
+		double seedStart, seedEnd;  // the seeded range is not used, the fit range stays +- outerRangeMax
+		if (!doubleGaussSeed(hist, parameters, seedStart, seedEnd)) doubleGaussPrefit(hist, parameters, 0, innerRangeMax, outerRangeMax);
 		return doubleGaussFit(hist, verbose, -outerRangeMax, outerRangeMax, parameters);
 
 	}
-	/**
-	 * @brief Does the same as doubleGaussFit() but does not expected 0-centered distribution
-	 * @details Instead of choosing the range symmetrically around zero, the histogram's main is retrieved as the central value.
-	 *
-	 * This method should, at one point, replace the simple doubleGaussFit(). I've not yet had time to put this in.
-	 */
-	TF1 * doubleGaussFitNonZero(TH1 * hist, bool verbose = false, bool useAutoRange = true, double innerRangeMax = 0.05, double outerRangeMax = 0.3) {
+
+	TF1 * doubleGaussFitNonZero(TH1 * hist, bool verbose, bool useAutoRange, double innerRangeMax, double outerRangeMax) {
+		scopedTimer timer("doubleGaussFitNonZero");
 		double centralValue = hist->GetMean();
 		Double_t parameters[6] = {0, 0, 0, 0, 0, 0};
 		gStyle->SetOptFit(1);
@@ -526,58 +965,38 @@ namespace andi {
 		// std::cout << "centralValue: " << centralValue << std::endl;
 		// std::cout << "innerRangeMax: " << innerRangeMax << std::endl;
 		// std::cout << "outerRangeMax: " << outerRangeMax << std::endl;
-		TF1 * fitPre1 = new TF1("fitPre1", "gaus", centralValue - innerRangeMax, centralValue + innerRangeMax);
-		hist->Fit(fitPre1, "Q0R");
-		fitPre1->GetParameters(&parameters[0]);
-		TF1 * fitPre2 = new TF1("fitPre2", "gaus", centralValue - outerRangeMax, centralValue + outerRangeMax);
-		hist->Fit(fitPre2, "Q0R");
-		fitPre2->GetParameters(&parameters[3]);
-		// startParameters = &parameters;
+		double seedStart, seedEnd;  // the seeded range is not used, the fit range stays centralValue +- outerRangeMax
+		if (!doubleGaussSeed(hist, parameters, seedStart, seedEnd)) doubleGaussPrefit(hist, parameters, centralValue, innerRangeMax, outerRangeMax);
 		return doubleGaussFit(hist, verbose, centralValue - outerRangeMax, centralValue + outerRangeMax, parameters);
 
 	}
-	/**
-	 * @brief A double Gauss fit, but the inner bins are removed for the prefit of the outer Gaussian
-	 * @details Sometimes, for distributions with low statistics in the outer bands, the outer Gauss fit will fail with the other methods in this file. This function provides a kind of *hack-ish* solution to circumvent this.
-	 * 
-	 * For the outer Gauss prefit, the input histogram is cloned and the center-most bins, which fall in the range of -innerRangeMax to +innerRangeMax, are removed. The outer Gauss prefit is then conducted on this new, temporary histogram, just as in the other methods. The rest of the method is equivalent to the other methods.
-	 * 
-	 * No autoRange supplied, as I think it does not make sense here.
-	 */
-	TF1 * doubleGaussFitExcludeCenter(TH1 * hist, bool verbose = false, double innerRangeMax = 0.05, double outerRangeMax = 0.3) {
+
+	TF1 * doubleGaussFitExcludeCenter(TH1 * hist, bool verbose, double innerRangeMax, double outerRangeMax) {
+		scopedTimer timer("doubleGaussFitExcludeCenter");
 		double centralValue = hist->GetMean();  // this method is not yet working for non-zero fits TODO
 		Double_t parameters[6] = {0, 0, 0, 0, 0, 0};
 		gStyle->SetOptFit(1);
 
-		TH1D * htemp = new TH1D(* ((TH1D*)hist));
-		htemp->SetName("htemp");
-		for (int i = 0; i < htemp->GetNbinsX(); i++) {
-			if (TMath::Abs(htemp->GetBinLowEdge(i)) <= innerRangeMax)
-				htemp->SetBinContent(i, 0);  // this line needs to be adapted and tested to make it work for non-zero-centered distributions
-		}
-		TF1 * cutFit = new TF1("cutFit", "gaus", centralValue - outerRangeMax, centralValue - outerRangeMax);
-		htemp->Fit(cutFit, "Q0R");
-		cutFit->GetParameters(&parameters[3]);
+		TF1 * cutFit = defaultFitWorkspace().cut;
+		cutFit->SetParameters(hist->GetMaximum(), centralValue, hist->GetStdDev(), 0, innerRangeMax);
+		cutFit->FixParameter(3, 0);
+		cutFit->FixParameter(4, innerRangeMax);  // points with |x| <= innerRangeMax are rejected; this needs to be adapted and tested to make it work for non-zero-centered distributions
+		cutFit->SetRange(centralValue - outerRangeMax, centralValue + outerRangeMax);
+		hist->Fit(cutFit, "Q0RN");
+		for (int i = 0; i < 3; i++) parameters[3 + i] = cutFit->GetParameter(i);
 
-		TF1 * fitPre1 = new TF1("fitPre1", "gaus", centralValue - innerRangeMax, centralValue + innerRangeMax);
-		hist->Fit(fitPre1, "Q0R");
+		TF1 * fitPre1 = defaultFitWorkspace().pre1;
+		fitPre1->SetRange(centralValue - innerRangeMax, centralValue + innerRangeMax);
+		hist->Fit(fitPre1, "Q0RN");
 		fitPre1->GetParameters(&parameters[0]);
 
 		return doubleGaussFit(hist, verbose, centralValue - outerRangeMax, centralValue + outerRangeMax, parameters);
 
 	}
-	/**
-	 * @brief Function for fitting a sum of two Gaussians (not coupled), providing the fit parameters
-	 * @details The manual version to the other function. Expects a double pointer as last argument, pointing to six pre-fit parameters from where to start the fitting minimization.
-	 * 
-	 * @param hist Histogram with data
-	 * @param verbose Print fit information
-	 * @param outerRange The range of the double Gaussian histogram to fit stuff
-	 * @param startParameters An array of six values from where to start the minimization
-	 * @return Pointer to TF1 with two Gaussians. See description of other function.
-	 */
+
 	TF1 * doubleGaussFit(TH1 * hist, bool verbose, double rangeStart, double rangeEnd, double * startParameters) {
-		TF1 * fitProper = new TF1("fitProper", "gaus(0)+gaus(3)", rangeStart, rangeEnd);
+		TF1 * fitProper = defaultFitWorkspace().proper;
+		fitProper->SetRange(rangeStart, rangeEnd);
 		fitProper->SetParameters(startParameters);
 		fitProper->SetParName(0, "Const (inner)");
 		fitProper->SetParName(1, "Mean (inner)");
@@ -585,8 +1004,14 @@ namespace andi {
 		fitProper->SetParName(3, "Const (outer)");
 		fitProper->SetParName(4, "Mean (outer)");
 		fitProper->SetParName(5, "Sigma (outer)");
+		fitProper->SetLineColor(hist->GetLineColor());
+		fitProper->SetLineWidth(hist->GetLineWidth());
+		fitProper->SetLineStyle(2);
 
-		hist->Fit(fitProper, "Q0R");
+		TFitResultPtr r = hist->Fit(fitProper, "Q0RS");
+		instruments().count("fits");
+		if ((int) r != 0) instruments().count("failed fits");
+		if (r.Get()) instruments().count("fit function calls", r->NCalls());
 		if (verbose) {
 			std::cout << "Gauss fit to " << hist->GetTitle() << " (" << hist->GetName() << ")" << std::endl;
 			std::cout << "  X^2 / NDF = " << fitProper->GetChisquare() << "/" << fitProper->GetNDF() << " = " << fitProper->GetChisquare()/fitProper->GetNDF() << std::endl;
@@ -596,56 +1021,244 @@ namespace andi {
 			std::cout << "  sigma (outer) = " << fitProper->GetParameter(5) << " pm " << fitProper->GetParError(5) << std::endl;
 		}	
 
-		fitProper->SetLineColor(hist->GetLineColor());
-		fitProper->SetLineWidth(hist->GetLineWidth());
-		fitProper->SetLineStyle(2);
+		return hist->GetFunction(fitProper->GetName());  // the copy owned by the histogram, formatted as fitProper
+	}
+
+	bool doubleGaussSeed(TH1 * hist, double * parameters, double & rangeStart, double & rangeEnd) {
+		int nBins = hist->GetNbinsX();
+		std::vector<double> cumulative(nBins + 1, 0);
+		double height = 0, xPeak = 0;
+		int iPeak = 1, nFilled = 0;
+		for (int i = 1; i <= nBins; i++) {
+			double content = std::max(hist->GetBinContent(i), 0.);
+			cumulative[i] = cumulative[i - 1] + content;
+			if (content > 0) nFilled++;
+			if (content > height) {
+				height = content;
+				iPeak = i;
+			}
+		}
+		double sum = cumulative[nBins];
+		rangeStart = hist->GetXaxis()->GetXmin();
+		rangeEnd = hist->GetXaxis()->GetXmax();
+		if (sum <= 0 || nFilled < 5) return false;
+		xPeak = hist->GetBinCenter(iPeak);
+
+		// full width at half maximum, crossings interpolated between bin centers
+		int iLeft = iPeak, iRight = iPeak;
+		while (iLeft > 1 && hist->GetBinContent(iLeft - 1) > height / 2) iLeft--;
+		while (iRight < nBins && hist->GetBinContent(iRight + 1) > height / 2) iRight++;
+		double xLeft = hist->GetBinLowEdge(iLeft), xRight = hist->GetBinLowEdge(iRight) + hist->GetBinWidth(iRight);
+		if (iLeft > 1) {
+			double c0 = hist->GetBinContent(iLeft - 1), c1 = hist->GetBinContent(iLeft);
+			xLeft = hist->GetBinCenter(iLeft - 1) + (height / 2 - c0) / (c1 - c0) * (hist->GetBinCenter(iLeft) - hist->GetBinCenter(iLeft - 1));
+		}
+		if (iRight < nBins) {
+			double c0 = hist->GetBinContent(iRight), c1 = hist->GetBinContent(iRight + 1);
+			xRight = hist->GetBinCenter(iRight) + (c0 - height / 2) / (c0 - c1) * (hist->GetBinCenter(iRight + 1) - hist->GetBinCenter(iRight));
+		}
+		double binWidth = (rangeEnd - rangeStart) / nBins;
+		double sigmaCore = std::max((xRight - xLeft) / 2.3548, binWidth / 2);
+
+		// center: weighted mean above half maximum
+		double sumCore = 0, sumXCore = 0;
+		for (int i = iLeft; i <= iRight; i++) {
+			sumCore += hist->GetBinContent(i);
+			sumXCore += hist->GetBinContent(i) * hist->GetBinCenter(i);
+		}
+		double mean = (sumCore > 0) ? sumXCore / sumCore : xPeak;
+
+		// robust variance: only between the 0.5% and 99.5% quantiles
+		double sumVariance = 0, sumWeights = 0;
+		for (int i = 1; i <= nBins; i++) {
+			if (cumulative[i] < 0.005 * sum || cumulative[i - 1] > 0.995 * sum) continue;
+			double content = std::max(hist->GetBinContent(i), 0.);
+			double dx = hist->GetBinCenter(i) - mean;
+			sumVariance += content * dx * dx;
+			sumWeights += content;
+		}
+		double variance = (sumWeights > 0) ? sumVariance / sumWeights : sigmaCore * sigmaCore;
 
-		return fitProper;
+		// core/tail decomposition: A_c + A_t = height; A_c s_c + A_t s_t = K; A_c s_c^3 + A_t s_t^3 = K variance
+		double K = sum * binWidth / std::sqrt(2 * M_PI);
+		double a = K - height * sigmaCore;  // = A_t (s_t - s_c)
+		double sigmaTail = 3 * sigmaCore, amplitudeTail = 0.05 * height;
+		if (a > 0.05 * K) {
+			double c = a * sigmaCore * sigmaCore + height * sigmaCore * sigmaCore * sigmaCore - K * variance;
+			double discriminant = a * a * sigmaCore * sigmaCore - 4 * a * c;
+			if (discriminant > 0) sigmaTail = (-a * sigmaCore + std::sqrt(discriminant)) / (2 * a);
+			if (!(sigmaTail > 1.05 * sigmaCore)) sigmaTail = 1.5 * sigmaCore;
+			amplitudeTail = std::min(a / (sigmaTail - sigmaCore), 0.95 * height);
+		}
+		parameters[0] = height - amplitudeTail;
+		parameters[1] = mean;
+		parameters[2] = sigmaCore;
+		parameters[3] = amplitudeTail;
+		parameters[4] = mean;
+		parameters[5] = sigmaTail;
+		rangeStart = std::max(rangeStart, mean - 5 * sigmaTail);
+		rangeEnd = std::min(rangeEnd, mean + 5 * sigmaTail);
+		return true;
 	}
-	/**
-	 * @brief Converts a double Gaussian fit function into the two single Gaussians it is built from
-	 * @details If you ever want to draw both of the functions individually.
-	 * 
-	 * @param funcGaus A pointer to a double Gaussian function
-	 * @return A pair of pointers to the functions, the Gaussian is built from.
-	 */
-	std::pair<TF1 *, TF1 * > doubleGaussToTwoGauss(TF1* funcGaus) {
+
+	TF1 * doubleGaussFit(TH1 * hist, const streamingStats & stats, bool verbose, double nTailWidths) {
+		scopedTimer timer("doubleGaussFit");
+		double parameters[6];
+		stats.doubleGaussParameters(parameters, hist->GetBinWidth(1));
+		std::pair<double, double> range = stats.fitRange(nTailWidths);
+		gStyle->SetOptFit(1);
+		return doubleGaussFit(hist, verbose, range.first, range.second, parameters);
+	}
+
+	TF1 * doubleGaussFitSeeded(TH1 * hist, bool verbose) {
+		scopedTimer timer("doubleGaussFitSeeded");
+		double parameters[6] = {0, 0, 0, 0, 0, 0};
+		double rangeStart, rangeEnd;
+		gStyle->SetOptFit(1);
+		if (!doubleGaussSeed(hist, parameters, rangeStart, rangeEnd)) return doubleGaussFitNonZero(hist, verbose);
+		return doubleGaussFit(hist, verbose, rangeStart, rangeEnd, parameters);
+	}
+
+	void doubleGaussToTwoGauss(TF1 * funcGaus, std::pair<TF1 *, TF1 * > & gaussians) {
 		Double_t parameters[6] = {-1, -1, -1, -1, -1, -1};
 		funcGaus->GetParameters(&parameters[0]);
 		double rangeStart, rangeEnd;
 		funcGaus->GetRange(rangeStart, rangeEnd);
 
-		TF1 * firstGaus = new TF1("firstGaus", "gaus", rangeStart, rangeEnd);
-		firstGaus->SetParameters(parameters[0], parameters[1], parameters[2]);
-		TF1 * secondGaus = new TF1("secondGaus", "gaus", rangeStart, rangeEnd);
-		secondGaus->SetParameters(parameters[3], parameters[4], parameters[5]);
+		if (gaussians.first == 0) gaussians.first = privateFunction("firstGaus", "gaus", rangeStart, rangeEnd);
+		if (gaussians.second == 0) gaussians.second = privateFunction("secondGaus", "gaus", rangeStart, rangeEnd);
+		gaussians.first->SetRange(rangeStart, rangeEnd);
+		gaussians.first->SetParameters(parameters[0], parameters[1], parameters[2]);
+		gaussians.second->SetRange(rangeStart, rangeEnd);
+		gaussians.second->SetParameters(parameters[3], parameters[4], parameters[5]);
+	}
 
-		return std::make_pair(firstGaus, secondGaus);
+	std::pair<TF1 *, TF1 * > doubleGaussToTwoGauss(TF1* funcGaus) {
+		std::pair<TF1 *, TF1 *> gaussians(0, 0);
+		doubleGaussToTwoGauss(funcGaus, gaussians);
+		return gaussians;
 	}
-	/**
-	 * @}
-	 */
 
-	/**
-	 * @name Canvas Drawing and Saving
-	 * @details Methods for drawing a histogram on a canvas and saving the canvas. Usually, the canvas is returned.
-	 * 
-	 * Methods are in place which also apply a (double) Gaussian fit.
-	 * 
-	 * @{
-	 */
-	/**
-	 * @brief Draws a (1D) histogram onto a canvas, makes the title and saves it (optionally)
-	 * @details This few lines is the overhead I'm using all day, so I made this function. The canvas name is chosen as per the histogram name, with my convention (histograms start with a h, the according canvas is the same name, but with a c in front). There are some optional arguments
-	 * 
-	 * @param h Pointer to 1D histogram
-	 * @param filename The title of the canvas, also the name the images will be saved with
-	 * @param basename The basename for andi::saveCanvas, a prefix for all the images
-	 * @param save Should files be saved? Slows everything down, hence an option
-	 * @param fit Should there be a Gaussian fit?
-	 * @return TCanvas point. You dont need to use it, but if you want, whoops, here it is.
-	 */
-	TCanvas * createCanvasDrawAndSave(TH1 * h, TString filename, TString basename, bool save = true, int fit = 0) {
+	// Batch Gauss Fits
+	fitResult fitHistogram(TH1 * hist, fitWorkspace & workspace, int fitType) {
+		fitResult result;
+		result.name = hist->GetName();
+		result.function = 0;
+		result.nParameters = (fitType == kFitGauss) ? 3 : 6;
+		result.nCalls = 0;
+		for (int i = 0; i < 6; i++) result.parameters[i] = result.errors[i] = 0;
+		TF1 * fit = workspace.single;
+		double seedParameters[6] = {0, 0, 0, 0, 0, 0};
+		double seedStart, seedEnd;
+		bool seeded = (fitType != kFitGauss) && doubleGaussSeed(hist, seedParameters, seedStart, seedEnd);
+		if (fitType == kFitGauss) {
+			// starting values as TF1's "gaus" would get them
+			fit->SetParameters(hist->GetMaximum(), hist->GetMean(), hist->GetStdDev());
+			fit->SetRange(hist->GetXaxis()->GetXmin(), hist->GetXaxis()->GetXmax());
+		} else if (seeded && fitType == kFitDoubleGaussSeeded) {
+			fit = workspace.proper;
+			fit->SetParameters(seedParameters);
+			fit->SetRange(seedStart, seedEnd);
+		} else {
+			// as doubleGaussFitNonZero(): range from the axis, starting parameters seeded, pre-fits only if that fails
+			double centralValue = hist->GetMean();
+			double innerRangeMax = fabs(centralValue - hist->GetXaxis()->GetXmax()) / 10;
+			double outerRangeMax = innerRangeMax * 8;
+			if (!seeded) {
+				double width = hist->GetStdDev();
+				workspace.pre1->SetParameters(hist->GetMaximum(), centralValue, std::min(width, innerRangeMax));
+				workspace.pre1->SetRange(centralValue - innerRangeMax, centralValue + innerRangeMax);
+				TFitResultPtr r1 = hist->Fit(workspace.pre1, "Q0RNS");
+				if (r1.Get()) result.nCalls += r1->NCalls();
+				workspace.pre1->GetParameters(&seedParameters[0]);
+				workspace.pre2->SetParameters(hist->GetMaximum(), centralValue, width);
+				workspace.pre2->SetRange(centralValue - outerRangeMax, centralValue + outerRangeMax);
+				TFitResultPtr r2 = hist->Fit(workspace.pre2, "Q0RNS");
+				if (r2.Get()) result.nCalls += r2->NCalls();
+				workspace.pre2->GetParameters(&seedParameters[3]);
+			}
+			fit = workspace.proper;
+			fit->SetParameters(seedParameters);
+			fit->SetRange(centralValue - outerRangeMax, centralValue + outerRangeMax);
+		}
+		TFitResultPtr r = hist->Fit(fit, "Q0RNS");
+		result.status = r;
+		if (r.Get()) result.nCalls += r->NCalls();
+		instruments().count("fits");
+		instruments().count("fit function calls", result.nCalls);
+		for (int i = 0; i < result.nParameters; i++) {
+			result.parameters[i] = fit->GetParameter(i);
+			result.errors[i] = fit->GetParError(i);
+		}
+		result.chi2 = fit->GetChisquare();
+		result.ndf = fit->GetNDF();
+		fit->GetRange(result.rangeStart, result.rangeEnd);
+		return result;
+	}
+
+	std::vector<fitResult> fitHistograms(const std::vector<TH1 *> & histograms, int fitType, bool makeFunctions, int nThreads) {
+		scopedTimer timer("fitHistograms");
+		std::vector<fitResult> results(histograms.size());
+		nThreads = std::min<int>(numberOfThreads(nThreads), std::max<int>(histograms.size(), 1));
+		ROOT::EnableThreadSafety();
+		std::string oldMinimizer = ROOT::Math::MinimizerOptions::DefaultMinimizerType();
+		ROOT::Math::MinimizerOptions::SetDefaultMinimizer("Minuit2");
+		std::vector<fitWorkspace *> workspaces;
+		for (int iThread = 0; iThread < nThreads; iThread++) workspaces.push_back(new fitWorkspace(TString::Format("_thread%d", iThread)));
+		std::atomic<size_t> nextHistogram(0);
+		runInThreads(nThreads, [&](int iThread) {
+			for (size_t i = nextHistogram++; i < histograms.size(); i = nextHistogram++) results[i] = fitHistogram(histograms[i], *workspaces[iThread], fitType);
+		});
+		for (int iThread = 0; iThread < nThreads; iThread++) delete workspaces[iThread];
+		ROOT::Math::MinimizerOptions::SetDefaultMinimizer(oldMinimizer.c_str());
+		if (makeFunctions) {
+			for (size_t i = 0; i < histograms.size(); i++) {
+				fitResult & r = results[i];
+				r.function = privateFunction("fit" + r.name, (fitType == kFitGauss) ? "gaus" : "gaus(0)+gaus(3)", r.rangeStart, r.rangeEnd);
+				r.function->SetParameters(r.parameters);
+				r.function->SetParErrors(r.errors);
+				r.function->SetChisquare(r.chi2);
+				r.function->SetNDF(r.ndf);
+				r.function->SetLineColor(histograms[i]->GetLineColor());
+				r.function->SetLineWidth(histograms[i]->GetLineWidth());
+				r.function->SetLineStyle(2);
+			}
+		}
+		return results;
+	}
+
+	void printFitResults(const std::vector<fitResult> & results) {
+		for (size_t i = 0; i < results.size(); i++) {
+			const fitResult & r = results[i];
+			std::cout << r.name << ": status = " << r.status << ", X^2 / NDF = " << r.chi2 << "/" << r.ndf << " = " << r.chi2PerNdf() << std::endl;
+			for (int j = 0; j < r.nParameters / 3; j++) {
+				std::cout << "  const = " << r.constant(j) << " pm " << r.errors[3 * j] << ", mean = " << r.mean(j) << " pm " << r.errors[3 * j + 1] << ", sigma = " << r.sigma(j) << " pm " << r.errors[3 * j + 2] << std::endl;
+			}
+		}
+	}
+
+	std::vector<plotSpec> *& deferredPlots() {
+		static std::vector<plotSpec> * plots = 0;
+		return plots;
+	}
+
+	void enableDeferredPlots(bool enable) {
+		std::vector<plotSpec> *& plots = deferredPlots();
+		delete plots;
+		plots = enable ? new std::vector<plotSpec>() : 0;
+	}
+
+	bool deferPlot(const plotSpec & spec) {
+		if (!deferredPlots()) return false;
+		deferredPlots()->push_back(spec);
+		return true;
+	}
+
+	// Canvas Drawing and Saving
+	TCanvas * createCanvasDrawAndSave(TH1 * h, TString filename, TString basename, bool save, int fit) {
+		plotSpec spec(kPlotTH1, h, filename, basename, save);
+		spec.fit = fit;
+		if (deferPlot(spec)) return 0;
 		TString canvasName = h->GetName();
 		canvasName.Remove(0, 1);
 		canvasName.Prepend("c");
@@ -665,22 +1278,17 @@ namespace andi {
 		if (save) andi::saveCanvas(c, basename);
 		return c;
 	}
-	/**
-	 * @brief See createCanvasDrawAndSave(). This version fits a Gauss
-	 */
-	TCanvas * createCanvasFitDrawAndSave(TH1 * h, TString filename, TString basename, bool save = true, int fit = 1) {
+
+	TCanvas * createCanvasFitDrawAndSave(TH1 * h, TString filename, TString basename, bool save, int /* fit */) {
 		return createCanvasDrawAndSave(h, filename, basename, save, 1);
 	}
-	/**
-	 * @brief See createCanvasDrawAndSave(). This version fits a double Gauss.
-	 */
-	TCanvas * createCanvasFitDoubleDrawAndSave(TH1 * h, TString filename, TString basename, bool save = true, int fit = 2) {
+
+	TCanvas * createCanvasFitDoubleDrawAndSave(TH1 * h, TString filename, TString basename, bool save, int /* fit */) {
 		return createCanvasDrawAndSave(h, filename, basename, save, 2);
 	}
-	/**
-	 * @brief See createCanvasDrawAndSave(). For TH2, moves the Z axis to the left as well.
-	 */
-	TCanvas * createCanvasDrawAndSave(TH2 * h, TString filename, TString basename, bool save = true) {
+
+	TCanvas * createCanvasDrawAndSave(TH2 * h, TString filename, TString basename, bool save) {
+		if (deferPlot(plotSpec(kPlotTH2, h, filename, basename, save))) return 0;
 		TString canvasName = h->GetName();
 		canvasName.Remove(0, 1);
 		canvasName.Prepend("c");
@@ -690,10 +1298,11 @@ namespace andi {
 		if (save) andi::saveCanvas(c, basename);
 		return c;
 	}
-	/**
-	 * @brief See createCanvasDrawAndSave(). For everything which comes from TObject. Like TGraph and sorts.
-	 */
-	TCanvas * createCanvasDrawAndSave(TObject * h, TString filename, TString basename, bool save = true, TString drawParams = "") {
+
+	TCanvas * createCanvasDrawAndSave(TObject * h, TString filename, TString basename, bool save, TString drawParams) {
+		plotSpec spec(kPlotObject, h, filename, basename, save);
+		spec.drawParams = drawParams;
+		if (deferPlot(spec)) return 0;
 		TString canvasName = h->GetName();
 		canvasName.Remove(0, 1);
 		canvasName.Prepend("c");
@@ -703,10 +1312,13 @@ namespace andi {
 		if (save) andi::saveCanvas(c, basename);
 		return c;
 	}
-	/**
-	 * @brief See createCanvasDrawAndSave(). For THStack. Also creates a legend.
-	 */
-	TCanvas * createCanvasDrawAndSave(THStack * stack, TString filename, TString basename, bool save = true, TString stackTitle = "Histograms", double boxStartY = 0.7, double boxStartX = 0.7) {
+
+	TCanvas * createCanvasDrawAndSave(THStack * stack, TString filename, TString basename, bool save, TString stackTitle, double boxStartY, double boxStartX) {
+		plotSpec spec(kPlotStack, stack, filename, basename, save);
+		spec.stackTitle = stackTitle;
+		spec.boxStartY = boxStartY;
+		spec.boxStartX = boxStartX;
+		if (deferPlot(spec)) return 0;
 		TString canvasName = stack->GetName();
 		canvasName.Remove(0, 1);
 		canvasName.Prepend("c");
@@ -720,26 +1332,102 @@ namespace andi {
 		if (save) andi::saveCanvas(c, basename);
 		return c;
 	}
-	/**
-	 * @}
-	 */
-	/**
-	 * @brief Reads in a Tree from multiple Files
-	 * @details For data collections of the same structure it is possible to append the trees after one another.
-	 * This functions gives a convenient way to do so.
-	 * 
-	 * The fileName parameter should point to a text file with the file name of a root file per line, like:
-	 * ~~~
-	 * file1.root
-	 * file2.root
-	 * ~~~
-	 * The function returns a TTree with combined content.
-	 * 
-	 * @param treeName Name of the tree in every file. Has to be equal.
-	 * @param fileName A text file with one file per line.
-	 * 
-	 * @return TTree of a chain of input files. The intermediate TChain is casted to a TTree, because of my macros.
-	 */
+
+	int renderDeferred(TString pattern) {
+		scopedTimer timer("renderDeferred");
+		std::vector<plotSpec> * plots = deferredPlots();
+		if (!plots) return 0;
+		deferredPlots() = 0;  // draw for real
+		TRegexp regexp(pattern, kTRUE);
+		std::vector<plotSpec> notRendered;
+		int nRendered = 0;
+		for (size_t i = 0; i < plots->size(); i++) {
+			const plotSpec & spec = (*plots)[i];
+			if (pattern != "" && spec.filename.Index(regexp) == kNPOS) {
+				notRendered.push_back(spec);
+				continue;
+			}
+			TCanvas * c = 0;
+			if (spec.kind == kPlotTH1) c = createCanvasDrawAndSave((TH1*) spec.object, spec.filename, spec.basename, spec.save, spec.fit);
+			else if (spec.kind == kPlotTH2) c = createCanvasDrawAndSave((TH2*) spec.object, spec.filename, spec.basename, spec.save);
+			else if (spec.kind == kPlotStack) c = createCanvasDrawAndSave((THStack*) spec.object, spec.filename, spec.basename, spec.save, spec.stackTitle, spec.boxStartY, spec.boxStartX);
+			else c = createCanvasDrawAndSave(spec.object, spec.filename, spec.basename, spec.save, spec.drawParams);
+			if (spec.save) delete c;
+			nRendered++;
+		}
+		plots->swap(notRendered);
+		deferredPlots() = plots;
+		return nRendered;
+	}
+
+	int writeDeferred(TString fileName) {
+		std::vector<plotSpec> * plots = deferredPlots();
+		if (!plots) return 0;
+		TDirectory * previousDirectory = gDirectory;
+		TFile * file = TFile::Open(fileName, "RECREATE");
+		if (!file || file->IsZombie()) {
+			std::cerr << "andi::writeDeferred: Could not open " << fileName << std::endl;
+			if (previousDirectory) previousDirectory->cd();
+			return 0;
+		}
+		for (size_t i = 0; i < plots->size(); i++) {
+			const plotSpec & spec = (*plots)[i];
+			spec.object->Write(TString::Format("plot_%d", (int) i));
+			TList settings;
+			settings.SetOwner();
+			settings.Add(new TObjString(TString::Format("%d", spec.kind)));
+			settings.Add(new TObjString(spec.filename));
+			settings.Add(new TObjString(spec.basename));
+			settings.Add(new TObjString(TString::Format("%d", spec.save)));
+			settings.Add(new TObjString(TString::Format("%d", spec.fit)));
+			settings.Add(new TObjString(spec.drawParams));
+			settings.Add(new TObjString(spec.stackTitle));
+			settings.Add(new TObjString(TString::Format("%f", spec.boxStartY)));
+			settings.Add(new TObjString(TString::Format("%f", spec.boxStartX)));
+			settings.Write(TString::Format("spec_%d", (int) i), TObject::kSingleKey);
+		}
+		file->Close();
+		delete file;
+		if (previousDirectory) previousDirectory->cd();
+		return plots->size();
+	}
+
+	int readDeferred(TString fileName) {
+		if (!deferredPlots()) enableDeferredPlots();
+		TDirectory * previousDirectory = gDirectory;
+		TFile * file = TFile::Open(fileName);
+		if (!file || file->IsZombie()) {
+			std::cerr << "andi::readDeferred: Could not open " << fileName << std::endl;
+			if (previousDirectory) previousDirectory->cd();
+			return 0;
+		}
+		int nRead = 0;
+		for (int i = 0; ; i++) {
+			TObject * object = file->Get(TString::Format("plot_%d", i));
+			TList * settings = (TList*) file->Get(TString::Format("spec_%d", i));
+			if (!object || !settings) break;
+			if (object->InheritsFrom("TH1")) ((TH1*) object)->SetDirectory(0);
+			settings->SetOwner();
+			if (settings->GetEntries() == 9) {
+				std::vector<TString> fields;
+				for (int j = 0; j < 9; j++) fields.push_back(((TObjString*) settings->At(j))->GetString());
+				plotSpec spec(fields[0].Atoi(), object, fields[1], fields[2], fields[3].Atoi());
+				spec.fit = fields[4].Atoi();
+				spec.drawParams = fields[5];
+				spec.stackTitle = fields[6];
+				spec.boxStartY = fields[7].Atof();
+				spec.boxStartX = fields[8].Atof();
+				deferredPlots()->push_back(spec);
+				nRead++;
+			}
+			delete settings;
+		}
+		file->Close();
+		delete file;
+		if (previousDirectory) previousDirectory->cd();
+		return nRead;
+	}
+
 	TTree * treeFromMultipleFiles(TString treeName, TString fileName) {
 		TChain * tempChain = new TChain(treeName);
 		TFileCollection collection("somename", "", fileName);
@@ -747,44 +1435,229 @@ namespace andi {
 		return (TTree*) tempChain;
 	}
 
-	/**
- 	 * @namespace cuts A namespace for my cut benchmarks.
-	 */
+	// Preselection entry lists
+	Long64_t entriesToProcess(TTree * tree) {
+		TEntryList * list = tree->GetEntryList();
+		return list ? list->GetN() : tree->GetEntries();
+	}
+
+	std::vector<Long64_t> clusterStarts(TTree * tree) {
+		std::vector<Long64_t> starts;
+		Long64_t nEntries = tree->GetEntries();
+		TTree::TClusterIterator clusters = tree->GetClusterIterator(0);
+		for (Long64_t start = clusters(); start < nEntries; start = clusters()) starts.push_back(start);
+		starts.push_back(nEntries);
+		return starts;
+	}
+
+	TString preselectionKey(TTree * tree, TCut selection, bool * persistable) {
+		TString description = TString(tree->GetName()) + "|" + selection.GetTitle();
+		std::vector<TString> files;
+		if (tree->InheritsFrom("TChain")) {
+			TObjArray * elements = ((TChain *) tree)->GetListOfFiles();
+			for (int i = 0; i < elements->GetEntries(); i++) files.push_back(elements->At(i)->GetTitle());
+		} else if (tree->GetCurrentFile() != 0) {
+			files.push_back(tree->GetCurrentFile()->GetName());
+		}
+		for (size_t i = 0; i < files.size(); i++) {
+			FileStat_t fileStat;
+			if (gSystem->GetPathInfo(files[i], fileStat) == 0) description += TString::Format("|%s %ld %lld", files[i].Data(), fileStat.fMtime, fileStat.fSize);
+			else description += "|" + files[i];  // remote file: name only
+		}
+		if (files.empty()) description += TString::Format("|%p %lld", (void *) tree, tree->GetEntries());
+		if (persistable) *persistable = !files.empty();
+		TMD5 md5;
+		md5.Update((const UChar_t *) description.Data(), description.Length());
+		if (TEntryList * list = tree->GetEntryList()) {
+			const Long64_t chunkSize = 4096;
+			std::vector<Long64_t> entries(chunkSize);
+			Long64_t nEntries = list->GetN();
+			md5.Update((const UChar_t *) "|entry list", 11);
+			for (Long64_t first = 0; first < nEntries; first += chunkSize) {
+				Long64_t n = std::min(chunkSize, nEntries - first);
+				for (Long64_t i = 0; i < n; i++) entries[i] = tree->GetEntryNumber(first + i);
+				md5.Update((const UChar_t *) &entries[0], n * sizeof(Long64_t));
+			}
+		}
+		md5.Final();
+		return md5.AsString();
+	}
+
+	preselectionCache::~preselectionCache() {
+		clear();
+	}
+
+	void preselectionCache::clear() {
+		for (std::map<TString, TEntryList *>::iterator it = lists.begin(); it != lists.end(); it++) delete it->second;
+		lists.clear();
+	}
+
+	TEntryList * preselectionCache::get(TTree * tree, TCut selection) {
+		bool persistable = false;
+		TString key = preselectionKey(tree, selection, &persistable);
+		std::map<TString, TEntryList *>::iterator found = lists.find(key);
+		if (found != lists.end()) return found->second;
+		TString objectName = "preselection_" + key;
+		TEntryList * list = 0;
+		TDirectory * previousDirectory = gDirectory;
+		if (persistable && fileName != "" && !gSystem->AccessPathName(fileName)) {
+			TFile file(fileName, "READ");
+			TEntryList * stored = 0;
+			file.GetObject(objectName, stored);
+			if (stored) {
+				list = (TEntryList *) stored->Clone();
+				list->SetDirectory(0);
+				instruments().count("preselections from file");
+			}
+		}
+		if (previousDirectory) previousDirectory->cd();
+		if (!list) {
+			scopedTimer timer("preselection");
+			tree->Draw(">>andiPreselection", selection, "entrylist goff");  // only the entries of the tree's entry list, if it has one
+			list = (TEntryList *) gDirectory->Get("andiPreselection");
+			if (!list) {
+				std::cerr << "andi::preselectionCache: Could not evaluate selection " << selection.GetTitle() << " on " << tree->GetName() << std::endl;
+				return 0;
+			}
+			list->SetDirectory(0);
+			list->SetName(objectName);
+			instruments().count("preselections evaluated");
+			instruments().count("entries read", entriesToProcess(tree));
+			if (persistable && fileName != "") {
+				TFile file(fileName, "UPDATE");
+				if (file.IsZombie()) std::cerr << "andi::preselectionCache: Could not open " << fileName << std::endl;
+				else list->Write(objectName, TObject::kOverwrite);
+				if (previousDirectory) previousDirectory->cd();
+			}
+		}
+		lists[key] = list;
+		return list;
+	}
+
+	preselectionCache & preselections() {
+		static preselectionCache cache;
+		return cache;
+	}
+
+	void enablePreselectionCache(bool enable, TString fileName) {
+		preselections().enabled = enable;
+		preselections().fileName = fileName;
+	}
+
+	TEntryList * preselectionList(TTree * tree, TCut selection) {
+		return preselections().get(tree, selection);
+	}
+
+	bool applyPreselection(TTree * tree, TCut selection) {
+		if (TString(selection.GetTitle()) == "") {
+			tree->SetEntryList(0);
+			return true;
+		}
+		TEntryList * list = preselectionList(tree, selection);
+		if (list) tree->SetEntryList(list);
+		return list != 0;
+	}
+
+	scopedPreselection::scopedPreselection(TTree * _tree, TCut selection) : tree(0), previous(0), remaining(selection) {
+		if (!preselections().enabled || TString(selection.GetTitle()) == "") return;
+		previous = _tree->GetEntryList();
+		if (!applyPreselection(_tree, selection)) return;
+		tree = _tree;
+		remaining = "";
+	}
+
+	scopedPreselection::~scopedPreselection() {
+		if (tree) tree->SetEntryList(previous);
+	}
+
 	namespace cuts {
 
 		double sigBkgRatio(double sig, double bkg) {
 			return sig * sig / (bkg + sig);
 		}
-		/**
-		 * @brief Cut benchmark. For list of limits
-		 * @details Finds the best signal to background ratio for a quantity and several limits, returns a graph of the ratios.
-		 * Internal verbose parameter needs to be switched on manually.
-		 * 
-		 * There are different version of this method, for different uses cases. Usually only the steps parameter is different, e.g. sometimes a list of values, sometimes a range. The working principle of all methods is the same, though.
-		 * 
-		 * @param treeSig TTree holding testCut quantity to benchmark for SIGNAL
-		 * @param treeBkg TTree holding testCut quantity to benchmark for BACKGROUND
-		 * @param scaleFactorBkg Value with which the background is scaled
-		 * @param testCut The cut which is tested, e.g. 'mass'
-		 * @param defaultCut A pre-cut applied to all measurements of entries. Choose an empty string, if you don't need to apply any cuts. I'd like to define a TCut cutNone = ""
-		 * @param steps Vector of quantities, e.g. {1, 2, 3}
-		 * @param bestRatio The best ratio will be filled into this variable
-		 * @return Graph with the S/B ratio for every evaluated point
-		 */
-		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, std::vector<double> steps, double & bestRatio) {
+
+		void countGetEntries(TTree * treeSig, TTree * treeBkg) {
+			if (!instruments().enabled) return;
+			instruments().count("GetEntries calls", 2);
+			instruments().count("entries read", entriesToProcess(treeSig) + entriesToProcess(treeBkg));
+		}
+
+		void traceStep(TCut cut, double entriesSig, double entriesBkg, double ratio) {
+			if (instruments().trace) std::cout << "Cut: " << (char*) cut << ", #Sig: " << entriesSig << ", #Bkg: " << entriesBkg << ", Ratio: " << ratio << std::endl;
+		}
+
+		// Sorted Columns
+		double formattedValue(double value) {
+			return TString::Format("%f", value).Atof();
+		}
+
+		std::vector<double> sortedColumn(TTree * tree, TCut quantity, TCut selection) {
+			scopedTimer timer("cuts::sortedColumn");
+			scopedTreeStats treeStats(tree);
+			std::vector<double> column;
+			Long64_t oldEstimate = tree->GetEstimate();
+			tree->SetEstimate(tree->GetEntries() + 1);  // keep all selected rows in memory, not only the last 1000000
+			Long64_t nSelected = tree->Draw((char*) quantity, selection, "goff");
+			instruments().count("entries read", entriesToProcess(tree));
+			if (nSelected > 0) {
+				double * values = tree->GetV1();
+				column.reserve(nSelected);
+				for (Long64_t i = 0; i < nSelected; i++) {
+					if (!std::isnan(values[i])) column.push_back(values[i]);
+				}
+			}
+			tree->SetEstimate(oldEstimate);
+			std::sort(column.begin(), column.end());
+			return column;
+		}
+
+		Long64_t countAbove(const std::vector<double> & column, double threshold) {
+			return column.end() - std::upper_bound(column.begin(), column.end(), threshold);
+		}
+
+		Long64_t countBetween(const std::vector<double> & column, double lower, double upper) {
+			std::vector<double>::const_iterator first = std::upper_bound(column.begin(), column.end(), lower);
+			std::vector<double>::const_iterator last = std::lower_bound(column.begin(), column.end(), upper);
+			if (last < first) return 0;
+			return last - first;
+		}
+
+		TGraph * cutBenchmark(const std::vector<double> & columnSig, const std::vector<double> & columnBkg, double scaleFactorBkg, std::vector<double> steps, double & bestRatio) {
+			TGraph * tempGraph = new TGraph();
+			int iPoint = 0;
+			double lastRatio = -1.;
+			for (std::vector<double>::iterator it = steps.begin(); it != steps.end(); it++, iPoint++)	{
+				double threshold = formattedValue(*it);
+				double entriesSig = countAbove(columnSig, threshold);
+				double entriesBkg = scaleFactorBkg * countAbove(columnBkg, threshold);
+				double ratio = sigBkgRatio(entriesSig, entriesBkg);
+				if (ratio > lastRatio) {
+					bestRatio = *it;
+					lastRatio = ratio;
+				}
+				tempGraph->SetPoint(iPoint, *it, ratio);
+			}
+			return tempGraph;
+		}
+
+		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, std::vector<double> steps, double & bestRatio, bool singlePass) {
+			scopedTimer timer("cuts::cutBenchmark");
+			scopedPreselection preselectedSig(treeSig, defaultCut), preselectedBkg(treeBkg, defaultCut);
+			if (singlePass) {
+				std::vector<double> columnSig = sortedColumn(treeSig, testCut, preselectedSig.remaining);
+				std::vector<double> columnBkg = sortedColumn(treeBkg, testCut, preselectedBkg.remaining);
+				return cutBenchmark(columnSig, columnBkg, scaleFactorBkg, steps, bestRatio);
+			}
 			TGraph * tempGraph = new TGraph();
 			int iPoint = 0;
 			double lastRatio = -1.;
-			bool verbose = false;
 			for (std::vector<double>::iterator it = steps.begin(); it != steps.end(); it++, iPoint++)	{
 				TCut currentCut = TString::Format("%s > %f", (char*) testCut, *it);
-				if (verbose) std::cout << (char*)currentCut << std::endl;
-				double entriesSig = treeSig->GetEntries(currentCut && defaultCut);
-				if (verbose) std::cout << entriesSig << std::endl;
-				double entriesBkg = scaleFactorBkg * treeBkg->GetEntries(currentCut && defaultCut);
-				if (verbose) std::cout << entriesBkg << std::endl;
+				double entriesSig = treeSig->GetEntries(currentCut && preselectedSig.remaining);
+				double entriesBkg = scaleFactorBkg * treeBkg->GetEntries(currentCut && preselectedBkg.remaining);
 				double ratio = sigBkgRatio(entriesSig, entriesBkg);
-				if (verbose) std::cout << ratio << std::endl;
+				countGetEntries(treeSig, treeBkg);
+				traceStep(currentCut, entriesSig, entriesBkg, ratio);
 				if (ratio > lastRatio) {
 					bestRatio = *it;
 					lastRatio = ratio;
@@ -793,51 +1666,81 @@ namespace andi {
 			}
 			return tempGraph;
 		}
-		/**
-		 * @brief Cut benchmark. For a simple upper limit and lower limit. Deprecated, as this can also be done with the other functions.
-		 **/
-		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, std::pair<double, double> rangeLimits, Int_t numberOfSteps) {
+
+		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, std::pair<double, double> rangeLimits, Int_t numberOfSteps, bool singlePass) {
+			scopedTimer timer("cuts::cutBenchmark");
+			scopedPreselection preselectedSig(treeSig, defaultCut), preselectedBkg(treeBkg, defaultCut);
 			TGraph * tempGraph = new TGraph();
 			double stepWidth = (rangeLimits.second - rangeLimits.first) / (double)numberOfSteps;
 			int iPoint = 0;
-			bool verbose = false;
-			for (double i = rangeLimits.first; i < rangeLimits.second; i += stepWidth, iPoint++)	{
-				if (verbose) std::cout << i << std::endl;
+			std::vector<double> columnSig, columnBkg;
+			if (singlePass) {
+				columnSig = sortedColumn(treeSig, testCut, preselectedSig.remaining);
+				columnBkg = sortedColumn(treeBkg, testCut, preselectedBkg.remaining);
+			}
+			for (int iStep = 0; iStep < numberOfSteps; iStep++, iPoint++)	{
+				double i = rangeLimits.first + iStep * stepWidth;  // not summed up, so the steps do not drift
 				TCut currentString = TString::Format("%s > %f", (char*) testCut, i);
 				TCut currentCut = currentString;
-				if (verbose) std::cout << (char*)currentCut << std::endl;
-				double entriesSig = treeSig->GetEntries(currentCut && defaultCut);
-				if (verbose) std::cout << entriesSig << std::endl;
-				double entriesBkg = scaleFactorBkg * treeBkg->GetEntries(currentCut && defaultCut);
-				if (verbose) std::cout << entriesBkg << std::endl;
+				double entriesSig, entriesBkg;
+				if (singlePass) {
+					entriesSig = countAbove(columnSig, formattedValue(i));
+					entriesBkg = scaleFactorBkg * countAbove(columnBkg, formattedValue(i));
+				} else {
+					entriesSig = treeSig->GetEntries(currentCut && preselectedSig.remaining);
+					entriesBkg = scaleFactorBkg * treeBkg->GetEntries(currentCut && preselectedBkg.remaining);
+					countGetEntries(treeSig, treeBkg);
+				}
 				double ratio = sigBkgRatio(entriesSig, entriesBkg);
-				if (verbose) std::cout << ratio << std::endl;
+				traceStep(currentCut, entriesSig, entriesBkg, ratio);
 				tempGraph->SetPoint(iPoint, i, ratio);
 			}
 			return tempGraph;
 		}
-		/**
-		 * @brief Cut benchmark. For a symmetrical range around a central value.
-		 **/
-		TGraph * cutBenchmarkSymmetric(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, double centralValue, double rangeLimit, Int_t numberOfSteps, double & _lowerLimit, double & _upperLimit) {
+
+		TGraph * cutBenchmarkSymmetric(const std::vector<double> & columnSig, const std::vector<double> & columnBkg, double scaleFactorBkg, double centralValue, double rangeLimit, Int_t numberOfSteps, double & _lowerLimit, double & _upperLimit) {
+			TGraph * tempGraph = new TGraph();
+			double stepWidth = rangeLimit / (double)numberOfSteps;
+			double lastRatio = -1.;
+			for (int i = 1; i <= numberOfSteps; i++)	{
+				double upperLimit = centralValue + i * stepWidth;
+				double lowerLimit = centralValue - i * stepWidth;
+				double entriesSig = countBetween(columnSig, formattedValue(lowerLimit), formattedValue(upperLimit));
+				double entriesBkg = scaleFactorBkg * countBetween(columnBkg, formattedValue(lowerLimit), formattedValue(upperLimit));
+				double ratio = sigBkgRatio(entriesSig, entriesBkg);
+				if (entriesSig == 0) ratio = 0;
+				if (entriesBkg == 0) ratio = 0;
+				if (ratio > lastRatio) {
+					_lowerLimit = lowerLimit, _upperLimit = upperLimit;
+					lastRatio = ratio;
+				}
+				tempGraph->SetPoint(i - 1, upperLimit - lowerLimit, ratio);
+			}
+			return tempGraph;
+		}
+
+		TGraph * cutBenchmarkSymmetric(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, double centralValue, double rangeLimit, Int_t numberOfSteps, double & _lowerLimit, double & _upperLimit, bool singlePass) {
+			scopedTimer timer("cuts::cutBenchmarkSymmetric");
+			scopedPreselection preselectedSig(treeSig, defaultCut), preselectedBkg(treeBkg, defaultCut);
+			if (singlePass) {
+				std::vector<double> columnSig = sortedColumn(treeSig, testCut, preselectedSig.remaining);
+				std::vector<double> columnBkg = sortedColumn(treeBkg, testCut, preselectedBkg.remaining);
+				return cutBenchmarkSymmetric(columnSig, columnBkg, scaleFactorBkg, centralValue, rangeLimit, numberOfSteps, _lowerLimit, _upperLimit);
+			}
 			TGraph * tempGraph = new TGraph();
 			double stepWidth = rangeLimit / (double)numberOfSteps;
 			double lastRatio = -1.;
-			bool verbose = false;
 			for (int i = 1; i <= numberOfSteps; i++)	{
 				if ((i % 100) == 0) std::cout << "Loop: " << i << std::endl;
 				double upperLimit = centralValue + i * stepWidth;
 				double lowerLimit = centralValue - i * stepWidth;
 				TCut currentCut = TString::Format("%s > %f && %s < %f", (char*) testCut, lowerLimit, (char*) testCut, upperLimit);
 
-				if (verbose) std::cout << "Cut: " << (char*)currentCut << std::endl;
-				double entriesSig = treeSig->GetEntries(currentCut && defaultCut);
-				if (verbose) std::cout << "#Sig: " << entriesSig << std::endl;
-				double entriesBkg = scaleFactorBkg * treeBkg->GetEntries(currentCut && defaultCut);
-				if (verbose) std::cout << "#Bkg: " << entriesBkg << std::endl;
+				double entriesSig = treeSig->GetEntries(currentCut && preselectedSig.remaining);
+				double entriesBkg = scaleFactorBkg * treeBkg->GetEntries(currentCut && preselectedBkg.remaining);
 				double ratio = sigBkgRatio(entriesSig, entriesBkg);
-				if (verbose) std::cout << "Ratio: " << ratio << std::endl;
-				if (verbose) std::cout << "upperLimit: " << upperLimit << std::endl;
+				countGetEntries(treeSig, treeBkg);
+				traceStep(currentCut, entriesSig, entriesBkg, ratio);
 				if (entriesSig == 0) ratio = 0;
 				if (entriesBkg == 0) ratio = 0;
 				if (ratio > lastRatio) {
@@ -849,88 +1752,2043 @@ namespace andi {
 			}
 			return tempGraph;
 		}
-	}
 
-	/**
-	 * @name Containers for data from a particle
-	 * @details The structs and methods can be used to converts ROOT's `SetBranchAddress()` stuff again into C++ objects.
-	 * 
-	 * This is really for my specific analyses.
-	 * @{
-	*/
-	/**
-	 * @brief The properties of a particle
-	 * @details Small struct with publicly accessible member variables of the most important quantities of a particle.
-	 * 
-	 */
-	struct properties {
-		Float_t pt, px, py, pz, p, E;
-		Float_t m, chg, pdg;
-	};
-	/**
-	 * @brief A container for my whole D meson decay
-	 * @details Every decay arm has four particles: The actual D meson (the mother particle, m, and three daughters, d{0..2} (kaon, pion, pion)). All have the usual particle properties, as defined by the corresponding struct
-	 * 
-	 */
-	struct DInfoContainer {
-		properties m; // actual d meson (m=mother)
+		// Adaptive cut search
+		double sigBkgRatioError(double sig, double bkg, double errorSig, double errorBkg) {
+			if (sig + bkg <= 0) return 0;
+			double derivativeSig = sig * (sig + 2 * bkg) / ((sig + bkg) * (sig + bkg));
+			double derivativeBkg = -sig * sig / ((sig + bkg) * (sig + bkg));
+			return std::sqrt(derivativeSig * derivativeSig * errorSig * errorSig + derivativeBkg * derivativeBkg * errorBkg * errorBkg);
+		}
 
-		properties d0, d1, d2; // three daughters
-	};
-	/**
-	 * @brief Sets my needed branch addresses when running over NTuple explicitly
-	 * @details My experiment has data files containing NTuple / TTrees with lots of branches corresponding to different properties of different particles. This function maps a info container to the corresponding branches.
-	 * 
-	 * @param tuple Pointer to the TTree holding all the info (ALL the info)
-	 * @param container Address of a info container with all the needed methods
-	 * @param baseString The string prefixing all the branches
-	 * @param alsoDaugthers Set also daughter branches
-	 */
-	void setBranchAddresses(TTree * tuple, andi::DInfoContainer & container, TString baseString, bool alsoDaugthers = true) {
-		tuple->SetBranchAddress(baseString + "pt", &(container.m.pt));
-		tuple->SetBranchAddress(baseString + "px", &(container.m.px));
-		tuple->SetBranchAddress(baseString + "py", &(container.m.py));
-		tuple->SetBranchAddress(baseString + "pz", &(container.m.pz));
-		tuple->SetBranchAddress(baseString + "p", &(container.m.p));
-		tuple->SetBranchAddress(baseString + "e", &(container.m.E));
-		tuple->SetBranchAddress(baseString + "m", &(container.m.m));
-		tuple->SetBranchAddress(baseString + "pdg", &(container.m.pdg));
-		tuple->SetBranchAddress(baseString + "chg", &(container.m.chg));
-
-		if (alsoDaugthers) {
-			tuple->SetBranchAddress(baseString + "d0" + "pt", &(container.d0.pt));
-			tuple->SetBranchAddress(baseString + "d0" + "px", &(container.d0.px));
-			tuple->SetBranchAddress(baseString + "d0" + "py", &(container.d0.py));
-			tuple->SetBranchAddress(baseString + "d0" + "pz", &(container.d0.pz));
-			tuple->SetBranchAddress(baseString + "d0" + "p", &(container.d0.p));
-			tuple->SetBranchAddress(baseString + "d0" + "e", &(container.d0.E));
-			tuple->SetBranchAddress(baseString + "d0" + "m", &(container.d0.m));
-			tuple->SetBranchAddress(baseString + "d0" + "pdg", &(container.d0.pdg));
-			tuple->SetBranchAddress(baseString + "d0" + "chg", &(container.d0.chg));
-
-			tuple->SetBranchAddress(baseString + "d1" + "pt", &(container.d1.pt));
-			tuple->SetBranchAddress(baseString + "d1" + "px", &(container.d1.px));
-			tuple->SetBranchAddress(baseString + "d1" + "py", &(container.d1.py));
-			tuple->SetBranchAddress(baseString + "d1" + "pz", &(container.d1.pz));
-			tuple->SetBranchAddress(baseString + "d1" + "p", &(container.d1.p));
-			tuple->SetBranchAddress(baseString + "d1" + "e", &(container.d1.E));
-			tuple->SetBranchAddress(baseString + "d1" + "m", &(container.d1.m));
-			tuple->SetBranchAddress(baseString + "d1" + "pdg", &(container.d1.pdg));
-			tuple->SetBranchAddress(baseString + "d1" + "chg", &(container.d1.chg));
-
-			tuple->SetBranchAddress(baseString + "d2" + "pt", &(container.d2.pt));
-			tuple->SetBranchAddress(baseString + "d2" + "px", &(container.d2.px));
-			tuple->SetBranchAddress(baseString + "d2" + "py", &(container.d2.py));
-			tuple->SetBranchAddress(baseString + "d2" + "pz", &(container.d2.pz));
-			tuple->SetBranchAddress(baseString + "d2" + "p", &(container.d2.p));
-			tuple->SetBranchAddress(baseString + "d2" + "e", &(container.d2.E));
-			tuple->SetBranchAddress(baseString + "d2" + "m", &(container.d2.m));
-			tuple->SetBranchAddress(baseString + "d2" + "pdg", &(container.d2.pdg));
-			tuple->SetBranchAddress(baseString + "d2" + "chg", &(container.d2.chg));
-		}		
-	}
-	/**
-	 * @}
-	 */
+		double sigBkgRatioError(double sig, double bkg, double scaleFactorBkg) {
+			return sigBkgRatioError(sig, bkg, std::sqrt(sig), std::sqrt(scaleFactorBkg * bkg));
+		}
 
-}
+		TGraph * adaptiveSearch(const std::function<double(double, double &)> & figureOfMerit, double lower, double upper, double resolution, double & best, int nCoarse, int maxEvaluations) {
+			std::map<double, std::pair<double, double> > points;  // cut value: figure of merit, uncertainty
+			auto evaluate = [&](double x) {
+				if (points.find(x) == points.end()) {
+					double error = 0;
+					double value = figureOfMerit(x, error);
+					points[x] = std::make_pair(value, error);
+				}
+				return points[x].first;
+			};
+			nCoarse = std::max(nCoarse, 2);
+			double step = (upper - lower) / nCoarse;
+			for (int i = 0; i <= nCoarse; i++) evaluate(lower + i * step);
+			best = lower;
+			for (std::map<double, std::pair<double, double> >::iterator it = points.begin(); it != points.end(); it++) {
+				if (it->second.first > points[best].first) best = it->first;
+			}
+			while (step > resolution && (int) points.size() + 2 <= maxEvaluations) {
+				step /= 2;
+				double center = best, bestValue = points[center].first, neighbourValue = -INFINITY;
+				for (int side = -1; side <= 1; side += 2) {
+					double x = center + side * step;
+					if (x < lower || x > upper) continue;
+					double value = evaluate(x);
+					neighbourValue = std::max(neighbourValue, value);
+					if (value > points[best].first) best = x;
+				}
+				if (best == center && bestValue - neighbourValue < points[center].second) break;  // flat within the uncertainty
+			}
+			TGraph * tempGraph = new TGraph();
+			int iPoint = 0;
+			for (std::map<double, std::pair<double, double> >::iterator it = points.begin(); it != points.end(); it++, iPoint++) tempGraph->SetPoint(iPoint, it->first, it->second.first);
+			instruments().count("adaptive search evaluations", points.size());
+			return tempGraph;
+		}
+
+		TGraph * cutBenchmarkAdaptive(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, std::pair<double, double> rangeLimits, double resolution, double & bestCut, int maxEvaluations) {
+			scopedTimer timer("cuts::cutBenchmarkAdaptive");
+			scopedPreselection preselectedSig(treeSig, defaultCut), preselectedBkg(treeBkg, defaultCut);
+			return adaptiveSearch([&](double value, double & error) {
+				TCut currentCut = TString::Format("%s > %f", (char*) testCut, value);
+				double entriesSig = treeSig->GetEntries(currentCut && preselectedSig.remaining);
+				double entriesBkg = scaleFactorBkg * treeBkg->GetEntries(currentCut && preselectedBkg.remaining);
+				double ratio = sigBkgRatio(entriesSig, entriesBkg);
+				countGetEntries(treeSig, treeBkg);
+				traceStep(currentCut, entriesSig, entriesBkg, ratio);
+				error = sigBkgRatioError(entriesSig, entriesBkg, scaleFactorBkg);
+				return ratio;
+			}, rangeLimits.first, rangeLimits.second, resolution, bestCut, 10, maxEvaluations);
+		}
+
+		TGraph * cutBenchmarkSymmetricAdaptive(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, double centralValue, double rangeLimit, double resolution, double & _lowerLimit, double & _upperLimit, int maxEvaluations) {
+			scopedTimer timer("cuts::cutBenchmarkSymmetricAdaptive");
+			scopedPreselection preselectedSig(treeSig, defaultCut), preselectedBkg(treeBkg, defaultCut);
+			double bestHalfWidth = rangeLimit;
+			TGraph * tempGraph = adaptiveSearch([&](double halfWidth, double & error) {
+				TCut currentCut = TString::Format("%s > %f && %s < %f", (char*) testCut, centralValue - halfWidth, (char*) testCut, centralValue + halfWidth);
+				double entriesSig = treeSig->GetEntries(currentCut && preselectedSig.remaining);
+				double entriesBkg = scaleFactorBkg * treeBkg->GetEntries(currentCut && preselectedBkg.remaining);
+				double ratio = sigBkgRatio(entriesSig, entriesBkg);
+				if (entriesSig == 0) ratio = 0;
+				if (entriesBkg == 0) ratio = 0;
+				countGetEntries(treeSig, treeBkg);
+				traceStep(currentCut, entriesSig, entriesBkg, ratio);
+				error = sigBkgRatioError(entriesSig, entriesBkg, scaleFactorBkg);
+				return ratio;
+			}, resolution, rangeLimit, resolution, bestHalfWidth, 10, maxEvaluations);
+			_lowerLimit = centralValue - bestHalfWidth;
+			_upperLimit = centralValue + bestHalfWidth;
+			for (int i = 0; i < tempGraph->GetN(); i++) tempGraph->GetX()[i] *= 2;
+			return tempGraph;
+		}
+
+		// Quick look
+		std::vector<Long64_t> allClusterStarts(TTree * tree) {
+			if (!tree->InheritsFrom("TChain")) return clusterStarts(tree);
+			TChain * chain = (TChain *) tree;
+			Long64_t nEntries = chain->GetEntries();
+			std::vector<Long64_t> starts;
+			for (int i = 0; i < chain->GetNtrees(); i++) {
+				Long64_t offset = chain->GetTreeOffset()[i];
+				Long64_t end = (i + 1 < chain->GetNtrees()) ? chain->GetTreeOffset()[i + 1] : nEntries;
+				if (end <= offset || chain->LoadTree(offset) < 0 || chain->GetTreeNumber() != i) continue;
+				std::vector<Long64_t> fileStarts = clusterStarts(chain->GetTree());
+				for (size_t k = 0; k + 1 < fileStarts.size(); k++) starts.push_back(offset + fileStarts[k]);
+			}
+			starts.push_back(nEntries);
+			return starts;
+		}
+
+		std::vector<Long64_t> blockSample(TTree * tree, Long64_t sampleSize, std::vector<Long64_t> & blocks, Long64_t & nBlocks, unsigned int seed) {
+			const Long64_t minBlocks = 20;
+			Long64_t maxBlockSize = std::max<Long64_t>(1, sampleSize / minBlocks);
+			Long64_t nEntries = entriesToProcess(tree);
+			std::vector<Long64_t> starts = allClusterStarts(tree);
+			// position (in the entries to process) of the first entry of every block
+			std::vector<Long64_t> firstPositions;
+			if (!tree->GetEntryList()) {
+				for (size_t c = 0; c + 1 < starts.size(); c++) {
+					for (Long64_t first = starts[c]; first < starts[c + 1]; first += maxBlockSize) firstPositions.push_back(first);
+				}
+			} else {
+				Long64_t clusterEnd = -1, blockStart = 0;
+				for (Long64_t i = 0; i < nEntries; i++) {
+					Long64_t entry = tree->GetEntryNumber(i);
+					if (entry < clusterEnd && i - blockStart < maxBlockSize) continue;
+					if (entry >= clusterEnd) clusterEnd = *std::upper_bound(starts.begin(), starts.end(), entry);
+					firstPositions.push_back(i);
+					blockStart = i;
+				}
+			}
+			firstPositions.push_back(nEntries);
+			nBlocks = firstPositions.size() - 1;
+
+			// partial shuffle of the blocks, until enough entries are drawn
+			std::vector<Long64_t> order(nBlocks);
+			for (Long64_t b = 0; b < nBlocks; b++) order[b] = b;
+			TRandom3 random(seed);
+			Long64_t nDrawn = 0, nChosen = 0;
+			for (; nChosen < nBlocks && nDrawn < sampleSize; nChosen++) {
+				std::swap(order[nChosen], order[nChosen + random.Integer(nBlocks - nChosen)]);
+				nDrawn += firstPositions[order[nChosen] + 1] - firstPositions[order[nChosen]];
+			}
+			std::sort(order.begin(), order.begin() + nChosen);
+
+			std::vector<Long64_t> sample;
+			sample.reserve(nDrawn);
+			blocks.clear();
+			for (Long64_t b = 0; b < nChosen; b++) {
+				blocks.push_back(sample.size());
+				for (Long64_t i = firstPositions[order[b]]; i < firstPositions[order[b] + 1]; i++) sample.push_back(tree->GetEntryList() ? tree->GetEntryNumber(i) : i);
+			}
+			blocks.push_back(sample.size());
+			return sample;
+		}
+
+		sampledBlocks sampledColumn(TTree * tree, TCut quantity, TCut selection, Long64_t sampleSize, unsigned int seed) {
+			scopedTimer timer("cuts::sampledColumn");
+			sampledBlocks sample;
+			sample.population = entriesToProcess(tree);
+			std::vector<Long64_t> blocks;
+			std::vector<Long64_t> entries = blockSample(tree, sampleSize, blocks, sample.nBlocks, seed);
+			size_t nSampled = blocks.size() - 1;
+			sample.columns.resize(nSampled);
+			std::vector<Long64_t> firstEntries(nSampled);
+			for (size_t b = 0; b < nSampled; b++) {
+				sample.drawn.push_back(blocks[b + 1] - blocks[b]);
+				firstEntries[b] = entries[blocks[b]];
+			}
+			TEntryList sampleList("andiSampleList", "");
+			sampleList.SetDirectory(0);
+			for (size_t i = 0; i < entries.size(); i++) sampleList.Enter(entries[i], tree);
+			TEntryList * previous = tree->GetEntryList();
+			tree->SetEntryList(&sampleList);
+			{
+				scopedTreeStats treeStats(tree);
+				Long64_t oldEstimate = tree->GetEstimate();
+				tree->SetEstimate(entries.size() + 1);
+				Long64_t nSelected = tree->Draw(TString(quantity.GetTitle()) + ":Entry$", selection, "goff");  // Entry$ tells the block of every value
+				instruments().count("entries read", entries.size());
+				if (nSelected > 0) {
+					double * values = tree->GetV1();
+					double * entryNumbers = tree->GetV2();
+					for (Long64_t i = 0; i < nSelected; i++) {
+						if (std::isnan(values[i])) continue;
+						size_t b = std::upper_bound(firstEntries.begin(), firstEntries.end(), (Long64_t) entryNumbers[i]) - firstEntries.begin() - 1;
+						sample.columns[b].push_back(values[i]);
+					}
+				}
+				tree->SetEstimate(oldEstimate);
+			}
+			tree->SetEntryList(previous);
+			for (size_t b = 0; b < nSampled; b++) std::sort(sample.columns[b].begin(), sample.columns[b].end());
+			return sample;
+		}
+
+		double extrapolatedCount(const std::vector<Long64_t> & passed, const std::vector<Long64_t> & drawn, Long64_t population, Long64_t nBlocks, double & error) {
+			error = 0;
+			Long64_t m = drawn.size(), sumPassed = 0, sumDrawn = 0;
+			for (Long64_t b = 0; b < m; b++) {
+				sumPassed += passed[b];
+				sumDrawn += drawn[b];
+			}
+			if (sumDrawn == 0) return 0;
+			double fraction = (double) sumPassed / sumDrawn;
+			double unsampled = 1 - (double) m / nBlocks;
+			if (m < 2) {
+				error = population * std::sqrt(fraction * (1 - fraction) * unsampled);
+			} else {
+				double spread = 0;
+				for (Long64_t b = 0; b < m; b++) spread += std::pow(passed[b] - fraction * drawn[b], 2);
+				spread /= m - 1;
+				double meanDrawn = (double) sumDrawn / m;
+				error = population * std::sqrt(unsampled * spread / m) / meanDrawn;
+			}
+			return population * fraction;
+		}
+
+		quickLookResult quickLook(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, const std::vector<double> & xValues, const std::vector<double> & cutValues, const std::function<Long64_t(const std::vector<double> &, size_t)> & count, Long64_t sampleSize, bool refine, unsigned int seed, bool zeroIfEmpty) {
+			scopedPreselection preselectedSig(treeSig, defaultCut), preselectedBkg(treeBkg, defaultCut);
+			quickLookResult result;
+			sampledBlocks samples[2];
+			samples[0] = sampledColumn(treeSig, testCut, preselectedSig.remaining, sampleSize, seed);
+			samples[1] = sampledColumn(treeBkg, testCut, preselectedBkg.remaining, sampleSize, seed + 1);
+			for (int k = 0; k < 2; k++) {
+				result.population[k] = samples[k].population;
+				result.blocks[k] = samples[k].drawn.size();
+				result.sampleSize[k] = 0;
+				for (size_t b = 0; b < samples[k].drawn.size(); b++) result.sampleSize[k] += samples[k].drawn[b];
+			}
+			result.estimate = new TGraphAsymmErrors(xValues.size());
+			result.refined = 0;
+			result.bestCut = cutValues.empty() ? 0 : cutValues[0];
+			std::vector<double> ratios(xValues.size()), errors(xValues.size());
+			size_t iBest = 0;
+			for (size_t i = 0; i < xValues.size(); i++) {
+				double entries[2], error[2];
+				for (int k = 0; k < 2; k++) {
+					std::vector<Long64_t> passed(samples[k].columns.size());
+					for (size_t b = 0; b < passed.size(); b++) passed[b] = count(samples[k].columns[b], i);
+					entries[k] = extrapolatedCount(passed, samples[k].drawn, samples[k].population, samples[k].nBlocks, error[k]);
+				}
+				double entriesSig = entries[0], entriesBkg = scaleFactorBkg * entries[1];
+				ratios[i] = sigBkgRatio(entriesSig, entriesBkg);
+				errors[i] = sigBkgRatioError(entriesSig, entriesBkg, error[0], scaleFactorBkg * error[1]);
+				if (zeroIfEmpty && (entriesSig == 0 || entriesBkg == 0)) ratios[i] = errors[i] = 0;
+				traceStep(TString::Format("%s, step %g (sampled)", (char*) testCut, cutValues[i]).Data(), entriesSig, entriesBkg, ratios[i]);
+				result.estimate->SetPoint(i, xValues[i], ratios[i]);
+				result.estimate->SetPointError(i, 0, 0, std::min(errors[i], ratios[i]), errors[i]);
+				if (ratios[i] > ratios[iBest]) iBest = i;
+			}
+			if (!xValues.empty()) result.bestCut = cutValues[iBest];
+			if (refine && !xValues.empty()) {
+				std::vector<double> columnSig = sortedColumn(treeSig, testCut, preselectedSig.remaining);
+				std::vector<double> columnBkg = sortedColumn(treeBkg, testCut, preselectedBkg.remaining);
+				result.refined = new TGraph();
+				double bestRatio = -1.;
+				for (size_t i = 0; i < xValues.size(); i++) {
+					if (ratios[i] + errors[i] < ratios[iBest] - errors[iBest]) continue;  // significantly worse than the best estimate
+					double entriesSig = count(columnSig, i), entriesBkg = scaleFactorBkg * count(columnBkg, i);
+					double ratio = sigBkgRatio(entriesSig, entriesBkg);
+					if (zeroIfEmpty && (entriesSig == 0 || entriesBkg == 0)) ratio = 0;
+					if (ratio > bestRatio) {
+						result.bestCut = cutValues[i];
+						bestRatio = ratio;
+					}
+					result.refined->SetPoint(result.refined->GetN(), xValues[i], ratio);
+				}
+			}
+			return result;
+		}
+
+		quickLookResult cutBenchmarkQuickLook(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, std::vector<double> steps, Long64_t sampleSize, bool refine, unsigned int seed) {
+			scopedTimer timer("cuts::cutBenchmarkQuickLook");
+			return quickLook(treeSig, treeBkg, scaleFactorBkg, testCut, defaultCut, steps, steps, [&](const std::vector<double> & column, size_t iStep) {
+				return countAbove(column, formattedValue(steps[iStep]));
+			}, sampleSize, refine, seed);
+		}
+
+		quickLookResult cutBenchmarkSymmetricQuickLook(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, double centralValue, double rangeLimit, Int_t numberOfSteps, double & _lowerLimit, double & _upperLimit, Long64_t sampleSize, bool refine, unsigned int seed) {
+			scopedTimer timer("cuts::cutBenchmarkSymmetricQuickLook");
+			double stepWidth = rangeLimit / (double)numberOfSteps;
+			std::vector<double> widths;
+			for (int i = 1; i <= numberOfSteps; i++) widths.push_back(2 * i * stepWidth);
+			quickLookResult result = quickLook(treeSig, treeBkg, scaleFactorBkg, testCut, defaultCut, widths, widths, [&](const std::vector<double> & column, size_t iStep) {
+				return countBetween(column, formattedValue(centralValue - (iStep + 1) * stepWidth), formattedValue(centralValue + (iStep + 1) * stepWidth));
+			}, sampleSize, refine, seed, true);
+			_lowerLimit = centralValue - result.bestCut / 2;
+			_upperLimit = centralValue + result.bestCut / 2;
+			return result;
+		}
+
+		// Cut Grids
+		std::vector<std::vector<double> > columns(TTree * tree, std::vector<TString> quantities, TCut selection) {
+			std::vector<std::vector<double> > values(quantities.size());
+			if (quantities.empty() || quantities.size() > 4) {
+				std::cerr << "andi::cuts::columns: Can only read 1 to 4 quantities at once, got " << quantities.size() << std::endl;
+				return values;
+			}
+			TString varexp = quantities[0];
+			for (size_t j = 1; j < quantities.size(); j++) varexp += ":" + quantities[j];
+			Long64_t oldEstimate = tree->GetEstimate();
+			tree->SetEstimate(tree->GetEntries() + 1);
+			Long64_t nSelected = tree->Draw(varexp, selection, "goff");
+			for (size_t j = 0; j < quantities.size() && nSelected > 0; j++) {
+				double * v = tree->GetVal(j);
+				values[j].assign(v, v + nSelected);
+			}
+			tree->SetEstimate(oldEstimate);
+			return values;
+		}
+
+		std::vector<double> stepBinEdges(const std::vector<double> & steps) {
+			std::vector<double> edges(steps.size() + 1);
+			double halfFirst = (steps.size() > 1) ? (steps[1] - steps[0]) / 2 : 0.5;
+			double halfLast = (steps.size() > 1) ? (steps[steps.size() - 1] - steps[steps.size() - 2]) / 2 : 0.5;
+			edges[0] = steps[0] - halfFirst;
+			for (size_t k = 1; k < steps.size(); k++) edges[k] = (steps[k - 1] + steps[k]) / 2;
+			edges[steps.size()] = steps[steps.size() - 1] + halfLast;
+			return edges;
+		}
+
+		std::vector<Long64_t> gridCounts(const std::vector<std::vector<double> > & values, const std::vector<gridAxis> & axes, const std::vector<std::vector<double> > & sortedSteps, int nThreads) {
+			size_t nDim = axes.size();
+			std::vector<Long64_t> stride(nDim, 1);
+			Long64_t nCells = 1;
+			for (size_t j = 0; j < nDim; j++) {
+				stride[j] = nCells;
+				nCells *= sortedSteps[j].size() + 1;
+			}
+			Long64_t nEntries = values.empty() ? 0 : values[0].size();
+
+			// fill: every thread counts its part of the entries into its own array, no locks
+			const Long64_t maxCellsInMemory = 32 * 1024 * 1024;  // 256 MB of counters over all threads
+			nThreads = std::max(1, (int) std::min<Long64_t>(nThreads, maxCellsInMemory / nCells));
+			std::vector<std::vector<Long64_t> > threadCounts(nThreads);
+			runInThreads(nThreads, [&](int iThread) {
+				std::vector<Long64_t> & counts = threadCounts[iThread];
+				counts.assign(nCells, 0);
+				std::pair<Long64_t, Long64_t> range = threadRange(nEntries, iThread, nThreads);
+				for (Long64_t i = range.first; i < range.second; i++) {
+					Long64_t cell = 0;
+					for (size_t j = 0; j < nDim; j++) {
+						const std::vector<double> & steps = sortedSteps[j];
+						double x = values[j][i];
+						Long64_t nPassed = 0;
+						if (std::isnan(x)) nPassed = 0;
+						else if (axes[j].lowerLimit) nPassed = std::lower_bound(steps.begin(), steps.end(), x) - steps.begin();  // steps < x
+						else nPassed = steps.end() - std::upper_bound(steps.begin(), steps.end(), x);  // steps > x
+						cell += nPassed * stride[j];
+					}
+					counts[cell]++;
+				}
+			});
+
+			// merge: every thread sums up its part of the cells
+			std::vector<Long64_t> counts(nCells, 0);
+			runInThreads(nThreads, [&](int iThread) {
+				std::pair<Long64_t, Long64_t> range = threadRange(nCells, iThread, nThreads);
+				for (int t = 0; t < nThreads; t++) {
+					for (Long64_t c = range.first; c < range.second; c++) counts[c] += threadCounts[t][c];
+				}
+			});
+			threadCounts.clear();
+
+			// cumulate from the top along every axis; every thread takes a part of the lines along the axis
+			for (size_t j = 0; j < nDim; j++) {
+				Long64_t nAlong = sortedSteps[j].size() + 1;
+				Long64_t nLines = nCells / nAlong;
+				runInThreads(nThreads, [&](int iThread) {
+					std::pair<Long64_t, Long64_t> range = threadRange(nLines, iThread, nThreads);
+					for (Long64_t line = range.first; line < range.second; line++) {
+						Long64_t start = (line / stride[j]) * stride[j] * nAlong + (line % stride[j]);
+						for (Long64_t k = nAlong - 2; k >= 0; k--) counts[start + k * stride[j]] += counts[start + (k + 1) * stride[j]];
+					}
+				});
+			}
+			return counts;
+		}
+
+		gridResult cutBenchmarkGrid(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, std::vector<gridAxis> axes, TCut defaultCut, int nThreads, Long64_t maxCells) {
+			scopedTimer timer("cuts::cutBenchmarkGrid");
+			gridResult result;
+			result.bestRatio = -1.;
+			result.ratios = 0;
+			size_t nDim = axes.size();
+			if (nDim == 0 || nDim > 4) {
+				std::cerr << "andi::cuts::cutBenchmarkGrid: Need 1 to 4 axes, got " << nDim << std::endl;
+				return result;
+			}
+			nThreads = numberOfThreads(nThreads);
+
+			std::vector<TString> quantities;
+			std::vector<std::vector<double> > sortedSteps(nDim);
+			std::vector<Int_t> nBins(nDim);
+			std::vector<double> xMin(nDim), xMax(nDim);
+			for (size_t j = 0; j < nDim; j++) {
+				quantities.push_back(axes[j].quantity);
+				for (size_t k = 0; k < axes[j].steps.size(); k++) sortedSteps[j].push_back(formattedValue(axes[j].steps[k]));
+				std::sort(sortedSteps[j].begin(), sortedSteps[j].end());
+				sortedSteps[j].erase(std::unique(sortedSteps[j].begin(), sortedSteps[j].end()), sortedSteps[j].end());
+				if (sortedSteps[j].empty()) {
+					std::cerr << "andi::cuts::cutBenchmarkGrid: No steps for axis " << axes[j].quantity << std::endl;
+					return result;
+				}
+				nBins[j] = sortedSteps[j].size();
+				xMin[j] = 0;
+				xMax[j] = 1;
+			}
+			// gridCounts() also keeps the cells with no cut passed, i.e. one more per axis
+			double nCountCells = 1;
+			for (size_t j = 0; j < nDim; j++) nCountCells *= nBins[j] + 1;
+			if (nCountCells > maxCells) {
+				std::cerr << "andi::cuts::cutBenchmarkGrid: Grid of " << nCountCells << " cells exceeds the limit of " << maxCells << " cells (about " << 4 * 8 * nCountCells / (1024. * 1024. * 1024.) << " GB); use fewer steps or raise maxCells" << std::endl;
+				return result;
+			}
+			scopedPreselection preselectedSig(treeSig, defaultCut), preselectedBkg(treeBkg, defaultCut);
+			std::vector<Long64_t> countsSig = gridCounts(columns(treeSig, quantities, preselectedSig.remaining), axes, sortedSteps, nThreads);
+			std::vector<Long64_t> countsBkg = gridCounts(columns(treeBkg, quantities, preselectedBkg.remaining), axes, sortedSteps, nThreads);
+
+			result.ratios = new THnD("hnRatios", "S^{2}/(S+B) of cut grid", nDim, &nBins[0], &xMin[0], &xMax[0]);
+			for (size_t j = 0; j < nDim; j++) {
+				std::vector<double> edges = stepBinEdges(sortedSteps[j]);
+				result.ratios->GetAxis(j)->Set(nBins[j], &edges[0]);
+				result.ratios->GetAxis(j)->SetTitle(TString::Format("%s %s", axes[j].quantity.Data(), axes[j].lowerLimit ? ">" : "<"));
+			}
+
+			// evaluate every cell; every thread remembers its best cell
+			Long64_t nCells = 1;
+			for (size_t j = 0; j < nDim; j++) nCells *= nBins[j];
+			std::vector<double> ratios(nCells);
+			std::vector<double> threadBestRatio(nThreads, -1.);
+			std::vector<Long64_t> threadBestCell(nThreads, -1);
+			runInThreads(nThreads, [&](int iThread) {
+				std::pair<Long64_t, Long64_t> range = threadRange(nCells, iThread, nThreads);
+				for (Long64_t cell = range.first; cell < range.second; cell++) {
+					Long64_t rest = cell, countIndex = 0, countStride = 1;
+					for (size_t j = 0; j < nDim; j++) {
+						Long64_t k = rest % nBins[j];  // cell number along axis, counted as in gridCounts()
+						rest /= nBins[j];
+						countIndex += (k + 1) * countStride;
+						countStride *= nBins[j] + 1;
+					}
+					double entriesSig = countsSig[countIndex];
+					double entriesBkg = scaleFactorBkg * countsBkg[countIndex];
+					double ratio = sigBkgRatio(entriesSig, entriesBkg);
+					if (entriesSig + entriesBkg == 0) ratio = 0;
+					ratios[cell] = ratio;
+					if (ratio > threadBestRatio[iThread]) {
+						threadBestRatio[iThread] = ratio;
+						threadBestCell[iThread] = cell;
+					}
+				}
+			});
+			// THnD is not thread-safe, so it is filled afterwards
+			std::vector<Int_t> bin(nDim);
+			for (Long64_t cell = 0; cell < nCells; cell++) {
+				Long64_t rest = cell;
+				for (size_t j = 0; j < nDim; j++) {
+					Long64_t k = rest % nBins[j];
+					rest /= nBins[j];
+					bin[j] = axes[j].lowerLimit ? k + 1 : nBins[j] - k;
+				}
+				result.ratios->SetBinContent(&bin[0], ratios[cell]);
+			}
+			Long64_t bestCell = -1;
+			for (int t = 0; t < nThreads; t++) {
+				if (threadBestCell[t] >= 0 && threadBestRatio[t] > result.bestRatio) {
+					result.bestRatio = threadBestRatio[t];
+					bestCell = threadBestCell[t];
+				}
+			}
+			if (bestCell < 0) return result;
+
+			TString bestCutString = "";
+			for (size_t j = 0; j < nDim; j++) {
+				Long64_t k = bestCell % nBins[j];
+				bestCell /= nBins[j];
+				double threshold = axes[j].lowerLimit ? sortedSteps[j][k] : sortedSteps[j][nBins[j] - 1 - k];
+				result.bestCuts.push_back(threshold);
+				if (j > 0) bestCutString += " && ";
+				bestCutString += TString::Format("%s %s %f", axes[j].quantity.Data(), axes[j].lowerLimit ? ">" : "<", threshold);
+			}
+			result.bestCut = bestCutString;
+			return result;
+		}
+	}
+
+	// Containers for data from a particle
+	const char * propertiesFieldNames[nPropertiesFields] = {"pt", "px", "py", "pz", "p", "e", "m", "chg", "pdg"};
+
+	Float_t properties::* propertiesFields[nPropertiesFields] = {&properties::pt, &properties::px, &properties::py, &properties::pz, &properties::p, &properties::E, &properties::m, &properties::chg, &properties::pdg};
+
+	const char * DInfoParticleNames[nDInfoParticles] = {"", "d0", "d1", "d2"};
+
+	properties DInfoContainer::* DInfoParticles[nDInfoParticles] = {&DInfoContainer::m, &DInfoContainer::d0, &DInfoContainer::d1, &DInfoContainer::d2};
+
+	std::vector<TString> daughterNames(int nDaughters) {
+		std::vector<TString> names;
+		for (int i = 0; i < nDaughters; i++) names.push_back(TString::Format("d%d", i));
+		return names;
+	}
+
+	branchStatus::branchStatus(TTree * tree) : valid(false) {
+		save(tree);
+	}
+
+	void branchStatus::save(TTree * tree) {
+		disabled.clear();
+		if (!tree->GetListOfLeaves()) tree->LoadTree(0);  // a TChain knows its branches only after loading a tree
+		TObjArray * leaves = tree->GetListOfLeaves();
+		valid = (leaves != 0);
+		if (!valid) return;
+		for (int i = 0; i < leaves->GetEntriesFast(); i++) {
+			TBranch * branch = static_cast<TLeaf *>(leaves->UncheckedAt(i))->GetBranch();
+			if (!tree->GetBranchStatus(branch->GetName())) disabled.push_back(branch->GetName());
+		}
+	}
+
+	void branchStatus::restore(TTree * tree) const {
+		tree->SetBranchStatus("*", 1);
+		for (size_t i = 0; i < disabled.size(); i++) tree->SetBranchStatus(disabled[i], 0);
+	}
+
+	std::vector<TString> bindBranches(TTree * tuple, andi::DInfoContainer & container, TString baseString, UInt_t fieldMask, bool pruneOthers, int nParticles, Long64_t cacheSize) {
+		properties * particles[nDInfoParticles];
+		std::vector<TString> particleNames;
+		for (int i = 0; i < nParticles && i < nDInfoParticles; i++) {
+			particles[i] = &(container.*DInfoParticles[i]);
+			particleNames.push_back(DInfoParticleNames[i]);
+		}
+		struct dereference {
+			properties ** p;
+			properties & operator[](size_t i) { return *p[i]; }
+		} particleRefs = {particles};
+		return bindBranches(tuple, particleRefs, baseString, particleNames, fieldMask, pruneOthers, cacheSize);
+	}
+
+	void unbindBranches(TTree * tuple, const std::vector<TString> & bound, const branchStatus & previous) {
+		for (size_t i = 0; i < bound.size(); i++) {
+			TBranch * branch = tuple->GetBranch(bound[i]);
+			if (branch) tuple->ResetBranchAddress(branch);
+		}
+		if (previous.valid) previous.restore(tuple);
+		else tuple->SetBranchStatus("*", 1);
+	}
+
+	void setBranchAddresses(TTree * tuple, andi::DInfoContainer & container, TString baseString, bool alsoDaugthers, UInt_t fieldMask, bool pruneOthers) {
+		bindBranches(tuple, container, baseString, fieldMask, pruneOthers, alsoDaugthers ? nDInfoParticles : 1);
+	}
+
+	// Columnar event store
+	const Float_t * propertiesColumns::field(int iField) const {
+		const Float_t * const fields[nPropertiesFields] = {pt, px, py, pz, p, E, m, chg, pdg};
+		return fields[iField];
+	}
+
+	const propertiesColumns & DColumnBatch::particle(int iParticle) const {
+		const propertiesColumns * particles[nDInfoParticles] = {&m, &d0, &d1, &d2};
+		return *particles[iParticle];
+	}
+
+	DColumnBatch columnBatch(const Float_t * const starts[nDInfoParticles][nPropertiesFields], Long64_t size, Long64_t first, Long64_t n) {
+		DColumnBatch b;
+		if (first > size) first = size;
+		if (n < 0 || first + n > size) n = size - first;
+		b.first = first;
+		b.size = n;
+		propertiesColumns * particles[nDInfoParticles] = {&b.m, &b.d0, &b.d1, &b.d2};
+		for (int iParticle = 0; iParticle < nDInfoParticles; iParticle++) {
+			const Float_t * pointers[nPropertiesFields];
+			for (int iField = 0; iField < nPropertiesFields; iField++) pointers[iField] = starts[iParticle][iField] ? starts[iParticle][iField] + first : 0;
+			propertiesColumns & c = *particles[iParticle];
+			c.pt = pointers[0]; c.px = pointers[1]; c.py = pointers[2]; c.pz = pointers[3]; c.p = pointers[4]; c.E = pointers[5];
+			c.m = pointers[6]; c.chg = pointers[7]; c.pdg = pointers[8];
+		}
+		return b;
+	}
+
+	void DColumnStore::resize(Long64_t newSize, UInt_t particleMask, UInt_t fieldMask) {
+		size = newSize;
+		for (int iParticle = 0; iParticle < nDInfoParticles; iParticle++) {
+			for (int iField = 0; iField < nPropertiesFields; iField++) {
+				alignedColumn & column = columns[iParticle][iField];
+				column.clear();
+				if ((particleMask & (1 << iParticle)) && (fieldMask & (1 << iField))) column.resize(newSize);
+				else column.shrink_to_fit();
+			}
+		}
+	}
+
+	DColumnBatch DColumnStore::batch(Long64_t first, Long64_t n) const {
+		const Float_t * starts[nDInfoParticles][nPropertiesFields];
+		for (int iParticle = 0; iParticle < nDInfoParticles; iParticle++) {
+			for (int iField = 0; iField < nPropertiesFields; iField++) {
+				const alignedColumn & column = columns[iParticle][iField];
+				starts[iParticle][iField] = column.empty() ? 0 : &column[0];
+			}
+		}
+		return columnBatch(starts, size, first, n);
+	}
+
+	Long64_t loadColumns(TTree * tuple, DColumnStore & store, TString baseString, bool alsoDaugthers, UInt_t fieldMask) {
+		scopedTimer timer("loadColumns");
+		scopedTreeStats treeStats(tuple);
+		DInfoContainer container;
+		int nParticles = alsoDaugthers ? nDInfoParticles : 1;
+		branchStatus status(tuple);
+		std::vector<TString> bound = bindBranches(tuple, container, baseString, fieldMask, true, nParticles);
+		Long64_t nEntries = entriesToProcess(tuple);
+		store.resize(nEntries, alsoDaugthers ? 0xF : 0x1, fieldMask);
+		for (Long64_t i = 0; i < nEntries; i++) {
+			tuple->GetEntry(tuple->GetEntryList() ? tuple->GetEntryNumber(i) : i);
+			for (int iParticle = 0; iParticle < nParticles; iParticle++) {
+				const properties & particle = container.*DInfoParticles[iParticle];
+				for (int iField = 0; iField < nPropertiesFields; iField++) {
+					if (fieldMask & (1 << iField)) store.columns[iParticle][iField][i] = particle.*propertiesFields[iField];
+				}
+			}
+		}
+		unbindBranches(tuple, bound, status);  // container is gone after this function
+		instruments().count("entries read", nEntries);
+		return nEntries;
+	}
+
+	void forEachBatch(const DColumnStore & store, const std::function<void(const DColumnBatch &)> & function, Long64_t batchSize) {
+		for (Long64_t first = 0; first < store.size; first += batchSize) function(store.batch(first, batchSize));
+	}
+
+	// Column cache files
+	columnCacheWriter::columnCacheWriter(TString fileName, Long64_t size, UInt_t particleMask, UInt_t fieldMask) : fileName(fileName), good(true) {
+		gSystem->ExpandPathName(this->fileName);
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, columnCacheMagic, sizeof(header.magic));
+		header.size = size;
+		header.particleMask = particleMask;
+		header.fieldMask = fieldMask;
+		Long64_t offset = (sizeof(header) + 63) / 64 * 64;
+		for (int iParticle = 0; iParticle < nDInfoParticles; iParticle++) {
+			for (int iField = 0; iField < nPropertiesFields; iField++) {
+				if (!(particleMask & (1 << iParticle)) || !(fieldMask & (1 << iField))) continue;
+				header.offsets[iParticle][iField] = offset;
+				offset += (size * (Long64_t) sizeof(Float_t) + 63) / 64 * 64;
+			}
+		}
+		header.length = offset;
+		fd = ::open(this->fileName + ".tmp", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0) {
+			std::cerr << "andi::columnCacheWriter: Could not create " << this->fileName << ".tmp" << std::endl;
+			good = false;
+		}
+	}
+
+	columnCacheWriter::~columnCacheWriter() {
+		if (fd >= 0) {
+			::close(fd);
+			unlink(fileName + ".tmp");
+		}
+	}
+
+	bool columnCacheWriter::write(const void * data, Long64_t bytes, Long64_t offset) {
+		const char * position = static_cast<const char *>(data);
+		while (good && bytes > 0) {
+			ssize_t written = pwrite(fd, position, bytes, offset);
+			if (written <= 0) {
+				std::cerr << "andi::columnCacheWriter: Could not write to " << fileName << ".tmp" << std::endl;
+				good = false;
+				break;
+			}
+			position += written;
+			bytes -= written;
+			offset += written;
+		}
+		return good;
+	}
+
+	bool columnCacheWriter::write(int iParticle, int iField, Long64_t first, const Float_t * values, Long64_t n) {
+		return write(values, n * sizeof(Float_t), header.offsets[iParticle][iField] + first * sizeof(Float_t));
+	}
+
+	bool columnCacheWriter::close() {
+		if (fd < 0) return false;
+		write(&header, sizeof(header), 0);
+		if (good && ftruncate(fd, header.length) != 0) good = false;
+		::close(fd);
+		fd = -1;
+		if (good && rename(fileName + ".tmp", fileName) != 0) {
+			std::cerr << "andi::columnCacheWriter: Could not rename " << fileName << ".tmp" << std::endl;
+			good = false;
+		}
+		if (!good) unlink(fileName + ".tmp");
+		return good;
+	}
+
+	Long64_t exportColumns(TTree * tuple, TString fileName, TString baseString, TCut selection, bool alsoDaugthers, UInt_t fieldMask) {
+		scopedTimer timer("exportColumns");
+		scopedTreeStats treeStats(tuple);
+		TEntryList * list = 0, * previousList = 0;
+		Long64_t nSelected = entriesToProcess(tuple);
+		if (TString(selection.GetTitle()) != "") {
+			list = preselectionList(tuple, selection);
+			if (!list) return -1;
+			previousList = tuple->GetEntryList();
+			tuple->SetEntryList(list);
+			nSelected = list->GetN();
+		}
+		int nParticles = alsoDaugthers ? nDInfoParticles : 1;
+		columnCacheWriter writer(fileName, nSelected, alsoDaugthers ? 0xF : 0x1, fieldMask);
+		DInfoContainer container;
+		branchStatus status(tuple);
+		std::vector<TString> bound = bindBranches(tuple, container, baseString, fieldMask, true, nParticles);
+		const Long64_t chunkSize = 65536;
+		std::vector<Float_t> chunks[nDInfoParticles][nPropertiesFields];
+		for (int iParticle = 0; iParticle < nParticles; iParticle++) {
+			for (int iField = 0; iField < nPropertiesFields; iField++) {
+				if (fieldMask & (1 << iField)) chunks[iParticle][iField].resize(chunkSize);
+			}
+		}
+		for (Long64_t i = 0; i < nSelected && writer.good; i++) {
+			tuple->GetEntry(tuple->GetEntryList() ? tuple->GetEntryNumber(i) : i);
+			Long64_t j = i % chunkSize;
+			for (int iParticle = 0; iParticle < nParticles; iParticle++) {
+				const properties & particle = container.*DInfoParticles[iParticle];
+				for (int iField = 0; iField < nPropertiesFields; iField++) {
+					if (fieldMask & (1 << iField)) chunks[iParticle][iField][j] = particle.*propertiesFields[iField];
+				}
+			}
+			if (j + 1 < chunkSize && i + 1 < nSelected) continue;
+			for (int iParticle = 0; iParticle < nParticles; iParticle++) {
+				for (int iField = 0; iField < nPropertiesFields; iField++) {
+					if (fieldMask & (1 << iField)) writer.write(iParticle, iField, i - j, &chunks[iParticle][iField][0], j + 1);
+				}
+			}
+		}
+		unbindBranches(tuple, bound, status);  // container is gone after this function
+		if (list) tuple->SetEntryList(previousList);
+		instruments().count("entries read", nSelected);
+		instruments().count("bytes written", writer.header.length);
+		return writer.close() ? nSelected : -1;
+	}
+
+	Long64_t exportColumns(const DColumnStore & store, TString fileName) {
+		scopedTimer timer("exportColumns");
+		UInt_t particleMask = 0, fieldMask = 0;
+		for (int iParticle = 0; iParticle < nDInfoParticles; iParticle++) {
+			for (int iField = 0; iField < nPropertiesFields; iField++) {
+				if (store.columns[iParticle][iField].empty()) continue;
+				particleMask |= 1 << iParticle;
+				fieldMask |= 1 << iField;
+			}
+		}
+		if (store.size == 0) particleMask = fieldMask = 0;
+		columnCacheWriter writer(fileName, store.size, particleMask, fieldMask);
+		for (int iParticle = 0; iParticle < nDInfoParticles; iParticle++) {
+			for (int iField = 0; iField < nPropertiesFields; iField++) {
+				if (!writer.header.offsets[iParticle][iField]) continue;
+				const alignedColumn & column = store.columns[iParticle][iField];
+				if (column.empty()) {
+					std::vector<Float_t> zeros(store.size, 0);  // particle and field are stored, but not this combination
+					writer.write(iParticle, iField, 0, &zeros[0], store.size);
+				} else {
+					writer.write(iParticle, iField, 0, &column[0], store.size);
+				}
+			}
+		}
+		instruments().count("bytes written", writer.header.length);
+		return writer.close() ? store.size : -1;
+	}
+
+	mappedColumnStore::mappedColumnStore() : size(0), data(0), length(0) {
+		memset(columns, 0, sizeof(columns));
+	}
+
+	mappedColumnStore::mappedColumnStore(TString fileName) : size(0), data(0), length(0) {
+		memset(columns, 0, sizeof(columns));
+		open(fileName);
+	}
+
+	mappedColumnStore::~mappedColumnStore() {
+		close();
+	}
+
+	bool mappedColumnStore::open(TString fileName) {
+		close();
+		gSystem->ExpandPathName(fileName);
+		int fd = ::open(fileName, O_RDONLY);
+		if (fd < 0) {
+			std::cerr << "andi::mappedColumnStore: Could not open " << fileName << std::endl;
+			return false;
+		}
+		struct stat fileStat;
+		if (fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t) sizeof(columnCacheHeader)) {
+			std::cerr << "andi::mappedColumnStore: " << fileName << " is no column cache file" << std::endl;
+			::close(fd);
+			return false;
+		}
+		void * mapped = mmap(0, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);  // the mapping stays valid
+		if (mapped == MAP_FAILED) {
+			std::cerr << "andi::mappedColumnStore: Could not map " << fileName << std::endl;
+			return false;
+		}
+		data = mapped;
+		length = fileStat.st_size;
+		const columnCacheHeader & header = *static_cast<const columnCacheHeader *>(data);
+		bool valid = (memcmp(header.magic, columnCacheMagic, sizeof(header.magic)) == 0) && header.size >= 0 && header.length == (Long64_t) length;
+		for (int iParticle = 0; iParticle < nDInfoParticles && valid; iParticle++) {
+			for (int iField = 0; iField < nPropertiesFields; iField++) {
+				Long64_t offset = header.offsets[iParticle][iField];
+				if (!offset) continue;
+				if (offset % 64 != 0 || offset + header.size * (Long64_t) sizeof(Float_t) > header.length) valid = false;
+				else columns[iParticle][iField] = reinterpret_cast<const Float_t *>(static_cast<const char *>(data) + offset);
+			}
+		}
+		if (!valid) {
+			std::cerr << "andi::mappedColumnStore: " << fileName << " is no valid column cache file (other version or incomplete?)" << std::endl;
+			close();
+			return false;
+		}
+		size = header.size;
+		instruments().count("files mapped");
+		return true;
+	}
+
+	void mappedColumnStore::close() {
+		if (data) munmap(data, length);
+		data = 0;
+		length = 0;
+		size = 0;
+		memset(columns, 0, sizeof(columns));
+	}
+
+	DColumnBatch mappedColumnStore::batch(Long64_t first, Long64_t n) const {
+		return columnBatch(columns, size, first, n);
+	}
+
+	void forEachBatch(const mappedColumnStore & store, const std::function<void(const DColumnBatch &)> & function, Long64_t batchSize) {
+		for (Long64_t first = 0; first < store.size; first += batchSize) function(store.batch(first, batchSize));
+	}
+
+	namespace cuts {
+
+		// Compiled cuts
+		/**
+		 * @brief Right operand of a binary instruction which is the same for all entries
+		 */
+		struct scalarOperand {
+			double value;
+			double operator[](Long64_t) const { return value; }
+		};
+		/**
+		 * @brief Applies a binary instruction to a whole batch: a[i] = a[i] op right[i]
+		 */
+		template <typename Right>
+		void compiledCutBinary(int op, double * a, Right right, Long64_t n) {
+			switch (op) {
+				case kOpAdd: for (Long64_t i = 0; i < n; i++) a[i] = a[i] + right[i]; break;
+				case kOpSubtract: for (Long64_t i = 0; i < n; i++) a[i] = a[i] - right[i]; break;
+				case kOpMultiply: for (Long64_t i = 0; i < n; i++) a[i] = a[i] * right[i]; break;
+				case kOpDivide: for (Long64_t i = 0; i < n; i++) a[i] = a[i] / right[i]; break;
+				case kOpLess: for (Long64_t i = 0; i < n; i++) a[i] = a[i] < right[i]; break;
+				case kOpLessEqual: for (Long64_t i = 0; i < n; i++) a[i] = a[i] <= right[i]; break;
+				case kOpGreater: for (Long64_t i = 0; i < n; i++) a[i] = a[i] > right[i]; break;
+				case kOpGreaterEqual: for (Long64_t i = 0; i < n; i++) a[i] = a[i] >= right[i]; break;
+				case kOpEqual: for (Long64_t i = 0; i < n; i++) a[i] = a[i] == right[i]; break;
+				case kOpNotEqual: for (Long64_t i = 0; i < n; i++) a[i] = a[i] != right[i]; break;
+				case kOpAnd: for (Long64_t i = 0; i < n; i++) a[i] = (a[i] != 0) & (right[i] != 0); break;
+				case kOpOr: for (Long64_t i = 0; i < n; i++) a[i] = (a[i] != 0) | (right[i] != 0); break;
+			}
+		}
+
+		compiledCut::compiledCut(TString expression, TString baseString) : expression(expression), baseString(baseString), nParameters(0), particleMask(0), fieldMask(0), maxDepth(0), valid(true), position(0) {
+			parseOr();
+			skipSpaces();
+			if (valid && position < expression.Length()) fail("unexpected character");
+			int depth = 0;
+			for (size_t k = 0; k < program.size(); k++) {
+				if (program[k].op <= kOpParameter) depth++;
+				else if (program[k].op <= kOpOr && program[k].operand == kOperandStack) depth--;
+				maxDepth = std::max(maxDepth, depth);
+			}
+			if (valid && depth != 1) fail("incomplete expression");
+		}
+
+		const double * compiledCut::values(const DColumnBatch & b, const double * parameters, std::vector<double> & workspace) const {
+			if (!valid || b.size == 0) return 0;
+			Long64_t n = b.size;
+			if ((Long64_t) workspace.size() < maxDepth * n) workspace.resize(maxDepth * n);
+			int depth = 0;
+			for (size_t k = 0; k < program.size(); k++) {
+				const compiledCutOp & o = program[k];
+				double * top = &workspace[0] + (depth - 1) * n;  // only valid for depth > 0
+				if (o.op <= kOpParameter) {
+					double * pushed = top + n;
+					if (o.op == kOpColumn) {
+						const Float_t * column = b.particle(o.index / nPropertiesFields).field(o.index % nPropertiesFields);
+						if (!column) {
+							std::cerr << "andi::cuts::compiledCut: Column " << baseString << DInfoParticleNames[o.index / nPropertiesFields] << propertiesFieldNames[o.index % nPropertiesFields] << " of " << expression << " is not loaded" << std::endl;
+							return 0;
+						}
+						for (Long64_t i = 0; i < n; i++) pushed[i] = column[i];
+					} else {
+						double value = (o.op == kOpConstant) ? o.value : parameters[o.index];
+						for (Long64_t i = 0; i < n; i++) pushed[i] = value;
+					}
+					depth++;
+				} else if (o.op <= kOpOr) {
+					if (o.operand == kOperandStack) {
+						compiledCutBinary(o.op, top - n, (const double *) top, n);
+						depth--;
+					} else {
+						scalarOperand right = {(o.operand == kOperandConstant) ? o.value : parameters[o.index]};
+						compiledCutBinary(o.op, top, right, n);
+					}
+				} else {
+					switch (o.op) {
+						case kOpNegate: for (Long64_t i = 0; i < n; i++) top[i] = -top[i]; break;
+						case kOpNot: for (Long64_t i = 0; i < n; i++) top[i] = top[i] == 0; break;
+						case kOpAbs: for (Long64_t i = 0; i < n; i++) top[i] = std::fabs(top[i]); break;
+						case kOpSqrt: for (Long64_t i = 0; i < n; i++) top[i] = std::sqrt(top[i]); break;
+					}
+				}
+			}
+			return &workspace[0];
+		}
+
+		Long64_t compiledCut::evaluate(const DColumnBatch & b, const double * parameters, std::vector<double> & workspace, char * passed) const {
+			if (!valid) return -1;
+			if (b.size == 0) return 0;
+			const double * result = values(b, parameters, workspace);
+			if (!result) return -1;
+			Long64_t nPassed = 0;
+			for (Long64_t i = 0; i < b.size; i++) nPassed += result[i] != 0;
+			if (passed) {
+				for (Long64_t i = 0; i < b.size; i++) passed[i] = result[i] != 0;
+			}
+			return nPassed;
+		}
+
+		int compiledCut::nParticles() const {
+			int n = 0;
+			for (int iParticle = 0; iParticle < nDInfoParticles; iParticle++) if (particleMask & (1 << iParticle)) n = iParticle + 1;
+			return n;
+		}
+
+		void compiledCut::fail(TString message) {
+			if (valid) std::cerr << "andi::cuts::compiledCut: Could not compile " << expression << ": " << message << " at position " << position << std::endl;
+			valid = false;
+			position = expression.Length();
+		}
+
+		void compiledCut::skipSpaces() {
+			while (position < expression.Length() && isspace(expression[position])) position++;
+		}
+
+		bool compiledCut::accept(const char * token) {
+			skipSpaces();
+			Ssiz_t length = strlen(token);
+			if (TString(expression(position, length)) != token) return false;
+			position += length;
+			return true;
+		}
+
+		void compiledCut::emit(int op, int index, double value) {
+			compiledCutOp o = {op, kOperandStack, index, value};
+			program.push_back(o);
+		}
+
+		void compiledCut::emitBinary(int op) {
+			if (!valid) return;
+			compiledCutOp & last = program.back();
+			if (program.size() >= 2 && (last.op == kOpConstant || last.op == kOpParameter)) {
+				last.operand = (last.op == kOpConstant) ? kOperandConstant : kOperandParameter;
+				last.op = op;
+			} else {
+				emit(op);
+			}
+		}
+
+		void compiledCut::parseOr() {
+			parseAnd();
+			while (valid && accept("||")) {
+				parseAnd();
+				emitBinary(kOpOr);
+			}
+		}
+
+		void compiledCut::parseAnd() {
+			parseComparison();
+			while (valid && accept("&&")) {
+				parseComparison();
+				emitBinary(kOpAnd);
+			}
+		}
+
+		void compiledCut::parseComparison() {
+			parseSum();
+			const char * tokens[6] = {"<=", ">=", "==", "!=", "<", ">"};
+			const int ops[6] = {kOpLessEqual, kOpGreaterEqual, kOpEqual, kOpNotEqual, kOpLess, kOpGreater};
+			for (int i = 0; i < 6 && valid; i++) {
+				if (!accept(tokens[i])) continue;
+				parseSum();
+				emitBinary(ops[i]);
+				break;
+			}
+		}
+
+		void compiledCut::parseSum() {
+			parseProduct();
+			while (valid) {
+				if (accept("+")) {
+					parseProduct();
+					emitBinary(kOpAdd);
+				} else if (accept("-")) {
+					parseProduct();
+					emitBinary(kOpSubtract);
+				} else break;
+			}
+		}
+
+		void compiledCut::parseProduct() {
+			parseUnary();
+			while (valid) {
+				if (accept("*")) {
+					parseUnary();
+					emitBinary(kOpMultiply);
+				} else if (accept("/")) {
+					parseUnary();
+					emitBinary(kOpDivide);
+				} else break;
+			}
+		}
+
+		void compiledCut::parseUnary() {
+			if (accept("-")) {
+				parseUnary();
+				emit(kOpNegate);
+			} else if (accept("!") ) {
+				parseUnary();
+				emit(kOpNot);
+			} else {
+				parsePrimary();
+			}
+		}
+
+		void compiledCut::parsePrimary() {
+			skipSpaces();
+			if (!valid) return;
+			if (position >= expression.Length()) return fail("unexpected end");
+			char c = expression[position];
+			if (accept("(")) {
+				parseOr();
+				if (valid && !accept(")")) fail("missing )");
+			} else if (accept("[")) {
+				Ssiz_t start = position;
+				while (position < expression.Length() && isdigit(expression[position])) position++;
+				if (position == start || !accept("]")) return fail("bad parameter");
+				int index = TString(expression(start, position - 1 - start)).Atoi();
+				nParameters = std::max(nParameters, index + 1);
+				emit(kOpParameter, index);
+			} else if (isdigit(c) || c == '.') {
+				const char * begin = expression.Data() + position;
+				char * end = 0;
+				double value = strtod(begin, &end);
+				position += end - begin;
+				emit(kOpConstant, 0, value);
+			} else if (isalpha(c) || c == '_') {
+				Ssiz_t start = position;
+				while (position < expression.Length() && (isalnum(expression[position]) || expression[position] == '_')) position++;
+				TString name = expression(start, position - start);
+				if (name == "abs" || name == "fabs" || name == "sqrt") {
+					if (!accept("(")) return fail("missing ( after " + name);
+					parseOr();
+					if (valid && !accept(")")) return fail("missing )");
+					emit((name == "sqrt") ? kOpSqrt : kOpAbs);
+					return;
+				}
+				for (int iParticle = 0; iParticle < nDInfoParticles; iParticle++) {
+					for (int iField = 0; iField < nPropertiesFields; iField++) {
+						if (name != baseString + DInfoParticleNames[iParticle] + propertiesFieldNames[iField]) continue;
+						particleMask |= 1 << iParticle;
+						fieldMask |= 1 << iField;
+						emit(kOpColumn, iParticle * nPropertiesFields + iField);
+						return;
+					}
+				}
+				fail("unknown column " + name);
+			} else {
+				fail("unexpected character");
+			}
+		}
+
+		Long64_t countPassing(TTree * tree, const compiledCut & cut, const std::vector<double> & parameters, Long64_t batchSize) {
+			scopedTimer timer("cuts::countPassing");
+			if (!cut.valid) return -1;
+			if ((int) parameters.size() < cut.nParameters) {
+				std::cerr << "andi::cuts::countPassing: " << cut.expression << " needs " << cut.nParameters << " parameters, got " << parameters.size() << std::endl;
+				return -1;
+			}
+			DInfoContainer container;
+			branchStatus status(tree);
+			std::vector<TString> bound = bindBranches(tree, container, cut.baseString, cut.fieldMask, true, cut.nParticles());
+			DColumnStore chunk;
+			chunk.resize(batchSize, cut.particleMask, cut.fieldMask);
+			std::vector<double> workspace;
+			Long64_t nEntries = entriesToProcess(tree), nPassed = 0, filled = 0;
+			for (Long64_t i = 0; i < nEntries && nPassed >= 0; i++) {
+				tree->GetEntry(tree->GetEntryList() ? tree->GetEntryNumber(i) : i);
+				for (int iParticle = 0; iParticle < cut.nParticles(); iParticle++) {
+					const properties & particle = container.*DInfoParticles[iParticle];
+					for (int iField = 0; iField < nPropertiesFields; iField++) {
+						if ((cut.particleMask & (1 << iParticle)) && (cut.fieldMask & (1 << iField))) chunk.columns[iParticle][iField][filled] = particle.*propertiesFields[iField];
+					}
+				}
+				if (++filled < batchSize && i + 1 < nEntries) continue;
+				Long64_t n = cut.evaluate(chunk.batch(0, filled), parameters.empty() ? 0 : &parameters[0], workspace);
+				nPassed = (n < 0) ? -1 : nPassed + n;
+				filled = 0;
+			}
+			unbindBranches(tree, bound, status);  // container is gone after this function
+			instruments().count("entries read", nEntries);
+			return nPassed;
+		}
+
+		Long64_t loadSelectedColumns(TTree * tree, DColumnStore & store, TString baseString, TCut defaultCut, UInt_t particleMask, UInt_t fieldMask) {
+			TEntryList * previous = tree->GetEntryList();
+			if (TString(defaultCut.GetTitle()) != "") applyPreselection(tree, defaultCut);
+			Long64_t nEntries = loadColumns(tree, store, baseString, particleMask > 1, fieldMask);
+			tree->SetEntryList(previous);
+			return nEntries;
+		}
+
+		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, const compiledCut & cut, std::vector<double> steps, double & bestRatio, TCut defaultCut, int nThreads) {
+			DColumnStore stores[2];
+			if (cut.valid) {
+				loadSelectedColumns(treeSig, stores[0], cut.baseString, defaultCut, cut.particleMask, cut.fieldMask);
+				loadSelectedColumns(treeBkg, stores[1], cut.baseString, defaultCut, cut.particleMask, cut.fieldMask);
+			}
+			return cutBenchmark(stores[0], stores[1], scaleFactorBkg, cut, steps, bestRatio, nThreads);
+		}
+
+		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, const compiledCut & cut, std::pair<double, double> rangeLimits, Int_t numberOfSteps, TCut defaultCut, int nThreads) {
+			DColumnStore stores[2];
+			if (cut.valid) {
+				loadSelectedColumns(treeSig, stores[0], cut.baseString, defaultCut, cut.particleMask, cut.fieldMask);
+				loadSelectedColumns(treeBkg, stores[1], cut.baseString, defaultCut, cut.particleMask, cut.fieldMask);
+			}
+			return cutBenchmark(stores[0], stores[1], scaleFactorBkg, cut, rangeLimits, numberOfSteps, nThreads);
+		}
+
+		TGraph * cutBenchmarkSymmetric(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, const compiledCut & cut, double centralValue, double rangeLimit, Int_t numberOfSteps, double & _lowerLimit, double & _upperLimit, TCut defaultCut, int nThreads) {
+			DColumnStore stores[2];
+			if (cut.valid) {
+				loadSelectedColumns(treeSig, stores[0], cut.baseString, defaultCut, cut.particleMask, cut.fieldMask);
+				loadSelectedColumns(treeBkg, stores[1], cut.baseString, defaultCut, cut.particleMask, cut.fieldMask);
+			}
+			return cutBenchmarkSymmetric(stores[0], stores[1], scaleFactorBkg, cut, centralValue, rangeLimit, numberOfSteps, _lowerLimit, _upperLimit, nThreads);
+		}
+
+		gridResult cutBenchmarkGrid(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, const compiledCut & cut, const std::vector<std::vector<double> > & steps, TCut defaultCut, int nThreads, Long64_t maxCells) {
+			DColumnStore stores[2];
+			if (cut.valid) {
+				loadSelectedColumns(treeSig, stores[0], cut.baseString, defaultCut, cut.particleMask, cut.fieldMask);
+				loadSelectedColumns(treeBkg, stores[1], cut.baseString, defaultCut, cut.particleMask, cut.fieldMask);
+			}
+			return cutBenchmarkGrid(stores[0], stores[1], scaleFactorBkg, cut, steps, nThreads, maxCells);
+		}
+
+		// Tree ensembles
+		treeEnsemble::treeEnsemble(TString fileName) : baseString("D"), baseScore(0), logistic(false), particleMask(0), fieldMask(0), valid(false) {
+			gSystem->ExpandPathName(fileName);
+			std::ifstream file(fileName.Data());
+			if (!file) std::cerr << "andi::cuts::treeEnsemble: Could not open " << fileName << std::endl;
+			else read(file);
+		}
+
+		bool treeEnsemble::read(std::istream & input) {
+			variables.clear();
+			nodes.clear();
+			roots.clear();
+			baseScore = 0;
+			logistic = false;
+			valid = true;
+			double fileBaseScore = 0;
+			bool hasBaseScore = false;
+			std::string line;
+			int lineNumber = 0;
+			std::vector<std::pair<int, ensembleNode> > treeNodes;  // id in the tree, node with ids as children
+			while (valid && std::getline(input, line)) {
+				lineNumber++;
+				size_t start = line.find_first_not_of(" \t\r");
+				if (start == std::string::npos || line[start] == '#') continue;
+				line = line.substr(start, line.find_last_not_of(" \t\r") + 1 - start);
+				if (line.compare(0, 7, "booster") == 0) {
+					valid = addTree(treeNodes, lineNumber);
+					treeNodes.clear();
+					roots.push_back(-1);  // filled by addTree()
+					continue;
+				}
+				size_t space = line.find(' ');
+				std::string key = line.substr(0, space), value = (space == std::string::npos) ? "" : line.substr(space + 1);
+				if (roots.empty()) {
+					if (key == "baseString") baseString = value.c_str();
+					else if (key == "variable") valid = addVariable(value.c_str()) >= 0;
+					else if (key == "base_score") fileBaseScore = atof(value.c_str()), hasBaseScore = true;
+					else if (key == "objective") logistic = (value.find("logistic") != std::string::npos);
+					else valid = fail("unknown key " + key, lineNumber);
+					continue;
+				}
+				std::pair<int, ensembleNode> node;
+				valid = parseNode(line, node, lineNumber);
+				treeNodes.push_back(node);
+			}
+			if (valid) valid = addTree(treeNodes, lineNumber);
+			if (valid && roots.empty()) valid = fail("no trees", lineNumber);
+			if (valid && hasBaseScore) {
+				// the objective may come after base_score, so it is converted only here
+				if (!logistic) baseScore = fileBaseScore;
+				else if (fileBaseScore > 0 && fileBaseScore < 1) baseScore = std::log(fileBaseScore / (1 - fileBaseScore));
+				else valid = fail("base_score of a logistic objective must be a probability in (0, 1)", lineNumber);
+			}
+			for (size_t i = 0; i < variables.size(); i++) {
+				particleMask |= variables[i].particleMask;
+				fieldMask |= variables[i].fieldMask;
+			}
+			return valid;
+		}
+
+		bool treeEnsemble::score(const DColumnBatch & b, Float_t * scores, ensembleWorkspace & workspace) const {
+			if (!valid) return false;
+			Long64_t n = b.size;
+			if (n == 0) return true;
+			workspace.features.resize(variables.size() * n);
+			for (size_t iFeature = 0; iFeature < variables.size(); iFeature++) {
+				const double * values = variables[iFeature].values(b, 0, workspace.stack);
+				if (!values) return false;
+				Float_t * feature = &workspace.features[iFeature * n];
+				for (Long64_t i = 0; i < n; i++) feature[i] = values[i];
+			}
+			workspace.sums.assign(n, baseScore);
+			const ensembleNode * allNodes = &nodes[0];
+			const Float_t * features = workspace.features.empty() ? 0 : &workspace.features[0];
+			double * sums = &workspace.sums[0];
+			for (size_t iTree = 0; iTree < roots.size(); iTree++) {
+				const Int_t root = roots[iTree];
+				for (Long64_t i = 0; i < n; i++) {
+					const ensembleNode * node = allNodes + root;
+					while (node->feature >= 0) {
+						Float_t x = features[node->feature * n + i];
+						node = allNodes + ((x < node->threshold) ? node->yes : ((x >= node->threshold) ? node->no : node->missing));
+					}
+					sums[i] += node->threshold;
+				}
+			}
+			for (Long64_t i = 0; i < n; i++) scores[i] = logistic ? 1 / (1 + std::exp(-sums[i])) : sums[i];
+			return true;
+		}
+
+		bool treeEnsemble::fail(std::string message, int lineNumber) {
+			std::cerr << "andi::cuts::treeEnsemble: " << message << " (line " << lineNumber << ")" << std::endl;
+			return false;
+		}
+
+		int treeEnsemble::addVariable(TString expression) {
+			compiledCut variable(expression, baseString);
+			if (!variable.valid) return -1;
+			if (variable.nParameters > 0) {
+				std::cerr << "andi::cuts::treeEnsemble: Variable " << expression << " must not have parameters" << std::endl;
+				return -1;
+			}
+			variables.push_back(variable);
+			return variables.size() - 1;
+		}
+
+		bool treeEnsemble::parseNode(const std::string & line, std::pair<int, ensembleNode> & node, int lineNumber) {
+			size_t colon = line.find(':');
+			if (colon == std::string::npos) return fail("no node: " + line, lineNumber);
+			node.first = atoi(line.substr(0, colon).c_str());
+			ensembleNode & n = node.second;
+			std::string rest = line.substr(colon + 1);
+			if (rest.compare(0, 5, "leaf=") == 0) {
+				n.feature = -1;
+				n.threshold = strtod(rest.c_str() + 5, 0);
+				n.yes = n.no = n.missing = -1;
+				return true;
+			}
+			size_t less = rest.find('<'), close = rest.find(']');
+			if (rest[0] != '[' || less == std::string::npos || close == std::string::npos || close < less) return fail("bad split: " + line, lineNumber);
+			std::string name = rest.substr(1, less - 1);
+			n.threshold = strtod(rest.c_str() + less + 1, 0);
+			n.feature = -1;
+			for (size_t i = 0; i < variables.size(); i++) {
+				if (name == variables[i].expression.Data()) n.feature = i;
+			}
+			if (n.feature < 0 && name.size() > 1 && name[0] == 'f' && name.find_first_not_of("0123456789", 1) == std::string::npos) {
+				n.feature = atoi(name.c_str() + 1);
+				if (n.feature >= (int) variables.size()) return fail("undeclared variable " + name, lineNumber);
+			}
+			if (n.feature < 0) n.feature = addVariable(name.c_str());
+			if (n.feature < 0) return fail("bad variable " + name, lineNumber);
+			n.missing = -1;
+			if (sscanf(rest.c_str() + close + 1, " yes=%d,no=%d,missing=%d", &n.yes, &n.no, &n.missing) < 2) return fail("bad children: " + line, lineNumber);
+			if (n.missing < 0) n.missing = n.yes;
+			return true;
+		}
+
+		bool treeEnsemble::addTree(const std::vector<std::pair<int, ensembleNode> > & treeNodes, int lineNumber) {
+			if (roots.empty()) return true;  // header only so far
+			if (treeNodes.empty()) return fail("empty tree", lineNumber);
+			int maxId = 0;
+			for (size_t i = 0; i < treeNodes.size(); i++) maxId = std::max(maxId, treeNodes[i].first);
+			Int_t offset = nodes.size();
+			std::vector<char> defined(maxId + 1, 0);
+			nodes.resize(offset + maxId + 1);
+			for (size_t i = 0; i < treeNodes.size(); i++) {
+				if (treeNodes[i].first < 0 || defined[treeNodes[i].first]) return fail("bad or repeated node id", lineNumber);
+				defined[treeNodes[i].first] = 1;
+				nodes[offset + treeNodes[i].first] = treeNodes[i].second;
+			}
+			for (int id = 0; id <= maxId; id++) {
+				ensembleNode & n = nodes[offset + id];
+				if (!defined[id]) {
+					n.feature = -1;  // unused id, never reached
+					n.threshold = 0;
+					n.yes = n.no = n.missing = -1;
+					continue;
+				}
+				if (n.feature < 0) continue;
+				const Int_t children[3] = {n.yes, n.no, n.missing};
+				for (int c = 0; c < 3; c++) {
+					if (children[c] <= id || children[c] > maxId || !defined[children[c]]) return fail(TString::Format("node %d has a bad child", id).Data(), lineNumber);
+				}
+				n.yes += offset;
+				n.no += offset;
+				n.missing += offset;
+			}
+			roots.back() = offset;
+			return true;
+		}
+
+		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, const treeEnsemble & ensemble, std::vector<double> steps, double & bestRatio, TCut defaultCut, int nThreads) {
+			scopedTimer timer("cuts::cutBenchmark");
+			std::vector<double> columns[2];
+			TTree * trees[2] = {treeSig, treeBkg};
+			for (int k = 0; k < 2 && ensemble.valid; k++) {
+				DColumnStore store;
+				loadSelectedColumns(trees[k], store, ensemble.baseString, defaultCut, ensemble.particleMask, ensemble.fieldMask);
+				columns[k] = sortedScores(store, ensemble, nThreads);
+			}
+			return cutBenchmark(columns[0], columns[1], scaleFactorBkg, steps, bestRatio);
+		}
+	}
+
+	// Batch kinematics
+	int simdLevel() {
+#ifdef ANDI_SIMD_X86
+		static int level = __builtin_cpu_supports("avx512f") ? 2 : ((__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? 1 : 0);
+		return level;
+#else
+		return 0;
+#endif
+	}
+
+	void massOfSumScalar(Long64_t n, int nParticles, const Float_t * const * px, const Float_t * const * py, const Float_t * const * pz, const Float_t * const * E, Float_t * out, Long64_t first) {
+		for (Long64_t i = first; i < n; i++) {
+			Float_t sx = 0, sy = 0, sz = 0, sE = 0;
+			for (int j = 0; j < nParticles; j++) {
+				sx += px[j][i];
+				sy += py[j][i];
+				sz += pz[j][i];
+				sE += E[j][i];
+			}
+			Float_t m2 = sE * sE - sx * sx - sy * sy - sz * sz;
+			out[i] = (m2 < 0) ? -std::sqrt(-m2) : std::sqrt(m2);
+		}
+	}
+#ifdef ANDI_SIMD_X86
+	/**
+	 * @brief Invariant mass of the sum of nParticles four-vectors, AVX2 version; see massOfSum()
+	 */
+	__attribute__((target("avx2,fma"))) void massOfSumAVX2(Long64_t n, int nParticles, const Float_t * const * px, const Float_t * const * py, const Float_t * const * pz, const Float_t * const * E, Float_t * out) {
+		const __m256 signBit = _mm256_set1_ps(-0.f);
+		Long64_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 sx = _mm256_setzero_ps(), sy = _mm256_setzero_ps(), sz = _mm256_setzero_ps(), sE = _mm256_setzero_ps();
+			for (int j = 0; j < nParticles; j++) {
+				sx = _mm256_add_ps(sx, _mm256_loadu_ps(px[j] + i));
+				sy = _mm256_add_ps(sy, _mm256_loadu_ps(py[j] + i));
+				sz = _mm256_add_ps(sz, _mm256_loadu_ps(pz[j] + i));
+				sE = _mm256_add_ps(sE, _mm256_loadu_ps(E[j] + i));
+			}
+			__m256 m2 = _mm256_mul_ps(sE, sE);
+			m2 = _mm256_fnmadd_ps(sx, sx, m2);
+			m2 = _mm256_fnmadd_ps(sy, sy, m2);
+			m2 = _mm256_fnmadd_ps(sz, sz, m2);
+			__m256 m = _mm256_sqrt_ps(_mm256_andnot_ps(signBit, m2));  // sqrt(|m2|) ...
+			_mm256_storeu_ps(out + i, _mm256_or_ps(m, _mm256_and_ps(signBit, m2)));  // ... with the sign of m2
+		}
+		massOfSumScalar(n, nParticles, px, py, pz, E, out, i);
+	}
+	/**
+	 * @brief Invariant mass of the sum of nParticles four-vectors, AVX-512 version; see massOfSum()
+	 */
+	__attribute__((target("avx512f"))) void massOfSumAVX512(Long64_t n, int nParticles, const Float_t * const * px, const Float_t * const * py, const Float_t * const * pz, const Float_t * const * E, Float_t * out) {
+		const __m512i signBit = _mm512_set1_epi32(0x80000000);
+		Long64_t i = 0;
+		for (; i + 16 <= n; i += 16) {
+			__m512 sx = _mm512_setzero_ps(), sy = _mm512_setzero_ps(), sz = _mm512_setzero_ps(), sE = _mm512_setzero_ps();
+			for (int j = 0; j < nParticles; j++) {
+				sx = _mm512_add_ps(sx, _mm512_loadu_ps(px[j] + i));
+				sy = _mm512_add_ps(sy, _mm512_loadu_ps(py[j] + i));
+				sz = _mm512_add_ps(sz, _mm512_loadu_ps(pz[j] + i));
+				sE = _mm512_add_ps(sE, _mm512_loadu_ps(E[j] + i));
+			}
+			__m512 m2 = _mm512_mul_ps(sE, sE);
+			m2 = _mm512_fnmadd_ps(sx, sx, m2);
+			m2 = _mm512_fnmadd_ps(sy, sy, m2);
+			m2 = _mm512_fnmadd_ps(sz, sz, m2);
+			__m512 m = _mm512_sqrt_ps(_mm512_abs_ps(m2));
+			__m512i sign = _mm512_and_epi32(_mm512_castps_si512(m2), signBit);
+			_mm512_storeu_ps(out + i, _mm512_castsi512_ps(_mm512_or_epi32(_mm512_castps_si512(m), sign)));
+		}
+		massOfSumScalar(n, nParticles, px, py, pz, E, out, i);
+	}
+	/**
+	 * @brief Transverse (z = 0) or total momentum, AVX2 version; see momentum()
+	 */
+	__attribute__((target("avx2,fma"))) void momentumAVX2(Long64_t n, const Float_t * px, const Float_t * py, const Float_t * pz, Float_t * out) {
+		Long64_t i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m256 x = _mm256_loadu_ps(px + i), y = _mm256_loadu_ps(py + i);
+			__m256 p2 = _mm256_fmadd_ps(y, y, _mm256_mul_ps(x, x));
+			if (pz) {
+				__m256 z = _mm256_loadu_ps(pz + i);
+				p2 = _mm256_fmadd_ps(z, z, p2);
+			}
+			_mm256_storeu_ps(out + i, _mm256_sqrt_ps(p2));
+		}
+		for (; i < n; i++) out[i] = std::sqrt(px[i] * px[i] + py[i] * py[i] + (pz ? pz[i] * pz[i] : 0));
+	}
+	/**
+	 * @brief Transverse (z = 0) or total momentum, AVX-512 version; see momentum()
+	 */
+	__attribute__((target("avx512f"))) void momentumAVX512(Long64_t n, const Float_t * px, const Float_t * py, const Float_t * pz, Float_t * out) {
+		Long64_t i = 0;
+		for (; i + 16 <= n; i += 16) {
+			__m512 x = _mm512_loadu_ps(px + i), y = _mm512_loadu_ps(py + i);
+			__m512 p2 = _mm512_fmadd_ps(y, y, _mm512_mul_ps(x, x));
+			if (pz) {
+				__m512 z = _mm512_loadu_ps(pz + i);
+				p2 = _mm512_fmadd_ps(z, z, p2);
+			}
+			_mm512_storeu_ps(out + i, _mm512_sqrt_ps(p2));
+		}
+		for (; i < n; i++) out[i] = std::sqrt(px[i] * px[i] + py[i] * py[i] + (pz ? pz[i] * pz[i] : 0));
+	}
+#endif
+
+	void massOfSum(Long64_t n, int nParticles, const Float_t * const * px, const Float_t * const * py, const Float_t * const * pz, const Float_t * const * E, Float_t * out) {
+#ifdef ANDI_SIMD_X86
+		if (simdLevel() == 2) return massOfSumAVX512(n, nParticles, px, py, pz, E, out);
+		if (simdLevel() == 1) return massOfSumAVX2(n, nParticles, px, py, pz, E, out);
+#endif
+		massOfSumScalar(n, nParticles, px, py, pz, E, out);
+	}
+
+	void momentum(Long64_t n, const Float_t * px, const Float_t * py, const Float_t * pz, Float_t * out) {
+#ifdef ANDI_SIMD_X86
+		if (simdLevel() == 2) return momentumAVX512(n, px, py, pz, out);
+		if (simdLevel() == 1) return momentumAVX2(n, px, py, pz, out);
+#endif
+		for (Long64_t i = 0; i < n; i++) out[i] = std::sqrt(px[i] * px[i] + py[i] * py[i] + (pz ? pz[i] * pz[i] : 0));
+	}
+
+	bool batchMass(const DColumnBatch & b, std::vector<int> particles, Float_t * out) {
+		std::vector<const Float_t *> px, py, pz, E;
+		for (size_t j = 0; j < particles.size(); j++) {
+			const propertiesColumns & c = b.particle(particles[j]);
+			if (!c.px || !c.py || !c.pz || !c.E) {
+				std::cerr << "andi::batchMass: px, py, pz and E of particle " << particles[j] << " need to be loaded" << std::endl;
+				return false;
+			}
+			px.push_back(c.px);
+			py.push_back(c.py);
+			pz.push_back(c.pz);
+			E.push_back(c.E);
+		}
+		if (particles.empty()) return false;
+		massOfSum(b.size, particles.size(), &px[0], &py[0], &pz[0], &E[0], out);
+		return true;
+	}
+
+	bool batchPairMass(const DColumnBatch & b, int iParticleA, int iParticleB, Float_t * out) {
+		return batchMass(b, {iParticleA, iParticleB}, out);
+	}
+
+	bool batchThreeBodyMass(const DColumnBatch & b, Float_t * out) {
+		return batchMass(b, {1, 2, 3}, out);
+	}
+
+	bool batchPt(const DColumnBatch & b, int iParticle, Float_t * out) {
+		const propertiesColumns & c = b.particle(iParticle);
+		if (!c.px || !c.py) return false;
+		momentum(b.size, c.px, c.py, 0, out);
+		return true;
+	}
+
+	bool batchP(const DColumnBatch & b, int iParticle, Float_t * out) {
+		const propertiesColumns & c = b.particle(iParticle);
+		if (!c.px || !c.py || !c.pz) return false;
+		momentum(b.size, c.px, c.py, c.pz, out);
+		return true;
+	}
+
+	// Unbinned Gauss Fits
+	gaussLikelihoodSums::gaussLikelihoodSums() : logP(0) {
+		for (int i = 0; i < 2; i++) w[i] = wd[i] = wd2[i] = 0;
+	}
+
+	void gaussLikelihoodSums::add(const gaussLikelihoodSums & other) {
+		logP += other.logP;
+		for (int i = 0; i < 2; i++) {
+			w[i] += other.w[i];
+			wd[i] += other.wd[i];
+			wd2[i] += other.wd2[i];
+		}
+	}
+
+	void gaussLikelihoodSumsScalar(const double * values, Long64_t first, Long64_t last, const double * norm, const double * mean, const double * halfInverseVariance, gaussLikelihoodSums & sums) {
+		for (Long64_t i = first; i < last; i++) {
+			double d0 = values[i] - mean[0], d1 = values[i] - mean[1];
+			double g0 = norm[0] * std::exp(-d0 * d0 * halfInverseVariance[0]);
+			double g1 = norm[1] * std::exp(-d1 * d1 * halfInverseVariance[1]);
+			double p = std::max(g0 + g1, 1e-300);
+			double w0 = g0 / p, w1 = g1 / p;
+			sums.logP += std::log(p);
+			sums.w[0] += w0;
+			sums.wd[0] += w0 * d0;
+			sums.wd2[0] += w0 * d0 * d0;
+			sums.w[1] += w1;
+			sums.wd[1] += w1 * d1;
+			sums.wd2[1] += w1 * d1 * d1;
+		}
+	}
+#ifdef ANDI_SIMD_X86
+	/**
+	 * @brief exp() of four doubles, AVX2 version; relative precision about 1e-14, arguments limited to +-700
+	 */
+	__attribute__((target("avx2,fma"))) inline __m256d expAVX2(__m256d x) {
+		x = _mm256_max_pd(_mm256_min_pd(x, _mm256_set1_pd(700.)), _mm256_set1_pd(-700.));
+		// x = n ln2 + r, |r| <= ln2 / 2
+		__m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(6.93145751953125e-1), x);
+		r = _mm256_fnmadd_pd(n, _mm256_set1_pd(1.42860682030941723212e-6), r);
+		// Taylor series of exp(r) up to r^11
+		__m256d p = _mm256_set1_pd(1. / 39916800.);
+		const double inverseFactorials[11] = {1. / 3628800., 1. / 362880., 1. / 40320., 1. / 5040., 1. / 720., 1. / 120., 1. / 24., 1. / 6., 1. / 2., 1., 1.};
+		for (int k = 0; k < 11; k++) p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(inverseFactorials[k]));
+		// times 2^n, built directly in the exponent bits
+		__m256i exponent = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)), _mm256_set1_epi64x(1023));
+		return _mm256_mul_pd(p, _mm256_castsi256_pd(_mm256_slli_epi64(exponent, 52)));
+	}
+	/**
+	 * @brief log() of four positive, normal doubles, AVX2 version; relative precision about 1e-14
+	 */
+	__attribute__((target("avx2,fma"))) inline __m256d logAVX2(__m256d x) {
+		// x = 2^e * m, 1 <= m < 2
+		__m256i bits = _mm256_castpd_si256(x);
+		__m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)), _mm256_set1_epi64x(0x3FF0000000000000LL)));
+		__m256i exponentBits = _mm256_permutevar8x32_epi32(_mm256_srli_epi64(bits, 52), _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+		__m256d e = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(exponentBits)), _mm256_set1_pd(1023.));
+		// move m to [sqrt(2)/2, sqrt(2))
+		__m256d large = _mm256_cmp_pd(m, _mm256_set1_pd(1.4142135623730951), _CMP_GT_OQ);
+		m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), large);
+		e = _mm256_add_pd(e, _mm256_and_pd(large, _mm256_set1_pd(1.)));
+		// log(m) = 2 atanh(t), t = (m - 1) / (m + 1), series up to t^15
+		__m256d t = _mm256_div_pd(_mm256_sub_pd(m, _mm256_set1_pd(1.)), _mm256_add_pd(m, _mm256_set1_pd(1.)));
+		__m256d t2 = _mm256_mul_pd(t, t);
+		__m256d p = _mm256_set1_pd(1. / 15.);
+		const double inverseOdd[7] = {1. / 13., 1. / 11., 1. / 9., 1. / 7., 1. / 5., 1. / 3., 1.};
+		for (int k = 0; k < 7; k++) p = _mm256_fmadd_pd(p, t2, _mm256_set1_pd(inverseOdd[k]));
+		__m256d logM = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(2.), t), p);
+		return _mm256_fmadd_pd(e, _mm256_set1_pd(0.6931471805599453), logM);
+	}
+	/**
+	 * @brief Horizontal sum of the four doubles of a vector
+	 */
+	__attribute__((target("avx2,fma"))) inline double sumAVX2(__m256d x) {
+		__m128d s = _mm_add_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1));
+		return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+	}
+	/**
+	 * @brief Accumulates gaussLikelihoodSums of the values [first, last), AVX2 version; see gaussLikelihoodSumsScalar()
+	 */
+	__attribute__((target("avx2,fma"))) void gaussLikelihoodSumsAVX2(const double * values, Long64_t first, Long64_t last, const double * norm, const double * mean, const double * halfInverseVariance, gaussLikelihoodSums & sums) {
+		__m256d norm0 = _mm256_set1_pd(norm[0]), norm1 = _mm256_set1_pd(norm[1]);
+		__m256d mean0 = _mm256_set1_pd(mean[0]), mean1 = _mm256_set1_pd(mean[1]);
+		__m256d minusH0 = _mm256_set1_pd(-halfInverseVariance[0]), minusH1 = _mm256_set1_pd(-halfInverseVariance[1]);
+		__m256d smallest = _mm256_set1_pd(1e-300);
+		__m256d logP = _mm256_setzero_pd(), w0Sum = _mm256_setzero_pd(), wd0Sum = _mm256_setzero_pd(), wd20Sum = _mm256_setzero_pd(), w1Sum = _mm256_setzero_pd(), wd1Sum = _mm256_setzero_pd(), wd21Sum = _mm256_setzero_pd();
+		Long64_t i = first;
+		for (; i + 4 <= last; i += 4) {
+			__m256d x = _mm256_loadu_pd(values + i);
+			__m256d d0 = _mm256_sub_pd(x, mean0), d1 = _mm256_sub_pd(x, mean1);
+			__m256d d20 = _mm256_mul_pd(d0, d0), d21 = _mm256_mul_pd(d1, d1);
+			__m256d g0 = _mm256_mul_pd(norm0, expAVX2(_mm256_mul_pd(d20, minusH0)));
+			__m256d g1 = _mm256_mul_pd(norm1, expAVX2(_mm256_mul_pd(d21, minusH1)));
+			__m256d p = _mm256_max_pd(_mm256_add_pd(g0, g1), smallest);
+			__m256d inverseP = _mm256_div_pd(_mm256_set1_pd(1.), p);
+			__m256d w0 = _mm256_mul_pd(g0, inverseP), w1 = _mm256_mul_pd(g1, inverseP);
+			logP = _mm256_add_pd(logP, logAVX2(p));
+			w0Sum = _mm256_add_pd(w0Sum, w0);
+			wd0Sum = _mm256_fmadd_pd(w0, d0, wd0Sum);
+			wd20Sum = _mm256_fmadd_pd(w0, d20, wd20Sum);
+			w1Sum = _mm256_add_pd(w1Sum, w1);
+			wd1Sum = _mm256_fmadd_pd(w1, d1, wd1Sum);
+			wd21Sum = _mm256_fmadd_pd(w1, d21, wd21Sum);
+		}
+		sums.logP += sumAVX2(logP);
+		sums.w[0] += sumAVX2(w0Sum);
+		sums.wd[0] += sumAVX2(wd0Sum);
+		sums.wd2[0] += sumAVX2(wd20Sum);
+		sums.w[1] += sumAVX2(w1Sum);
+		sums.wd[1] += sumAVX2(wd1Sum);
+		sums.wd2[1] += sumAVX2(wd21Sum);
+		gaussLikelihoodSumsScalar(values, i, last, norm, mean, halfInverseVariance, sums);
+	}
+#endif
+
+	void gaussLikelihood::Gradient(const double * x, double * gradient) const {
+		evaluate(x);
+		for (unsigned int i = 0; i < NDim(); i++) gradient[i] = lastGradient[i];
+	}
+
+	void gaussLikelihood::FdF(const double * x, double & value, double * gradient) const {
+		value = evaluate(x);
+		for (unsigned int i = 0; i < NDim(); i++) gradient[i] = lastGradient[i];
+	}
+
+	double gaussLikelihood::DoDerivative(const double * x, unsigned int i) const {
+		evaluate(x);
+		return lastGradient[i];
+	}
+
+	double gaussLikelihood::evaluate(const double * x) const {
+		if (std::equal(x, x + NDim(), lastX.begin())) return lastValue;
+		double fraction = (nGaussians == 2) ? x[0] : 1;
+		const double * gaussParameters = (nGaussians == 2) ? x + 1 : x;
+		double norm[2] = {0, 0}, mean[2] = {0, 0}, halfInverseVariance[2] = {0, 0}, dLogZdMean[2] = {0, 0}, dLogZdSigma[2] = {0, 0};
+		for (int i = 0; i < nGaussians; i++) {
+			mean[i] = gaussParameters[2 * i];
+			double sigma = std::fabs(gaussParameters[2 * i + 1]);
+			halfInverseVariance[i] = 0.5 / (sigma * sigma);
+			// normalisation to the range: Z = Phi(zEnd) - Phi(zStart)
+			double zStart = (rangeStart - mean[i]) / sigma, zEnd = (rangeEnd - mean[i]) / sigma;
+			double phiStart = std::exp(-0.5 * zStart * zStart) / std::sqrt(2 * M_PI), phiEnd = std::exp(-0.5 * zEnd * zEnd) / std::sqrt(2 * M_PI);
+			double Z = std::max(0.5 * (std::erfc(-zEnd / std::sqrt(2.)) - std::erfc(-zStart / std::sqrt(2.))), 1e-300);
+			dLogZdMean[i] = (phiStart - phiEnd) / sigma / Z;
+			dLogZdSigma[i] = (zStart * phiStart - zEnd * phiEnd) / sigma / Z;
+			norm[i] = ((i == 0) ? fraction : 1 - fraction) / (sigma * std::sqrt(2 * M_PI) * Z);
+		}
+
+		Long64_t n = values->size();
+		int nUsedThreads = pool->size();
+		const double * data = values->data();
+		pool->run([&](int iThread) {
+			std::pair<Long64_t, Long64_t> range = threadRange(n, iThread, nUsedThreads);
+			threadSums[iThread] = gaussLikelihoodSums();
+#ifdef ANDI_SIMD_X86
+			if (simdLevel() >= 1) return gaussLikelihoodSumsAVX2(data, range.first, range.second, norm, mean, halfInverseVariance, threadSums[iThread]);
+#endif
+			gaussLikelihoodSumsScalar(data, range.first, range.second, norm, mean, halfInverseVariance, threadSums[iThread]);
+		});
+		gaussLikelihoodSums sums;
+		for (int i = 0; i < nUsedThreads; i++) sums.add(threadSums[i]);
+		nEvaluations++;
+
+		// d(-log L)/dx from the sums
+		double * gradient = lastGradient.data();
+		if (nGaussians == 2) *gradient++ = -(sums.w[0] / fraction - sums.w[1] / (1 - fraction));
+		for (int i = 0; i < nGaussians; i++) {
+			double sigma = std::fabs(gaussParameters[2 * i + 1]);
+			*gradient++ = -(sums.wd[i] / (sigma * sigma) - sums.w[i] * dLogZdMean[i]);
+			*gradient++ = -(sums.wd2[i] / (sigma * sigma * sigma) - sums.w[i] * (1 / sigma + dLogZdSigma[i])) * ((gaussParameters[2 * i + 1] < 0) ? -1 : 1);
+		}
+		std::copy(x, x + NDim(), lastX.begin());
+		lastValue = -sums.logP;
+		return lastValue;
+	}
+	/**
+	 * @brief Unbinned maximum likelihood fit of one or two Gaussians; see doubleGaussFitUnbinned() and gaussFitUnbinned()
+	 *
+	 * @param values Values to fit; values outside of the range are ignored. Copied once (as double) while filtering the range
+	 * @param n Number of values
+	 * @param nGaussians 1 or 2
+	 * @param binWidth Bin width of the histogram the resulting function should describe
+	 * @param rangeStart Start of the fit range
+	 * @param rangeEnd End of the fit range
+	 * @param startParameters Starting parameters in the layout of the returned function (3 or 6); determined with doubleGaussSeed() (doubleGaussPrefit() as fallback) if NULL
+	 * @param verbose Print fitting parameters
+	 * @param nThreads Maximum number of threads per evaluation, see numberOfThreads(); only used for samples of more than 200000 values
+	 * @return A TF1 "gaus" or "gaus(0)+gaus(3)", owned by the caller; NULL without values or without Minuit2. Its chi2 is set to 2 times the negative log-likelihood, its NDF to the number of values minus the number of free parameters.
+	 */
+	template <typename Value>
+	TF1 * privateGaussFitUnbinned(const Value * values, Long64_t n, int nGaussians, double binWidth, double rangeStart, double rangeEnd, double * startParameters, bool verbose, int nThreads) {
+		scopedTimer timer((nGaussians == 2) ? "doubleGaussFitUnbinned" : "gaussFitUnbinned");
+		std::vector<double> inRange;
+		inRange.reserve(n);
+		for (Long64_t i = 0; i < n; i++) {
+			if (values[i] >= rangeStart && values[i] <= rangeEnd) inRange.push_back(values[i]);
+		}
+		if (inRange.empty()) {
+			std::cerr << "andi::gaussFitUnbinned: No values in range [" << rangeStart << ", " << rangeEnd << "]" << std::endl;
+			return 0;
+		}
+		double nValues = inRange.size();
+
+		double parameters[6] = {0, 0, 0, 0, 0, 0};
+		if (startParameters) {
+			std::copy(startParameters, startParameters + 3 * nGaussians, parameters);
+		} else {
+			// starting values from a temporary histogram
+			TH1D hist("hGaussFitUnbinnedSeed", "", 100, rangeStart, rangeEnd);
+			hist.SetDirectory(0);
+			for (size_t i = 0; i < inRange.size(); i++) hist.Fill(inRange[i]);
+			double seedStart, seedEnd;
+			if (!doubleGaussSeed(&hist, parameters, seedStart, seedEnd)) {
+				double center = hist.GetMean(), halfWidth = (rangeEnd - rangeStart) / 2;
+				doubleGaussPrefit(&hist, parameters, center, halfWidth / 10, halfWidth * 8 / 10);
+			}
+			if (nGaussians == 1) {
+				parameters[0] = hist.GetMaximum();
+				parameters[2] = hist.GetStdDev();
+			}
+		}
+		// fraction of the inner Gaussian from the constants: constant * sigma is proportional to the yield
+		double yield0 = std::fabs(parameters[0] * parameters[2]), yield1 = std::fabs(parameters[3] * parameters[5]);
+		double fraction = (yield0 + yield1 > 0) ? yield0 / (yield0 + yield1) : 0.8;
+		double width = rangeEnd - rangeStart;
+
+		ROOT::Math::Minimizer * minimizer = ROOT::Math::Factory::CreateMinimizer("Minuit2", "Migrad");
+		if (minimizer == 0) {
+			std::cerr << "andi::gaussFitUnbinned: Could not create the Minuit2 minimizer; is libMinuit2 available?" << std::endl;
+			return 0;
+		}
+		gaussLikelihood likelihood(&inRange, rangeStart, rangeEnd, nGaussians, numberOfThreads(nThreads));
+		minimizer->SetFunction(likelihood);
+		minimizer->SetErrorDef(0.5);
+		minimizer->SetPrintLevel(0);
+		unsigned int iVariable = 0;
+		if (nGaussians == 2) minimizer->SetLimitedVariable(iVariable++, "fraction", std::min(std::max(fraction, 0.05), 0.95), 0.01, 0.001, 0.999);
+		for (int i = 0; i < nGaussians; i++) {
+			minimizer->SetLimitedVariable(iVariable++, Form("mean%d", i), parameters[3 * i + 1], std::fabs(parameters[3 * i + 2]) / 10 + 1e-9, rangeStart, rangeEnd);
+			minimizer->SetLimitedVariable(iVariable++, Form("sigma%d", i), std::fabs(parameters[3 * i + 2]), std::fabs(parameters[3 * i + 2]) / 10 + 1e-9, width * 1e-6, width * 10);
+		}
+		minimizer->Minimize();
+		minimizer->Hesse();
+		instruments().count("fits");
+		instruments().count("fit function calls", likelihood.nEvaluations);
+		const double * x = minimizer->X();
+		const double * errors = minimizer->Errors();
+
+		// back to the layout of doubleGaussFit(): constant, mean, sigma per Gaussian, scaled to the bin width
+		double results[6], resultErrors[6];
+		iVariable = (nGaussians == 2) ? 1 : 0;
+		for (int i = 0; i < nGaussians; i++) {
+			double part = (nGaussians == 2) ? ((i == 0) ? x[0] : 1 - x[0]) : 1;
+			double mean = x[iVariable], sigma = x[iVariable + 1];
+			double zStart = (rangeStart - mean) / sigma, zEnd = (rangeEnd - mean) / sigma;
+			double Z = 0.5 * (std::erfc(-zEnd / std::sqrt(2.)) - std::erfc(-zStart / std::sqrt(2.)));
+			results[3 * i] = nValues * part * binWidth / (sigma * std::sqrt(2 * M_PI) * Z);
+			results[3 * i + 1] = mean;
+			results[3 * i + 2] = sigma;
+			// approximate: correlations and the normalisation to the range are neglected
+			double relativePartError = (nGaussians == 2) ? errors[0] / part : 0;
+			resultErrors[3 * i] = results[3 * i] * std::sqrt(1 / nValues + relativePartError * relativePartError + std::pow(errors[iVariable + 1] / sigma, 2));
+			resultErrors[3 * i + 1] = errors[iVariable];
+			resultErrors[3 * i + 2] = errors[iVariable + 1];
+			iVariable += 2;
+		}
+
+		TF1 * fit = privateFunction((nGaussians == 2) ? "fitUnbinned" : "fitUnbinnedSingle", (nGaussians == 2) ? "gaus(0)+gaus(3)" : "gaus", rangeStart, rangeEnd);  // owned by the caller
+		fit->SetParameters(results);
+		fit->SetParErrors(resultErrors);
+		if (nGaussians == 2) {
+			fit->SetParName(0, "Const (inner)");
+			fit->SetParName(1, "Mean (inner)");
+			fit->SetParName(2, "Sigma (inner)");
+			fit->SetParName(3, "Const (outer)");
+			fit->SetParName(4, "Mean (outer)");
+			fit->SetParName(5, "Sigma (outer)");
+		}
+		fit->SetChisquare(2 * minimizer->MinValue());
+		fit->SetNDF(inRange.size() - minimizer->NDim());
+		if (verbose) {
+			std::cout << "Unbinned Gauss fit to " << inRange.size() << " values (status " << minimizer->Status() << ", " << likelihood.nEvaluations << " evaluations)" << std::endl;
+			std::cout << "  -log L = " << minimizer->MinValue() << std::endl;
+			for (int i = 0; i < nGaussians; i++) {
+				std::cout << "  mean (" << ((i == 0) ? "inner" : "outer") << ") = " << results[3 * i + 1] << " pm " << resultErrors[3 * i + 1] << std::endl;
+				std::cout << "  sigma (" << ((i == 0) ? "inner" : "outer") << ") = " << results[3 * i + 2] << " pm " << resultErrors[3 * i + 2] << std::endl;
+			}
+		}
+		delete minimizer;
+		return fit;
+	}
+
+	TF1 * doubleGaussFitUnbinned(const std::vector<double> & values, double binWidth, double rangeStart, double rangeEnd, double * startParameters, bool verbose, int nThreads) {
+		return privateGaussFitUnbinned(values.data(), values.size(), 2, binWidth, rangeStart, rangeEnd, startParameters, verbose, nThreads);
+	}
+
+	TF1 * doubleGaussFitUnbinned(const Float_t * values, Long64_t n, double binWidth, double rangeStart, double rangeEnd, double * startParameters, bool verbose, int nThreads) {
+		return privateGaussFitUnbinned(values, n, 2, binWidth, rangeStart, rangeEnd, startParameters, verbose, nThreads);
+	}
+
+	TF1 * gaussFitUnbinned(const std::vector<double> & values, double binWidth, double rangeStart, double rangeEnd, double * startParameters, bool verbose, int nThreads) {
+		return privateGaussFitUnbinned(values.data(), values.size(), 1, binWidth, rangeStart, rangeEnd, startParameters, verbose, nThreads);
+	}
+
+	TF1 * gaussFitUnbinned(const Float_t * values, Long64_t n, double binWidth, double rangeStart, double rangeEnd, double * startParameters, bool verbose, int nThreads) {
+		return privateGaussFitUnbinned(values, n, 1, binWidth, rangeStart, rangeEnd, startParameters, verbose, nThreads);
+	}
+
+	// Parallel reading
+	std::vector<TString> filesFromList(TString fileName) {
+		std::vector<TString> files;
+		TFileCollection collection("somename", "", fileName);
+		TIter next(collection.GetList());
+		while (TFileInfo * info = (TFileInfo *) next()) files.push_back(info->GetCurrentUrl()->GetUrl());
+		return files;
+	}
+
+	std::vector<Long64_t> processFilesParallel(TString treeName, TString fileName, TString baseString, const std::function<void(const parallelEntry &)> & entryFunction, int nThreads, UInt_t fieldMask, bool alsoDaugthers) {
+		scopedTimer timer("processFilesParallel");
+		ROOT::EnableThreadSafety();
+		std::vector<TString> files = filesFromList(fileName);
+		std::vector<Long64_t> entriesPerFile(files.size(), -1);  // every file is written by one thread only
+		nThreads = numberOfThreads(nThreads);
+		auto openTree = [&](int iFile, TFile *& file) -> TTree * {
+			file = TFile::Open(files[iFile]);
+			if (file == 0 || file->IsZombie()) {
+				std::cerr << "andi::processFilesParallel: Could not open " << files[iFile] << std::endl;
+				delete file;
+				file = 0;
+				return 0;
+			}
+			TTree * tree = 0;
+			file->GetObject(treeName, tree);
+			if (tree == 0) {
+				std::cerr << "andi::processFilesParallel: No tree " << treeName << " in " << files[iFile] << std::endl;
+				delete file;
+				file = 0;
+			}
+			return tree;
+		};
+
+		// entries and clusters of every file
+		std::vector<std::vector<Long64_t> > clusters(files.size());
+		std::atomic<int> nextFile(0);
+		runInThreads(std::min<int>(nThreads, std::max<int>(files.size(), 1)), [&](int) {
+			for (int iFile = nextFile++; iFile < (int)files.size(); iFile = nextFile++) {
+				TFile * file = 0;
+				TTree * tree = openTree(iFile, file);
+				if (tree == 0) continue;
+				clusters[iFile] = clusterStarts(tree);
+				entriesPerFile[iFile] = tree->GetEntries();
+				instruments().count("bytes read", file->GetBytesRead());
+				delete file;  // also deletes the tree
+			}
+		});
+
+		// ranges of whole clusters
+		struct entryRange {
+			int iFile;
+			Long64_t first, last;
+		};
+		std::vector<entryRange> ranges;
+		Long64_t nTotal = 0;
+		for (size_t iFile = 0; iFile < files.size(); iFile++) nTotal += std::max<Long64_t>(entriesPerFile[iFile], 0);
+		Long64_t rangeSize = std::max<Long64_t>(nTotal / (4 * nThreads), 1);
+		for (size_t iFile = 0; iFile < files.size(); iFile++) {
+			const std::vector<Long64_t> & starts = clusters[iFile];
+			for (size_t k = 0; k + 1 < starts.size(); ) {
+				entryRange range = {(int) iFile, starts[k], starts[k]};
+				while (k + 1 < starts.size() && range.last - range.first < rangeSize) range.last = starts[++k];
+				ranges.push_back(range);
+			}
+		}
+
+		std::atomic<size_t> nextRange(0);
+		runInThreads(std::min<int>(nThreads, std::max<int>(ranges.size(), 1)), [&](int slot) {
+			DInfoContainer container;
+			parallelEntry e;
+			e.slot = slot;
+			e.container = &container;
+			e.iFile = -1;
+			TFile * file = 0;
+			TTree * tree = 0;
+			for (size_t iRange = nextRange++; iRange < ranges.size(); iRange = nextRange++) {
+				const entryRange & range = ranges[iRange];
+				if (range.iFile != e.iFile) {
+					if (file) instruments().count("bytes read", file->GetBytesRead());
+					delete file;  // also deletes the tree
+					tree = openTree(range.iFile, file);
+					e.iFile = range.iFile;
+					e.tree = tree;
+					if (tree == 0) continue;
+					bindBranches(tree, container, baseString, fieldMask, true, alsoDaugthers ? nDInfoParticles : 1);
+				}
+				if (tree == 0) continue;
+				for (e.entry = range.first; e.entry < range.last; e.entry++) {
+					tree->GetEntry(e.entry);
+					entryFunction(e);
+				}
+				instruments().count("entries read", range.last - range.first);
+			}
+			if (file) instruments().count("bytes read", file->GetBytesRead());
+			delete file;
+		});
+		return entriesPerFile;
+	}
+
+	parallelOutput::~parallelOutput() {
+		for (size_t slot = 0; slot < clones.size(); slot++) {
+			for (size_t i = 0; i < clones[slot].size(); i++) delete clones[slot][i];
+		}
+	}
+
+	int parallelOutput::book(TH1 * hist) {
+		histograms.push_back(hist);
+		for (int slot = 0; slot < nSlots; slot++) {
+			TH1 * clone = (TH1 *) hist->Clone(TString::Format("%s_slot%d", hist->GetName(), slot));
+			clone->SetDirectory(0);
+			clone->Reset();
+			clones[slot].push_back(clone);
+		}
+		return histograms.size() - 1;
+	}
+
+	void parallelOutput::merge(const std::vector<Long64_t> & entriesPerFile) {
+		std::vector<Long64_t> fileOffsets(entriesPerFile.size() + 1, 0);
+		for (size_t iFile = 0; iFile < entriesPerFile.size(); iFile++) fileOffsets[iFile + 1] = fileOffsets[iFile] + std::max<Long64_t>(entriesPerFile[iFile], 0);
+		// every histogram is merged by one thread
+		runInThreads(std::min<int>(nSlots, histograms.size()), [&](int iThread) {
+			for (size_t i = iThread; i < histograms.size(); i += std::min<int>(nSlots, histograms.size())) {
+				for (int slot = 0; slot < nSlots; slot++) {
+					histograms[i]->Add(clones[slot][i]);
+					clones[slot][i]->Reset();
+				}
+			}
+		});
+		for (int slot = 0; slot < nSlots; slot++) {
+			count += slotCounts[slot];
+			slotCounts[slot] = 0;
+			for (size_t i = 0; i < slotSelected[slot].size(); i++) selectedEntries.push_back(fileOffsets[slotSelected[slot][i].first] + slotSelected[slot][i].second);
+			slotSelected[slot].clear();
+		}
+		std::sort(selectedEntries.begin(), selectedEntries.end());
+	}
+
+	std::vector<Long64_t> processFilesParallel(TString treeName, TString fileName, TString baseString, parallelOutput & output, const std::function<void(const parallelEntry &)> & entryFunction, UInt_t fieldMask, bool alsoDaugthers) {
+		std::vector<Long64_t> entriesPerFile = processFilesParallel(treeName, fileName, baseString, entryFunction, output.nSlots, fieldMask, alsoDaugthers);
+		output.merge(entriesPerFile);
+		return entriesPerFile;
+	}
+
+	Long64_t eventLoop::run(TTree * tree, const std::function<void(int, TTree *)> & setupFunction, const std::function<void(int, Long64_t)> & eventFunction) {
+		scopedTimer timer("eventLoop::run");
+		Long64_t nEntries = tree->GetEntries();
+		std::vector<Long64_t> selected;  // entry numbers of the entry list of the tree, if it has one
+		if (TEntryList * list = tree->GetEntryList()) {
+			selected.resize(list->GetN());
+			for (Long64_t i = 0; i < (Long64_t) selected.size(); i++) selected[i] = tree->GetEntryNumber(i);
+		}
+		Long64_t nToProcess = tree->GetEntryList() ? (Long64_t) selected.size() : nEntries;
+		std::vector<TString> files;
+		std::vector<Long64_t> entriesPerFile;
+		TString treeName = tree->GetName();
+		if (tree->InheritsFrom("TChain")) {
+			TObjArray * elements = ((TChain *) tree)->GetListOfFiles();
+			Long64_t * offsets = tree->GetTreeOffset();
+			for (int i = 0; i < elements->GetEntries(); i++) {
+				files.push_back(elements->At(i)->GetTitle());
+				entriesPerFile.push_back(offsets[i + 1] - offsets[i]);
+			}
+		} else if (tree->GetCurrentFile() != 0) {
+			files.push_back(tree->GetCurrentFile()->GetName());
+			entriesPerFile.push_back(nEntries);
+			TString directory = tree->GetDirectory()->GetPath();  // file.root:/sub/dir
+			directory.Remove(0, directory.Index(":/") + 2);
+			if (!directory.IsNull()) treeName = directory + "/" + treeName;
+		}
+		if (files.empty()) {  // in-memory tree, can only be read here
+			setupFunction(0, tree);
+			for (Long64_t i = 0; i < nToProcess; i++) {
+				Long64_t entry = selected.empty() ? i : selected[i];
+				tree->GetEntry(entry);
+				eventFunction(0, entry);
+			}
+		} else {
+			ROOT::EnableThreadSafety();
+			int nThreads = output.nSlots;
+			runInThreads(nThreads, [&](int slot) {
+				TChain threadChain(treeName);
+				for (size_t i = 0; i < files.size(); i++) threadChain.Add(files[i], entriesPerFile[i]);  // known number of entries, so files are opened only when needed
+				setupFunction(slot, &threadChain);
+				std::pair<Long64_t, Long64_t> range = threadRange(nToProcess, slot, nThreads);
+				for (Long64_t i = range.first; i < range.second; i++) {
+					Long64_t entry = selected.empty() ? i : selected[i];
+					threadChain.GetEntry(entry);
+					eventFunction(slot, entry);
+				}
+			});
+		}
+		output.merge(std::vector<Long64_t>(1, nEntries));
+		instruments().count("entries read", nToProcess);
+		return nToProcess;
+	}
+
+	Long64_t eventLoop::run(TTree * tree, TString baseString, const std::function<void(const parallelEntry &)> & eventFunction, UInt_t fieldMask, bool alsoDaugthers) {
+		std::vector<DInfoContainer> containers(output.nSlots);
+		std::vector<parallelEntry> entries(output.nSlots);
+		bool callerTree = false;  // an in-memory tree is read directly, the threads of files read their own chains
+		branchStatus status;
+		std::vector<TString> bound;
+		Long64_t nProcessed = run(tree, [&](int slot, TTree * threadTree) {
+			if (threadTree == tree) {
+				callerTree = true;
+				status.save(tree);
+				bound = bindBranches(tree, containers[slot], baseString, fieldMask, true, alsoDaugthers ? nDInfoParticles : 1);
+			} else {
+				bindBranches(threadTree, containers[slot], baseString, fieldMask, true, alsoDaugthers ? nDInfoParticles : 1);
+			}
+			parallelEntry & e = entries[slot];
+			e.slot = slot;
+			e.iFile = 0;
+			e.tree = threadTree;
+			e.container = &containers[slot];
+		}, [&](int slot, Long64_t entry) {
+			entries[slot].entry = entry;
+			eventFunction(entries[slot]);
+		});
+		if (callerTree) unbindBranches(tree, bound, status);  // containers are gone after this function
+		return nProcessed;
+	}
+}
+
+#endif // ANDI_COMMON_CPP
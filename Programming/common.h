@@ -0,0 +1,2664 @@
+/**
+ * @file common.h
+ * @brief Declarations of the helpers of common.cpp
+ * @details Include this file to use the helpers from compiled code and link against libAndiCommon (see Makefile); the definitions are in common.cpp only. The ROOT dictionary of libAndiCommon is generated from this file, see LinkDef.h.
+ */
+
+#ifndef ANDI_COMMON_H
+#define ANDI_COMMON_H
+
+#include "TROOT.h"
+#include "TSystem.h"
+#include "TStyle.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+#include "TChain.h"
+#include "TFile.h"
+#include "TFileCollection.h"
+#include "TFileInfo.h"
+#include "TUrl.h"
+#include "TCut.h"
+#include "TEntryList.h"
+#include "TGraph.h"
+#include "TGraphAsymmErrors.h"
+#include "THn.h"
+
+#include "TCanvas.h"
+#include "TPad.h"
+
+#include "TLegend.h"
+#include "TPaveText.h"
+#include "TPaveStats.h"
+#include "TPaletteAxis.h"
+
+#include "TH1.h"
+#include "TH2.h"
+#include "THStack.h"
+#include "TF1.h"
+#include "TFitResult.h"
+#include "TBufferFile.h"
+#include "TMD5.h"
+#include "TRandom3.h"
+#include "TTreePerfStats.h"
+#include "TList.h"
+#include "TRegexp.h"
+#include "TObjString.h"
+#include "Math/MinimizerOptions.h"
+#include "Math/Minimizer.h"
+#include "Math/Factory.h"
+#include "Math/IFunction.h"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <map>
+#include <set>
+#include <fstream>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <type_traits>
+#include <cstdio>
+#include <cstring>
+
+
+/**
+ * @namespace andi A namespace to structure my things better
+ */
+namespace andi {
+	// some constants
+	extern double crossSig; ///< Signal cross section, in mu barn
+	extern double crossBkg; ///< Background cross section, in mu barn
+	extern double brSig; ///< Brancing ratio D --> K π π 
+	/**
+	 * @name Threads
+	 * @details Small helpers to spread work over the cores of a machine. Everything is plain `std::thread`, no ROOT implicit multi-threading needed.
+	 * @{
+	 */
+	/**
+	 * @brief Number of threads to use
+	 * @details Returns nThreads if positive, otherwise the number of cores of the machine (at least 1).
+	 */
+	int numberOfThreads(int nThreads = 0);
+	/**
+	 * @brief Runs a function on several threads and waits for all of them
+	 * @details The function is called with the index of the thread (0 to nThreads - 1), which can be used to split the work, e.g. with threadRange().
+	 * 
+	 * @param nThreads Number of threads to start. 1 runs the function directly, without starting a thread
+	 * @param work Function to run, gets the index of the thread
+	 */
+	void runInThreads(int nThreads, const std::function<void(int)> & work);
+	/**
+	 * @brief Part [first, last) of nItems which thread iThread of nThreads should work on
+	 */
+	std::pair<Long64_t, Long64_t> threadRange(Long64_t nItems, int iThread, int nThreads);
+	/**
+	 * @brief A fixed set of threads which runs a function again and again, like runInThreads() but without starting threads every time
+	 * @details For work which is split over threads many times in a row, e.g. every evaluation of a function during a fit. The calling thread works as thread 0, so nThreads - 1 threads are started once and wait for the next run(). One run() at a time only; the pool is not thread-safe itself.
+	 */
+	struct threadPool {
+		/**
+		 * @param nThreads Number of threads of a run(), the calling one included; 1 starts no thread at all
+		 */
+		explicit threadPool(int nThreads);
+		~threadPool();
+		int size() const { return workers.size() + 1; } ///< Number of threads of a run()
+		/**
+		 * @brief Calls work(iThread) on all threads, iThread = 0 to size() - 1, and waits for all of them
+		 */
+		void run(const std::function<void(int)> & work);
+	private:
+		void loop(int iThread);
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake, done;
+		const std::function<void(int)> * job;
+		unsigned long generation;
+		int nBusy;
+		bool stopping;
+		threadPool(const threadPool &);  // owns the threads
+		threadPool & operator=(const threadPool &);
+	};
+	/**
+	 * @}
+	 */
+	/**
+	 * @name Instrumentation
+	 * @details Timers and counters in the helpers of this file, to see where a macro spends its time: reading (entries, bytes, decompression), TTree::GetEntries() calls, fits (and evaluations of the fit function), saving of canvases per format.
+	 *
+	 * Switched off by default, then it costs nothing but a check of a flag. Switch it on at the start of a macro with enableInstrumentation(); everything is summed up until instrumentationReport() (or, optionally, the end of the job).
+	 * 
+	 * ~~~{.cpp}
+	 * andi::enableInstrumentation();
+	 * // ... cut benchmarks, fits, createCanvasDrawAndSave() ...
+	 * andi::instrumentationReport("timing.json");
+	 * ~~~
+	 * @{
+	 */
+	/**
+	 * @brief Timers and counters of one run
+	 * @details Timers are inclusive: a helper calling another helper counts the time of both.
+	 */
+	struct instrumentation {
+		bool enabled; ///< Collect timers and counters
+		bool trace; ///< Print every step of the cut benchmarks
+		bool reportAtExit; ///< Print the report at the end of the job
+		TString jsonFileName; ///< Also write the report at the end of the job into this file, if not empty
+		std::map<std::string, double> seconds; ///< Wall time per timer
+		std::map<std::string, Long64_t> calls; ///< Number of measurements per timer
+		std::map<std::string, double> counters; ///< Counters by name
+		std::mutex mutex;
+
+		instrumentation() : enabled(false), trace(false), reportAtExit(false) {}
+		~instrumentation();
+		/**
+		 * @brief Adds a measurement to a timer
+		 */
+		void addTime(const std::string & timer, double wallTime);
+		/**
+		 * @brief Adds value to a counter, if enabled
+		 */
+		void count(const std::string & counter, double value = 1);
+		/**
+		 * @brief Forgets all timers and counters
+		 */
+		void reset();
+		/**
+		 * @brief Prints timers (sorted by time) and counters
+		 */
+		void report(std::ostream & out = std::cout);
+		/**
+		 * @brief Writes timers and counters as JSON: `{"timers": {"name": {"calls": n, "seconds": s}, ...}, "counters": {"name": value, ...}}`
+		 * @return false if the file could not be written
+		 */
+		bool writeJson(TString fileName);
+	};
+	/**
+	 * @brief The instrumentation of this job
+	 */
+	instrumentation & instruments();
+	/**
+	 * @brief Measures the wall time from construction to destruction into a timer of instruments(), if enabled
+	 * @details Put one at the start of a function: `scopedTimer timer("myFunction");`
+	 */
+	struct scopedTimer {
+		const char * name;
+		bool running;
+		std::chrono::steady_clock::time_point start;
+
+		scopedTimer(const char * name);
+		~scopedTimer();
+	};
+	/**
+	 * @brief Counts the reading of a tree from construction to destruction, if instrumentation is enabled
+	 * @details Adds to the counters "bytes read" and "read calls" the difference of ROOT's counters over all files (TFile::GetFileBytesRead(), TFile::GetFileReadCalls()) between construction and destruction, which also works for a TChain whose files are opened on the way. Reads of other threads in that time are counted as well, so use it only where one thread reads.
+	 *
+	 * The decompression is measured with a TTreePerfStats attached to the tree: "unzip seconds", "bytes unzipped" (compressed size of the unzipped baskets) and "bytes decompressed" (their size after decompression). ROOT reports these only for the tree the TTreePerfStats was created for, not for the trees of the files of a TChain. A TTreePerfStats the caller attached to the tree is put back at destruction (it misses the reads in between).
+	 */
+	struct scopedTreeStats {
+		TTree * tree;
+		bool running;
+		TTreePerfStats * stats;
+		TVirtualPerfStats * previousStats; ///< The TTreePerfStats the tree had before, attached again at destruction
+		Long64_t bytesBefore;
+		int readCallsBefore;
+
+		scopedTreeStats(TTree * tree);
+		~scopedTreeStats();
+	};
+	/**
+	 * @brief Switches the instrumentation on (and resets it) or off
+	 * 
+	 * @param enable On or off
+	 * @param trace Print every step of the cut benchmarks
+	 * @param reportAtExit Print the report at the end of the job, and write it to jsonFileName if given
+	 * @param jsonFileName See reportAtExit
+	 */
+	void enableInstrumentation(bool enable = true, bool trace = false, bool reportAtExit = false, TString jsonFileName = "");
+	/**
+	 * @brief Prints the report of instruments(), and writes it as JSON if a file name is given
+	 */
+	void instrumentationReport(TString jsonFileName = "");
+	/**
+	 * @}
+	 */
+	/**
+	 * @brief Set my custom ROOT canvas style
+	 * @details Gets rid of the margins and sets some other stuff
+	 */
+	void setCustomStyle(bool showStats = true);
+
+	/**
+	 * @name MoveLeft
+	 * Methods for moving a box on the canvas **to the left**.
+	 * @{
+	 */
+	/**
+	 * @brief Abstract method for moving any TPave left
+	 * @details Is used by moveStatBoxLeft() and moveZAxisLeft() to move stuff left
+	 * 
+	 * @param pave Pointer to TPave to be moved
+	 * @param moveToLeft Value, the box should be moved left. In NDC.
+	 */
+	void moveTPaveLeft(TPave * pave, float moveToLeft = 0);
+	/**
+	 * @brief Moves a statbox to the left
+	 * 
+	 * @param hist Pointer to histogram with statbox inside
+	 * @param moveToLeft Percentage of how much to move it left. Negative numbers to move it right.
+	 */
+	void moveStatBoxLeft(TH1 * hist, float moveToLeft = 0);
+	/**
+	 * @brief Moves a Z axis left
+	 * @details Ever got the problem that your z axis is too far to the right so that the numbers are not displayed correctly? Fear not, for there is this method.
+	 * 
+	 * @param hist Point to histogram containing Z axis. It's a TH2 as only those should have a z axis
+	 * @param moveToLeft The amount to be moved left. In NDC.
+	 */
+	void moveZAxisLeft(TH2 * hist, float moveToLeft = 0);
+	/**
+	 *@}
+	 */
+
+	/**
+	 * @name MoveDown
+	 * Methods for moving a box on the canvas **down**.
+	 * @{
+	 */
+	/**
+	 * @brief Abstract method for moving any TPave down
+	 * @details Is used by moveStatBoxDown() to move stuff down
+	 * 
+	 * @param pave Pointer to TPave to be moved
+	 * @param moveDown Value, the box should be moved down. In NDC.
+	 */
+	void moveTPaveDown(TPave * pave, float moveDown = 0);
+	/**
+	 * @brief Moves a statbox down
+	 * 
+	 * @param hist Pointer to histogram with statbox inside
+	 * @param moveDown Percentage of how much to move the statbox down. Negative values to move it up.
+	 */
+	void moveStatBoxDown(TH1 * hist, float moveDown = 0);
+	/**
+	 * @}
+	 */
+
+	/**
+	 * @name ShrinkBox
+	 * Methods for shrinking a box.
+	 * @{
+	 */
+	/**
+	 * @brief Abstract class for shrinking boxes
+	 * @details Shrinks boxes by manipulating the lower left corner. Is used by shrinkStatBox().
+	 * 
+	 * @param box A TPave box.
+	 * @param xShrinkFactor The shrinkage factor.
+	 */
+	void shrinkBox(TPave * box, float xShrinkFactor);
+	/**
+	 * @brief Shrinks a statbox, keeping its aspect ratio. length_new = factor * length_old.
+	 * @details Shrinks both the width as well as the height to factor*oldvalue. So, e.g., use 0.8 to shrink your statbox to a 80% side length in relation to the original side length.
+	 * 
+	 * @param hist Histogram containing the statbox
+	 * @param xShrinkFactor Factor of shrinkage: length_new = factor * length_old
+	 */
+	void shrinkStatBox(TH1 * hist, float xShrinkFactor);
+	/**
+	 * @}
+	 */
+
+	/**
+	 * @name Pad Titles
+	 * @{
+	 */
+	/**
+	 * @brief Create a box with the TObject's title
+	 * @details Puts the title of a histogram into a box, formats it and returns it.
+	 *
+	 * The box is placed on top of the histogram, at the usual position.
+	 * 
+	 * @param hist Pointer to histogram with title info inside
+	 * @param rightBorder Right border of where the box should end
+	 * 
+	 * @return pointer to a TPaveText
+	 */
+	TPaveText * makePadTitle(TObject * obj, double rightBorder = 0.96);
+
+	/**
+	 * @brief Draws an objects's title at default position. Convenience function for makePadTitle().
+	 * 
+	 * @param hist Pointer to TObject (e.g. TH1)
+	 */
+	void makePadTitleAndDraw(TObject * obj);
+	/**
+	 * @brief Draws a **2D** histogram's title at default position
+	 * @details Draws title and also moves the right pad's border a bit to the left to make space for z axis.
+	 *
+	 * You probably need to cast your pad to a `(TPad *)` - the last argument. E.g. `(TPad *) c1->GetPad(0)`.
+	 * 
+	 * @param hist Pointer to histogram (2D)
+	 * @param canvas Pointer to canvas where it's drawn upon, needed for margin movement
+	 */
+	void makePadTitleAndDraw(TH2 * hist, TPad * pad);
+	/**
+	 * @brief Draws a histogram's title at default position and moves statbox and z axis for **LARGE** datasets (= long numbers on Z)
+	 * @details Draws title and moves pad's right margin, the statbox and the z axis to the left. For large datasets, where the numbers on z have four (five?) digits.
+	 * 
+	 * @param hist Pointer to histogram (2D)
+	 * @param canvas Pointer to canvas where it's drawn upon, needed for margin movement (probably something like `(TPad*)c1->GetPad(0))`
+	 */
+	void makePadTitleAndDrawLarge(TH2 * hist, TPad * pad);
+	/**
+	 * @}
+	 */
+	/**
+	 * @name Saving of Canvas
+	 * @{
+	 */
+	/**
+	 * @brief Saves a canvas in three vector image formats plus root file
+	 * @details Creates four files for a given canvas: SVG, PDF, EPS - and ROOT. Always saves directly, also with enableAsyncExport().
+	 * 
+	 * @param canvas Pointer to canvas as it should be saved (everything drawn already)
+	 * @param name The file name with which the files are saved
+	 */
+	void saveCanvas_allFileNames(TCanvas * canvas, TString name);
+	/**
+	 * @brief Queue which saves canvases in the vector formats in the background
+	 * @details Rendering PDF, EPS and SVG is what makes saving slow. The queue forks one worker process per canvas and format: the worker gets a copy of the canvas as it is at the moment of the call, saves it and exits. The macro goes on immediately and can change or delete the canvas. At most maxWorkers processes run at the same time; beyond that, adding waits for the oldest worker.
+	 * 
+	 * The ROOT versions of the canvases are not written by the workers, but directly into one ROOT file per macro (e.g. img/myMacro/myMacro.root, with the canvas file names as keys), which stays open until flush().
+	 * 
+	 * ROOT's graphics are not thread-safe, hence processes instead of threads. Workers only work with batch mode (`root -b`); otherwise, and if fork() fails, the canvas is saved directly (with a warning the first time).
+	 *
+	 * A forked worker only has the thread which called fork(); a lock held by any other thread at that moment (ROOT's global lock after ROOT::EnableThreadSafety(), a lock in one of the threads of a parallel loop, …) would stay locked forever in the worker. So workers are only started as long as the process runs a single thread (on Linux, as counted in /proc/self/status; elsewhere this cannot be checked). With other threads running, e.g. saving from within a parallel loop, the canvas is saved directly.
+	 * 
+	 * Usually used via enableAsyncExport() and flushExports(). Whatever is still queued at the end of the job is flushed then, see activeExportQueue().
+	 */
+	struct exportQueue {
+		int maxWorkers; ///< Maximum number of worker processes at the same time
+		std::vector<TString> formats; ///< File extensions rendered by the workers
+		std::vector<pid_t> workers; ///< Running worker processes
+		std::vector<size_t> workerJobs; ///< Number of the canvas (job) of every running worker
+		/**
+		 * @brief The files of one canvas given to add(), as long as some of them are not saved yet
+		 */
+		struct job {
+			int nRunning; ///< Workers still running (plus one while add() starts them)
+			bool failed; ///< Some file could not be saved
+			std::function<void()> onSaved; ///< Called once all files are saved, not if any failed
+		};
+		std::map<size_t, job> jobs; ///< Unfinished canvases, by number
+		size_t nJobs; ///< Number of canvases given to add() so far
+		std::map<TString, TFile*> rootFiles; ///< Open ROOT files, by file name
+		int nFailed; ///< Number of workers which did not produce their file
+
+		exportQueue(int maxWorkers = 0);
+		~exportQueue();
+		/**
+		 * @brief Waits until at most maxRunning workers are left
+		 */
+		void waitForWorkers(size_t maxRunning = 0);
+		/**
+		 * @brief Counts one finished file of a job; calls its onSaved once the last one is saved
+		 */
+		void finishFile(size_t iJob, bool saved);
+		/**
+		 * @brief Number of threads of this process; 0 if unknown (not on Linux)
+		 */
+		static int processThreads();
+		/**
+		 * @brief True if workers can be forked; otherwise prints why not, once per reason
+		 */
+		static bool canFork();
+		/**
+		 * @brief Saves a canvas as name.{pdf,eps,svg} in the background and writes it into the ROOT file rootFileName as key
+		 * @details onSaved is called (from add(), waitForWorkers() or flush()) when all files are saved; if any of them fails, it is not called.
+		 */
+		void add(TCanvas * canvas, TString name, TString rootFileName, TString key, const std::function<void()> & onSaved = std::function<void()>());
+		/**
+		 * @brief Writes a canvas into a ROOT file, which is opened (for updating) if not already open
+		 * @return false if the file could not be opened
+		 */
+		bool writeToRootFile(TCanvas * canvas, TString rootFileName, TString key);
+		/**
+		 * @brief Waits for all workers and closes the ROOT files
+		 * @return Number of files which could not be saved since the last flush()
+		 */
+		int flush();
+	private:
+		exportQueue(const exportQueue &);
+		exportQueue & operator=(const exportQueue &);
+	};
+	/**
+	 * @brief The export queue used by saveCanvas() and saveCanvasFlat(); NULL if canvases are saved directly
+	 * @details Owned by the library: it is flushed and deleted at the end of the job, if not before with enableAsyncExport(false).
+	 */
+	exportQueue *& activeExportQueue();
+	/**
+	 * @brief Lets saveCanvas(), saveCanvasFlat() and with them createCanvasDrawAndSave() save in the background, see exportQueue
+	 * @details Call flushExports() at the end of the macro to check that all files were saved; otherwise the queue is flushed at the end of the job.
+	 * 
+	 * @param enable Switch background saving on or off (which flushes)
+	 * @param maxWorkers Maximum number of worker processes, see numberOfThreads()
+	 */
+	void enableAsyncExport(bool enable = true, int maxWorkers = 0);
+	/**
+	 * @brief Fingerprints of saved canvases, to skip saving canvases which did not change since the last run
+	 * @details The fingerprint is the MD5 sum of the streamed canvas (with everything drawn on it: bin contents, fit functions, titles, …) and of the current gStyle (e.g. from setCustomStyle()). The fingerprints are kept in a small text file `.exportManifest` in every output directory, one line `FINGERPRINT FILENAME` per canvas.
+	 *
+	 * A fingerprint is recorded only after all files of the canvas are saved; with enableAsyncExport(), that is when the last worker of the canvas exits cleanly. A canvas whose saving failed is therefore saved again by the next run.
+	 *
+	 * Changed manifests are only marked; they are written once by flush(), which is called by flushExports() and at the latest when the manifest is deleted (at the end of the job, see activeExportManifest()). Before writing, flush() waits for the workers of the export queue.
+	 * 
+	 * Usually used via enableIncrementalExport().
+	 */
+	struct exportManifest {
+		std::map<TString, std::map<TString, TString> > fingerprints; ///< Fingerprints by directory and file name
+		std::set<TString> changed; ///< Directories whose manifest has to be written
+		int nSkipped; ///< Number of canvases which were not saved since they did not change
+
+		exportManifest() : nSkipped(0) {}
+		~exportManifest();
+		/**
+		 * @brief File name of the manifest of a directory
+		 */
+		static TString manifestFileName(TString directory);
+		/**
+		 * @brief Fingerprint of a canvas, together with the current style
+		 */
+		static TString fingerprint(TCanvas * canvas);
+		/**
+		 * @brief True if all files directory/filename.* with the given extensions exist
+		 */
+		static bool filesExist(TString directory, TString filename, const std::vector<TString> & extensions);
+		/**
+		 * @brief Fingerprints of a directory, read from its manifest on first use
+		 */
+		std::map<TString, TString> & directoryFingerprints(TString directory);
+		/**
+		 * @brief Writes the manifest of a directory
+		 */
+		void write(TString directory);
+		/**
+		 * @brief Writes the manifests of all directories with changed fingerprints
+		 */
+		void flush();
+		/**
+		 * @brief Checks if a canvas has to be saved as directory/filename.*
+		 * @details True if the fingerprint of the canvas is the one of the last time and all files are there; then nothing is to be done. Otherwise, the new fingerprint is to be given to record() once the canvas is saved.
+		 * 
+		 * @param canvas Canvas to save
+		 * @param directory Output directory, ending with /
+		 * @param filename File name without extension
+		 * @param extensions Extensions of the files which have to exist
+		 * @param currentFingerprint Filled with the fingerprint of the canvas
+		 * @return true if saving can be skipped
+		 */
+		bool unchanged(TCanvas * canvas, TString directory, TString filename, const std::vector<TString> & extensions, TString & currentFingerprint);
+		/**
+		 * @brief Records the fingerprint of a saved canvas (written by flush())
+		 */
+		void record(TString directory, TString filename, TString currentFingerprint);
+	};
+	/**
+	 * @brief The manifest used by saveCanvas() and saveCanvasFlat(); NULL if all canvases are saved
+	 * @details Owned by the library, so changed manifests are written at the end of the job, see globalOwner.
+	 */
+	exportManifest *& activeExportManifest();
+	/**
+	 * @brief Lets saveCanvas(), saveCanvasFlat() and with them createCanvasDrawAndSave() skip canvases which did not change since the last run, see exportManifest
+	 * @details Works together with enableAsyncExport().
+	 * 
+	 * @param enable Switch skipping on or off
+	 */
+	void enableIncrementalExport(bool enable = true);
+	/**
+	 * @brief Waits until all canvases given to saveCanvas() and saveCanvasFlat() are saved, and writes the changed manifests of enableIncrementalExport()
+	 * @return Number of files which could not be saved
+	 */
+	int flushExports();
+	/**
+	 * @brief Saves a canvas as directory/filename.*, via the export queue if active, skipping it if unchanged; used by saveCanvas() and saveCanvasFlat()
+	 */
+	void privateSaveCanvas(TCanvas * canvas, TString directory, TString filename, TString rootFileName);
+	/**
+	 * @brief Saves a canvas in some file format at right location
+	 * @details Will, in default call, save every canvas in four file extensions in img/BASENAME/FILENAME.{svg,pdf,eps,root}
+	 * 
+	 * After enableIncrementalExport(), canvases which did not change since the last run are not saved again. After enableAsyncExport(), the vector formats are saved in the background and the canvas is written into img/BASENAME/BASENAME.root (key FILENAME) instead of its own ROOT file.
+	 * 
+	 * @param canvas The canvas as it should be saved
+	 * @param macroname A basenme, e.g. your macro name, to sort the images into folder
+	 * @param prefixImg Will create a img subdirectory in the current directory to put all the images in, if true.
+	 */
+	void saveCanvas(TCanvas * canvas, TString macroname, bool prefixImg = true);
+	/**
+	 * @brief Saves a canvas, no subdirectories; rest is equal as in saveCanvas()
+	 * @details With enableAsyncExport(), the ROOT file is MACROPREFIX.root (canvases.root without prefix).
+	 */
+	void saveCanvasFlat(TCanvas * canvas, TString macroPrefix = "");
+	/**
+	 * @}
+	 */
+	/**
+	 * @brief Creates a legend at my favorite position, formats it
+	 * @details Just a wrapper around the TLegend constructor to already have it configured with text size, background color etc.
+	 * 
+	 * @param x1 Start point of box on x axis
+	 * @param y1 Start point of box on y axis
+	 * @param x2 End point of box on x axis
+	 * @param y2 End point of box on y axis
+	 * @return Pointer to the legend, ready to be filled
+	 */
+	TLegend * plainLegend(float x1 = 0.7, float y1 = 0.62, float x2 = 0.96, float y2 = 0.695);
+	/**
+	 * @name Stack helper functions
+	 * @details Working with > 1 histogram at a time can become very cumbersome, if you're not using them in a THStack.
+	 * These helper functions here should make it easy to handle the stacks.
+	 * @{
+	 */
+	/**
+	 * @brief Converts an array of histograms (as `TObjArray`) into a THStack
+	 * @details Gives the stack proper name, tile, and axes on the way, so it can be manipulated as a usual ROOT object (because usually, it can't, as the stuff is only defined after drawing).
+	 *
+	 * The histograms are provided as a list in `TObjArray` to be more flexible and not deal with the overhead of more-complex constructors. At least for the time being the flexibilty is not made use of since only TH1D are used.
+	 *
+	 * For ROOT to generate axes, the histogram first needs to be drawn. In theory, `"goff"` should not print the canvas on your screen. Instead, a kind of empty canvas is drawn.
+	 * 
+	 * @param histos TObjArray with histograms. Take care of the order!
+	 * @param stackAddOption Optional string which is used when stack->Add(hist, option)
+	 * @return THStack of histograms
+	 */
+	THStack * histogramsToStack(TObjArray * histos, TString stackAddOption = "");
+
+	/**
+	 * @brief Creates a legend for a stack
+	 * @details Make sure the histograms in the stack have proper and short titles, as those are used for the legend
+	 * 
+	 * @param stack A stack of histograms
+	 * @param header The header of the legend
+	 * @param height y lower position of box
+	 * @param width x lower position of box
+	 * @param y2 y upper position of box
+	 * 
+	 * @return A legend. Dont' forget to Draw()
+	 */
+	TLegend * stackLegend(THStack * stack, TString header = "Histograms", double height = 0.75, double width = 0.7, double y2 = 0.93);
+	/**
+	 * @}
+	 */
+
+	/**
+	 * @name Streaming statistics
+	 * @details Statistics of a quantity collected value by value, e.g. during the event loop, without storing or binning the values: running moments (Welford's algorithm) and a quantile sketch (KLL). Both can be merged, e.g. the ones of several threads (see parallelOutput) or files.
+	 *
+	 * streamingStats gives robust estimates of center, core width and tail width from the quantiles, which do not depend on outliers or on a histogram range. They can be used for the binning of histograms (bookHistogram()) and for the ranges and starting values of fits (doubleGaussFit() with streamingStats), so no exploratory pass over the data is needed.
+	 * 
+	 * ~~~{.cpp}
+	 * andi::streamingStats stats;
+	 * for (...) stats.add(mass);  // first pass, or while filling something else
+	 * TH1D * h = stats.bookHistogram("hMass", "Mass");
+	 * for (...) h->Fill(mass);
+	 * TF1 * fit = andi::doubleGaussFit(h, stats);
+	 * ~~~
+	 * @{
+	 */
+	/**
+	 * @brief Running count, mean, variance, minimum and maximum, with Welford's algorithm
+	 */
+	struct runningMoments {
+		double n; ///< Number of values
+		double mean; ///< Mean of the values
+		double m2; ///< Sum of the squared distances to the mean
+		double min, max; ///< Smallest and largest value
+
+		runningMoments() : n(0), mean(0), m2(0), min(INFINITY), max(-INFINITY) {}
+		/**
+		 * @brief Adds a value
+		 */
+		void add(double x);
+		/**
+		 * @brief Adds all values of another accumulator (Chan's formula)
+		 */
+		void merge(const runningMoments & other);
+		double variance() const { return (n > 1) ? m2 / (n - 1) : 0; } ///< Unbiased variance
+		double stdDev() const { return std::sqrt(variance()); } ///< Standard deviation
+	};
+	/**
+	 * @brief Quantile sketch after Karnin, Lang and Liberty (KLL)
+	 * @details Keeps a few hundred values in levels of compactors: a value on level h stands for 2^h values. A full level is sorted and every second value (starting randomly at the first or second) moves up one level. The rank error of a quantile is about 1.7 / k for the default k; memory grows only logarithmically with the number of values.
+	 *
+	 * The random choices come from a fixed-seed generator, so results are reproducible.
+	 */
+	struct quantileSketch {
+		int k; ///< Capacity of the top level; larger is more precise
+		std::vector<std::vector<double> > levels; ///< Kept values per level
+		double n; ///< Number of values added
+		unsigned long long randomState; ///< State of the generator for the compaction offsets
+
+		explicit quantileSketch(int k = 200) : k(k), levels(1), n(0), randomState(0x9E3779B97F4A7C15ULL) {}
+		/**
+		 * @brief Number of values a level may hold before it is compacted; shrinks by 2/3 per level below the top
+		 */
+		size_t capacity(size_t level) const;
+		/**
+		 * @brief Adds a value
+		 */
+		void add(double x);
+		/**
+		 * @brief Compacts all levels which are full
+		 */
+		void compress();
+		/**
+		 * @brief Adds all values of another sketch
+		 */
+		void merge(const quantileSketch & other);
+		/**
+		 * @brief Estimated quantiles, e.g. {0.25, 0.5, 0.75}; NAN without values
+		 */
+		std::vector<double> quantiles(const std::vector<double> & probabilities) const;
+		/**
+		 * @brief Estimated quantile for probability p
+		 */
+		double quantile(double p) const;
+	};
+	/**
+	 * @brief Running moments and quantile sketch of one quantity, with robust estimates for fits and binning
+	 */
+	struct streamingStats {
+		runningMoments moments; ///< Count, mean, variance, minimum, maximum
+		quantileSketch sketch; ///< Quantiles
+
+		explicit streamingStats(int sketchSize = 200) : sketch(sketchSize) {}
+		/**
+		 * @brief Adds a value; NaN and infinite values are ignored
+		 */
+		void add(double x);
+		/**
+		 * @brief Adds all values of another accumulator, e.g. of another thread or file
+		 */
+		void merge(const streamingStats & other);
+		double n() const { return moments.n; } ///< Number of values
+		double center() const { return sketch.quantile(0.5); } ///< Median
+		/**
+		 * @brief Width of the core: the full width of the central 38.3% interval (center +- sigma / 2), which is sigma for a Gaussian
+		 */
+		double coreWidth() const;
+		/**
+		 * @brief Width of the tails: a quarter of the central 95.4% interval, which is sigma for a Gaussian
+		 */
+		double tailWidth() const;
+		/**
+		 * @brief Range for a fit: center +- nTailWidths tail widths, within the values seen
+		 */
+		std::pair<double, double> fitRange(double nTailWidths = 4) const;
+		/**
+		 * @brief Starting parameters for doubleGaussFit(): inner Gaussian with the core width, outer with the tail width
+		 * @details The fraction of the inner Gaussian follows from the variance: var = f coreWidth^2 + (1 - f) tailWidth^2. Constants are scaled to a histogram with bin width binWidth.
+		 *
+		 * @param parameters Array of six values to fill
+		 * @param binWidth Bin width of the histogram to fit
+		 */
+		void doubleGaussParameters(double * parameters, double binWidth) const;
+		/**
+		 * @brief Books a histogram with automatic binning
+		 * @details The range holds the central `coverage` of all values, plus 5% margin on both sides; outliers do not stretch it. The bin width follows the Freedman-Diaconis rule, 2 IQR / n^(1/3), limited to 10 to maxBins bins.
+		 *
+		 * @param name Name of the histogram
+		 * @param title Title of the histogram
+		 * @param maxBins Maximum number of bins
+		 * @param coverage Fraction of the values inside of the range (before the margin)
+		 * @return The new histogram, empty
+		 */
+		TH1D * bookHistogram(TString name, TString title, int maxBins = 500, double coverage = 0.999) const;
+	};
+	/**
+	 * @}
+	 */
+	/**
+	 * @name Gauss Fits
+	 * @details Helper functions for single and double Gauss fits.
+	 *
+	 * The pre-fits of the double Gauss fits reuse the functions of defaultFitWorkspace(), so repeated fits do not allocate new functions, and no temporary function is put into ROOT's global list of functions.
+	 * @{
+	 */
+	/**
+	 * @brief A Gaussian, as compiled function for TF1; parameters as TF1's "gaus"
+	 */
+	double gaussFunction(double * x, double * p);
+	/**
+	 * @brief Sum of two Gaussians, as compiled function for TF1; parameters as "gaus(0)+gaus(3)"
+	 */
+	double doubleGaussFunction(double * x, double * p);
+	/**
+	 * @brief A Gaussian which ignores all points with |x| <= p[4], as compiled function for TF1
+	 * @details Parameters 0 to 2 as TF1's "gaus"; parameter 4 is the half width of the excluded center and should be fixed. Parameter 3 is unused (kept, so that the layout of the parameters matches the other functions).
+	 */
+	double gaussExcludeCenterFunction(double * x, double * p);
+	/**
+	 * @brief Creates a TF1 from a compiled function without adding it to ROOT's global list of functions
+	 * @details Not thread-safe itself (it switches the global default for a moment), so call it before starting threads.
+	 */
+	TF1 * privateFunction(TString name, double (*function)(double *, double *), int nParameters, double rangeStart = 0, double rangeEnd = 1);
+	/**
+	 * @brief Creates a TF1 from a formula without adding it to ROOT's global list of functions
+	 */
+	TF1 * privateFunction(TString name, TString formula, double rangeStart = 0, double rangeEnd = 1);
+	/**
+	 * @brief A set of private, reusable fit functions
+	 * @details Used by every thread of fitHistograms(), and (one for all) by the single fit functions, see defaultFitWorkspace(). Creating the functions once and reusing them keeps the memory flat, no matter how many fits are done.
+	 *
+	 * With useFormulas, the Gaussians are TF1's predefined "gaus", for which ROOT determines the starting parameters itself on every fit; otherwise they are compiled functions, which need starting parameters but do not depend on TFormula.
+	 */
+	struct fitWorkspace {
+		TF1 * pre1, * pre2, * single, * proper;
+		TF1 * cut; ///< Gaussian with excluded center, see gaussExcludeCenterFunction()
+		fitWorkspace(TString suffix = "", bool useFormulas = false);
+		~fitWorkspace();
+	private:
+		fitWorkspace(const fitWorkspace &);  // owns the functions
+		fitWorkspace & operator=(const fitWorkspace &);
+	};
+	/**
+	 * @brief The workspace of the single fit functions (doubleGaussFit() and friends), created on first use
+	 * @details Not thread-safe; for parallel fits see fitHistograms(). The fits use its proper function; the double Gaussian functions returned are the copies that the fitted histograms own, as in gaussFit().
+	 */
+	fitWorkspace & defaultFitWorkspace();
+	/**
+	 * @brief Fits a Gaussian distribution to a histogram
+	 * @details Fits a Gaussian to the whole range of a histogram, formats the function and returns it. If verbose, it also prints out some information on it
+	 * 
+	 * @param hist Pointer to the histogram to fit the gaussian on
+	 * @param verbose If true, some output of the guassian fit is shown
+	 * 
+	 * @return Pointer to the function holding the fit, readily formatted
+	 */
+	TF1 * gaussFit(TH1 * hist, bool verbose = false);
+	/**
+	 * @brief The two pre-fits of a double Gaussian fit: one Gaussian in centralValue +- innerRangeMax and one in centralValue +- outerRangeMax
+	 * @details The fallback of doubleGaussFit() and doubleGaussFitNonZero() if doubleGaussSeed() cannot estimate the starting parameters. Uses the "gaus" functions of defaultFitWorkspace(), for which ROOT determines the starting parameters itself.
+	 * 
+	 * @param hist Histogram with the data to fit to
+	 * @param parameters Array of six values which is filled with the parameters of the inner and the outer pre-fit, in the order of doubleGaussFit()
+	 * @param centralValue Center of both ranges
+	 * @param innerRangeMax The positive half of the range of the inner pre-fit
+	 * @param outerRangeMax The positive half of the range of the outer pre-fit
+	 */
+	void doubleGaussPrefit(TH1 * hist, double * parameters, double centralValue, double innerRangeMax, double outerRangeMax);
+	/**
+	 * @brief Function for fitting a sum of two Gaussians (not coupled)
+	 * @details Fits the sum of two Gaussian distributions on a histogram in +- outerRangeMax around zero. The starting parameters are estimated from the bin contents with doubleGaussSeed(); only if that fails, two individual Gaussians are pre-fitted in, each, +- innerRangeMax (inner) and +- outerRangeMax (outer), see doubleGaussPrefit(). The ranges can be determined automatically as +- 10 percent of the axis maximum (inner) and +- 80 percent (outer), or be given. There's a dedicated function to specify the parameters of the double Gaussian fit manually, which is also called by this function.
+	 * 
+	 * @param hist Histogram with the data to fit to
+	 * @param verbose Print fitting parameters
+	 * @param useAutoRange Defined the ranges automatically to be 10% and 80% around zero
+	 * @param innerRangeMax The positive half of the range of the inner Gauss pre-fit (only used if pre-fits are needed)
+	 * @param outerRange The positive half of the fit range and of the range of the outer Gauss pre-fit. For non-zero-centered histograms, please use the manual function
+	 * @return A TF1 with a double Gaussian. First three parameters are the parameters of the inner Gaussian, second set of three parameters are those of the outer. It is owned by the histogram (see TH1::GetFunction()), as the function of gaussFit().
+	 */
+	TF1 * doubleGaussFit(TH1 * hist, bool verbose = false, bool useAutoRange = true, double innerRangeMax = 0.05, double outerRangeMax = 0.3);
+	/**
+	 * @brief Does the same as doubleGaussFit() but does not expected 0-centered distribution
+	 * @details Instead of choosing the range symmetrically around zero, the histogram's main is retrieved as the central value. As doubleGaussFit(), the starting parameters come from doubleGaussSeed(), with the pre-fits as fallback.
+	 *
+	 * This method should, at one point, replace the simple doubleGaussFit(). I've not yet had time to put this in.
+	 */
+	TF1 * doubleGaussFitNonZero(TH1 * hist, bool verbose = false, bool useAutoRange = true, double innerRangeMax = 0.05, double outerRangeMax = 0.3);
+	/**
+	 * @brief A double Gauss fit, but the inner bins are removed for the prefit of the outer Gaussian
+	 * @details Sometimes, for distributions with low statistics in the outer bands, the outer Gauss fit will fail with the other methods in this file. This function provides a kind of *hack-ish* solution to circumvent this.
+	 * 
+	 * For the outer Gauss prefit, the center-most bins, which fall in the range of -innerRangeMax to +innerRangeMax, are ignored (see gaussExcludeCenterFunction(); the histogram is not copied for this). The outer Gauss prefit is otherwise conducted just as in the other methods. The rest of the method is equivalent to the other methods.
+	 * 
+	 * No autoRange supplied, as I think it does not make sense here.
+	 */
+	TF1 * doubleGaussFitExcludeCenter(TH1 * hist, bool verbose = false, double innerRangeMax = 0.05, double outerRangeMax = 0.3);
+	/**
+	 * @brief Function for fitting a sum of two Gaussians (not coupled), providing the fit parameters
+	 * @details The manual version to the other function. Expects a double pointer as last argument, pointing to six pre-fit parameters from where to start the fitting minimization.
+	 * 
+	 * @param hist Histogram with data
+	 * @param verbose Print fit information
+	 * @param outerRange The range of the double Gaussian histogram to fit stuff
+	 * @param startParameters An array of six values from where to start the minimization
+	 * @return Pointer to TF1 with two Gaussians. See description of other function.
+	 */
+	TF1 * doubleGaussFit(TH1 * hist, bool verbose, double rangeStart, double rangeEnd, double * startParameters);
+	/**
+	 * @brief Estimates the starting parameters of a double Gaussian fit from the bin contents, without any fit
+	 * @details The replacement for the two pre-fits of doubleGaussFit() and doubleGaussFitNonZero() (see doubleGaussPrefit()), at the cost of one pass over the bins:
+	 *  * The center is the weighted mean of the bins above half of the maximum; the width of the inner (core) Gaussian follows from the full width at half maximum.
+	 *  * The amplitudes and the width of the outer (tail) Gaussian are chosen such that the double Gaussian has the peak height, the integral and the variance of the histogram. The variance is taken between the 0.5% and 99.5% quantiles, so single outliers do not spoil it.
+	 *  * The fit range is the center +- 5 outer sigmas, limited to the axis range.
+	 *
+	 * Does not depend on where the axis of the histogram starts or ends, so also works for asymmetric axes.
+	 * 
+	 * @param hist Histogram with data
+	 * @param parameters Array of six values which is filled with the starting parameters, in the order of doubleGaussFit()
+	 * @param rangeStart Filled with the start of the fit range
+	 * @param rangeEnd Filled with the end of the fit range
+	 * @return false if the histogram has less than five filled bins, too few to estimate two widths; the parameters are not usable then
+	 */
+	bool doubleGaussSeed(TH1 * hist, double * parameters, double & rangeStart, double & rangeEnd);
+	/**
+	 * @brief Double Gaussian fit with range and starting parameters from streaming statistics of the filled values
+	 * @details No pre-fits and no dependence on the booking range of the histogram; see streamingStats.
+	 * 
+	 * @param hist Histogram with the data to fit to, uniformly binned
+	 * @param stats Statistics of the values filled into hist
+	 * @param verbose Print fitting parameters
+	 * @param nTailWidths Fit range in tail widths around the center, see streamingStats::fitRange()
+	 * @return A TF1 with a double Gaussian, as doubleGaussFit()
+	 */
+	TF1 * doubleGaussFit(TH1 * hist, const streamingStats & stats, bool verbose = false, double nTailWidths = 4);
+	/**
+	 * @brief Double Gaussian fit with starting parameters and range from doubleGaussSeed(), instead of pre-fits
+	 * @details Does only one fit; the range is determined automatically. Falls back to doubleGaussFitNonZero() (with pre-fits) if the histogram is too sparse to be seeded. See benchmark.cpp for a comparison with the pre-fits.
+	 * 
+	 * @param hist Histogram with the data to fit to
+	 * @param verbose Print fitting parameters
+	 * @return A TF1 with a double Gaussian, as doubleGaussFit()
+	 */
+	TF1 * doubleGaussFitSeeded(TH1 * hist, bool verbose = false);
+	/**
+	 * @brief Converts a double Gaussian fit function into the two single Gaussians it is built from
+	 * @details If you ever want to draw both of the functions individually.
+	 *
+	 * If the pair already holds two functions (e.g. from an earlier call), they are reused instead of creating new ones.
+	 * 
+	 * @param funcGaus A pointer to a double Gaussian function
+	 * @param gaussians The two Gaussians; NULL pointers are replaced by new functions (owned by the caller)
+	 */
+	void doubleGaussToTwoGauss(TF1 * funcGaus, std::pair<TF1 *, TF1 * > & gaussians);
+	/**
+	 * @brief Converts a double Gaussian fit function into the two single Gaussians it is built from
+	 * @details If you ever want to draw both of the functions individually.
+	 * 
+	 * @param funcGaus A pointer to a double Gaussian function
+	 * @return A pair of pointers to the functions, the Gaussian is built from.
+	 */
+	std::pair<TF1 *, TF1 * > doubleGaussToTwoGauss(TF1* funcGaus);
+	/**
+	 * @}
+	 */
+	/**
+	 * @name Batch Gauss Fits
+	 * @details Fits many histograms at once, in parallel. The single fit functions above change gStyle and create their functions under fixed global names, so they cannot run concurrently. Here, every thread has its own, private set of functions: they are built from compiled C++ (no TFormula), they are not added to ROOT's list of functions, and they are reused for all fits of the thread. Fits are done with Minuit2, which is thread-safe.
+	 *
+	 * The results are returned as a table of fitResult. TF1s for drawing are only created if asked for.
+	 * @{
+	 */
+	/**
+	 * @brief Types of fits, same numbers as for the fit parameter of createCanvasDrawAndSave()
+	 */
+	enum fitTypes {
+		kFitGauss = 1, ///< Single Gaussian, as gaussFit()
+		kFitDoubleGauss = 2, ///< Double Gaussian with automatic ranges, as doubleGaussFitNonZero(): starting parameters from doubleGaussSeed(), pre-fits (doubleGaussPrefit()) if seeding fails
+		kFitDoubleGaussSeeded = 3 ///< Double Gaussian with starting parameters from doubleGaussSeed(), as doubleGaussFitSeeded(); pre-fits as kFitDoubleGauss if seeding fails
+	};
+	/**
+	 * @brief One line of the result table of fitHistograms()
+	 * @details Parameters are in the order of gaussFit() (constant, mean, sigma) and doubleGaussFit() (inner constant, mean, sigma, then outer constant, mean, sigma).
+	 */
+	struct fitResult {
+		TString name; ///< Name of the fitted histogram
+		int status; ///< Status of the final fit; 0 = ok
+		int nParameters; ///< 3 for a single, 6 for a double Gaussian
+		double parameters[6]; ///< Fitted parameters
+		double errors[6]; ///< Errors of the fitted parameters
+		double chi2; ///< χ² of the final fit
+		int ndf; ///< Number of degrees of freedom of the final fit
+		double rangeStart, rangeEnd; ///< Range of the final fit
+		unsigned int nCalls; ///< Number of evaluations of the minimized function, pre-fits included
+		TF1 * function; ///< Fitted function for drawing, if asked for; otherwise NULL
+		double constant(int i = 0) const { return parameters[3 * i]; } ///< Constant of Gaussian i (0 = inner, 1 = outer)
+		double mean(int i = 0) const { return parameters[3 * i + 1]; } ///< Mean of Gaussian i
+		double sigma(int i = 0) const { return parameters[3 * i + 2]; } ///< Sigma of Gaussian i
+		double chi2PerNdf() const { return (ndf > 0) ? chi2 / ndf : 0; } ///< χ² / NDF
+	};
+	/**
+	 * @brief Fits one histogram using the functions of a workspace; thread-safe as long as every thread has its own workspace
+	 * @details Does what gaussFit(), doubleGaussFitNonZero() (automatic ranges) or doubleGaussFitSeeded() do, without touching any global state. Needs Minuit2 as default minimizer to be thread-safe, see fitHistograms().
+	 */
+	fitResult fitHistogram(TH1 * hist, fitWorkspace & workspace, int fitType = kFitDoubleGauss);
+	/**
+	 * @brief Fits many histograms in parallel
+	 * @details Every thread gets its own fitWorkspace and takes the next histogram not yet fitted. The default minimizer is switched to Minuit2 for the time of the fits (and switched back afterwards), as the old Minuit is not thread-safe. The histograms must all be different objects.
+	 * 
+	 * @param histograms The histograms to fit
+	 * @param fitType kFitGauss, kFitDoubleGauss or kFitDoubleGaussSeeded
+	 * @param makeFunctions Create a TF1 with the fitted parameters per histogram (fitResult::function), formatted as in doubleGaussFit(); created with privateFunction(), so not in ROOT's global list of functions
+	 * @param nThreads Number of threads, 0 = all cores
+	 * @return One fitResult per histogram, in the order of histograms
+	 */
+	std::vector<fitResult> fitHistograms(const std::vector<TH1 *> & histograms, int fitType = kFitDoubleGauss, bool makeFunctions = false, int nThreads = 0);
+	/**
+	 * @brief Prints a table of fit results
+	 */
+	void printFitResults(const std::vector<fitResult> & results);
+	/**
+	 * @}
+	 */
+
+	/**
+	 * @brief Kinds of plots of createCanvasDrawAndSave(), by the type of the drawn object
+	 */
+	enum plotKinds {
+		kPlotTH1 = 1, ///< TH1, optionally with (double) Gaussian fit
+		kPlotTH2 = 2, ///< TH2
+		kPlotObject = 3, ///< Any other TObject, with draw parameters
+		kPlotStack = 4 ///< THStack, with legend
+	};
+	/**
+	 * @brief Everything needed to draw a plot of createCanvasDrawAndSave() later
+	 */
+	struct plotSpec {
+		int kind; ///< See plotKinds
+		TObject * object; ///< The object to draw; needs to live until the plot is rendered
+		TString filename; ///< Canvas title, file name
+		TString basename; ///< Base name for saveCanvas()
+		bool save; ///< Save the canvas after drawing
+		int fit; ///< Fit type for kPlotTH1
+		TString drawParams; ///< Draw parameters for kPlotObject
+		TString stackTitle; ///< Legend title for kPlotStack
+		double boxStartY, boxStartX; ///< Legend position for kPlotStack
+
+		plotSpec(int kind = kPlotObject, TObject * object = 0, TString filename = "", TString basename = "", bool save = true) : kind(kind), object(object), filename(filename), basename(basename), save(save), fit(0), drawParams(""), stackTitle("Histograms"), boxStartY(0.7), boxStartX(0.7) {}
+	};
+	/**
+	 * @brief Plots recorded by createCanvasDrawAndSave() after enableDeferredPlots(); NULL if plots are drawn right away
+	 */
+	std::vector<plotSpec> *& deferredPlots();
+	/**
+	 * @brief Lets createCanvasDrawAndSave() only record what to draw, instead of creating, drawing and saving a canvas
+	 * @details No canvas is created (createCanvasDrawAndSave() returns NULL) until renderDeferred() is called, e.g. only for some of the plots or in a separate job, see writeDeferred(). Fits are also only done when rendering.
+	 * 
+	 * @param enable Switch recording on or off; switching off forgets all plots which were not rendered
+	 */
+	void enableDeferredPlots(bool enable = true);
+	/**
+	 * @brief Records a plot if enableDeferredPlots() is active
+	 * @return true if recorded, i.e. nothing is to be drawn now
+	 */
+	bool deferPlot(const plotSpec & spec);
+	/**
+	 * @name Canvas Drawing and Saving
+	 * @details Methods for drawing a histogram on a canvas and saving the canvas. Usually, the canvas is returned.
+	 * 
+	 * Methods are in place which also apply a (double) Gaussian fit.
+	 * 
+	 * With enableDeferredPlots(), no canvas is drawn; the plots are only recorded and drawn later with renderDeferred(), possibly in another job (writeDeferred(), readDeferred()).
+	 * 
+	 * @{
+	 */
+	/**
+	 * @brief Draws a (1D) histogram onto a canvas, makes the title and saves it (optionally)
+	 * @details This few lines is the overhead I'm using all day, so I made this function. The canvas name is chosen as per the histogram name, with my convention (histograms start with a h, the according canvas is the same name, but with a c in front). There are some optional arguments
+	 * 
+	 * @param h Pointer to 1D histogram
+	 * @param filename The title of the canvas, also the name the images will be saved with
+	 * @param basename The basename for andi::saveCanvas, a prefix for all the images
+	 * @param save Should files be saved? Slows everything down, hence an option (see also enableAsyncExport())
+	 * @param fit Should there be a Gaussian fit?
+	 * @return TCanvas point. You dont need to use it, but if you want, whoops, here it is. NULL with enableDeferredPlots().
+	 */
+	TCanvas * createCanvasDrawAndSave(TH1 * h, TString filename, TString basename, bool save = true, int fit = 0);
+	/**
+	 * @brief See createCanvasDrawAndSave(). This version fits a Gauss
+	 */
+	TCanvas * createCanvasFitDrawAndSave(TH1 * h, TString filename, TString basename, bool save = true, int fit = 1);
+	/**
+	 * @brief See createCanvasDrawAndSave(). This version fits a double Gauss.
+	 */
+	TCanvas * createCanvasFitDoubleDrawAndSave(TH1 * h, TString filename, TString basename, bool save = true, int fit = 2);
+	/**
+	 * @brief See createCanvasDrawAndSave(). For TH2, moves the Z axis to the left as well.
+	 */
+	TCanvas * createCanvasDrawAndSave(TH2 * h, TString filename, TString basename, bool save = true);
+	/**
+	 * @brief See createCanvasDrawAndSave(). For everything which comes from TObject. Like TGraph and sorts.
+	 */
+	TCanvas * createCanvasDrawAndSave(TObject * h, TString filename, TString basename, bool save = true, TString drawParams = "");
+	/**
+	 * @brief See createCanvasDrawAndSave(). For THStack. Also creates a legend.
+	 */
+	TCanvas * createCanvasDrawAndSave(THStack * stack, TString filename, TString basename, bool save = true, TString stackTitle = "Histograms", double boxStartY = 0.7, double boxStartX = 0.7);
+	/**
+	 * @brief Draws and saves recorded plots, see enableDeferredPlots()
+	 * @details Rendered plots are removed from the record. Canvases which are saved are deleted afterwards, the others are kept (they are meant to be looked at). Combine with enableAsyncExport() and enableIncrementalExport() to speed up saving.
+	 * 
+	 * @param pattern Only render plots whose file name matches this wildcard pattern, e.g. "Mass*"; all if empty
+	 * @return Number of rendered plots
+	 */
+	int renderDeferred(TString pattern = "");
+	/**
+	 * @brief Writes the recorded plots with their objects into a ROOT file, to render them in a separate step with readDeferred() and renderDeferred()
+	 * @details Plot i is stored as object `plot_i` and a list `spec_i` with its settings.
+	 * 
+	 * @param fileName Name of the ROOT file, which is recreated
+	 * @return Number of written plots
+	 */
+	int writeDeferred(TString fileName);
+	/**
+	 * @brief Reads plots written by writeDeferred() and records them, as if they came from createCanvasDrawAndSave() with enableDeferredPlots()
+	 * @details Enables deferred plots if needed. The objects are read into memory and not deleted.
+	 * 
+	 * @param fileName Name of the ROOT file
+	 * @return Number of read plots
+	 */
+	int readDeferred(TString fileName);
+	/**
+	 * @}
+	 */
+	/**
+	 * @brief Reads in a Tree from multiple Files
+	 * @details For data collections of the same structure it is possible to append the trees after one another.
+	 * This functions gives a convenient way to do so.
+	 * 
+	 * The fileName parameter should point to a text file with the file name of a root file per line, like:
+	 * ~~~
+	 * file1.root
+	 * file2.root
+	 * ~~~
+	 * The function returns a TTree with combined content.
+	 * 
+	 * @param treeName Name of the tree in every file. Has to be equal.
+	 * @param fileName A text file with one file per line.
+	 * 
+	 * @return TTree of a chain of input files. The intermediate TChain is casted to a TTree, because of my macros.
+	 *
+	 * To read the files in parallel instead of one after another, see processFilesParallel().
+	 */
+	TTree * treeFromMultipleFiles(TString treeName, TString fileName);
+
+	/**
+	 * @name Preselection entry lists
+	 * @details The preselection (e.g. the defaultCut of the cut benchmarks) never changes during a cut scan, nor between scans of different quantities. Instead of evaluating it on every entry again for every step, it is evaluated once per tree into a TEntryList; the tree then only reads the entries in the list (TTree::SetEntryList()). As a preselection usually keeps only a small fraction of the background, every scan after the first one touches only that fraction of the data.
+	 *
+	 * The lists are kept in memory for the whole session, keyed by tree, selection and the modification times and sizes of the input files, so a changed input file gives a new list. With a cache file, they are also stored on disk and reused in later runs, e.g. next to the file list:
+	 * ~~~
+	 * andi::enablePreselectionCache(true, "files.txt.preselection.root");
+	 * TTree * tree = andi::treeFromMultipleFiles("ntp", "files.txt");
+	 * andi::cuts::cutBenchmark(tree, treeBkg, 1., "Dpt", defaultCut, steps, best);  // defaultCut evaluated only once per tree
+	 * andi::applyPreselection(tree, defaultCut);  // eventLoop::run() now runs only over the preselected entries
+	 * ~~~
+	 * @{
+	 */
+	/**
+	 * @brief Number of entries a tree will actually process: the length of its entry list, if it has one
+	 */
+	Long64_t entriesToProcess(TTree * tree);
+	/**
+	 * @brief First entries of all clusters of a tree, followed by the number of entries
+	 * @details A cluster is the range of entries whose baskets are written together; reading whole clusters touches every basket only once. Works on trees only; for a TChain, use the trees of its files.
+	 */
+	std::vector<Long64_t> clusterStarts(TTree * tree);
+	/**
+	 * @brief Key of the preselection of a tree: MD5 sum of tree name, selection and name, modification time and size of every input file
+	 * @details Trees which do not live in a file are keyed by their address; their lists are never stored on disk. If the tree has an entry list, the numbers of its entries are part of the key, as the preselection is evaluated only on them.
+	 */
+	TString preselectionKey(TTree * tree, TCut selection, bool * persistable = 0);
+	/**
+	 * @brief Entry lists of preselections, in memory and optionally in a ROOT file
+	 * @details Usually used via preselectionList() and enablePreselectionCache().
+	 */
+	struct preselectionCache {
+		bool enabled; ///< Use the lists in the cut benchmarks (see scopedPreselection)
+		TString fileName; ///< ROOT file to store the lists in; none if empty
+		std::map<TString, TEntryList *> lists; ///< Lists by preselectionKey(), owned by the cache
+
+		preselectionCache() : enabled(false) {}
+		~preselectionCache();
+		/**
+		 * @brief Forgets all lists in memory (not the ones in the file)
+		 */
+		void clear();
+		/**
+		 * @brief The list of entries of tree passing selection, from memory, from the cache file or evaluated with TTree::Draw()
+		 * @details If the tree already has an entry list, only its entries are evaluated: the result is the part of them passing selection.
+		 */
+		TEntryList * get(TTree * tree, TCut selection);
+	private:
+		preselectionCache(const preselectionCache &);  // owns the lists
+		preselectionCache & operator=(const preselectionCache &);
+	};
+	/**
+	 * @brief The preselection cache of this session
+	 */
+	preselectionCache & preselections();
+	/**
+	 * @brief Switches the use of cached preselections in the cut benchmarks on or off
+	 * 
+	 * @param enable Evaluate the defaultCut of the cut benchmarks once per tree and reuse it
+	 * @param fileName ROOT file to also store the lists in, for later runs; only in memory if empty
+	 */
+	void enablePreselectionCache(bool enable = true, TString fileName = "");
+	/**
+	 * @brief The entries of a tree passing a selection, evaluated only once per session (or cache file)
+	 * @return Entry list owned by preselections(), 0 on errors
+	 */
+	TEntryList * preselectionList(TTree * tree, TCut selection);
+	/**
+	 * @brief Restricts a tree to the entries passing a selection, with a cached entry list
+	 * @details All following TTree::Draw(), TTree::GetEntries(cut), cut benchmarks and eventLoop::run() only process these entries. If the tree already has an entry list, the restriction is applied on top of it (see preselectionCache::get()). An empty selection removes any restriction.
+	 * @return If the entry list could be applied
+	 */
+	bool applyPreselection(TTree * tree, TCut selection);
+	/**
+	 * @brief Applies a cached preselection to a tree while in scope, if preselections().enabled is set
+	 * @details The selection which still has to be applied is in remaining: empty, if the entry list took care of it, otherwise the selection itself. If the tree already has an entry list, the preselection is evaluated on its entries only, and the list is put back afterwards.
+	 */
+	struct scopedPreselection {
+		TTree * tree; ///< The tree restricted to the preselection, 0 if none
+		TEntryList * previous; ///< Entry list of the tree before
+		TCut remaining; ///< Cut still to be applied to the entries of tree
+
+		scopedPreselection(TTree * _tree, TCut selection);
+		~scopedPreselection();
+	private:
+		scopedPreselection(const scopedPreselection &);
+		scopedPreselection & operator=(const scopedPreselection &);
+	};
+	/**
+	 * @}
+	 */
+
+	/**
+ 	 * @namespace cuts A namespace for my cut benchmarks.
+	 */
+	namespace cuts {
+
+		double sigBkgRatio(double sig, double bkg);
+		/**
+		 * @brief Counts the two TTree::GetEntries() calls of one step of a cut benchmark, see instruments()
+		 * @details Every call reads the whole tree.
+		 */
+		void countGetEntries(TTree * treeSig, TTree * treeBkg);
+		/**
+		 * @brief Prints one step of a cut benchmark, if instruments().trace is set
+		 */
+		void traceStep(TCut cut, double entriesSig, double entriesBkg, double ratio);
+		/**
+		 * @name Sorted Columns
+		 * @details Single-pass engine for the cut benchmarks. Instead of asking the TTree for the number of entries passing a cut for every step (which reads the whole tree, every time), the tested quantity is read once, sorted, and every step is answered with a binary search.
+		 *
+		 * The classic cut benchmarks format every step into a cut string with `%f`, so the thresholds are effectively rounded to six decimals. The sorted column methods do the same rounding (see formattedValue()), so the results are identical to the ones of the TTree::GetEntries() version.
+		 *
+		 * Only works for scalar quantities (one value per entry), which is what the cut benchmarks are made for anyway.
+		 * @{
+		 */
+		/**
+		 * @brief Rounds a value the same way a `TString::Format("%f", value)` cut string does
+		 */
+		double formattedValue(double value);
+		/**
+		 * @brief Reads a quantity of all entries passing a selection into a sorted vector
+		 * @details Uses TTree::Draw() with `goff`, so it works for TChains and for everything which can be given as a TTree formula. The values are sorted in ascending order. NaN values are dropped, as they never pass any `>` or `<` cut either.
+		 * 
+		 * @param tree The TTree (or TChain) to read from
+		 * @param quantity The quantity to read, e.g. 'mass'
+		 * @param selection Cut which entries need to pass to be read, e.g. the defaultCut of the cut benchmarks
+		 * @return Sorted vector of all values of quantity
+		 */
+		std::vector<double> sortedColumn(TTree * tree, TCut quantity, TCut selection = "");
+		/**
+		 * @brief Number of entries in a sorted column with value > threshold
+		 */
+		Long64_t countAbove(const std::vector<double> & column, double threshold);
+		/**
+		 * @brief Number of entries in a sorted column with lower < value < upper
+		 */
+		Long64_t countBetween(const std::vector<double> & column, double lower, double upper);
+		/**
+		 * @brief Cut benchmark on sorted columns. For list of limits
+		 * @details Same as the TTree version of cutBenchmark(), but for columns already read with sortedColumn(). Every step costs two binary searches instead of two reads of the tree. Can be used to test many lists of limits on the same data.
+		 * 
+		 * @param columnSig Sorted column of the SIGNAL quantity (after default cut)
+		 * @param columnBkg Sorted column of the BACKGROUND quantity (after default cut)
+		 * @param scaleFactorBkg Value with which the background is scaled
+		 * @param steps Vector of quantities, e.g. {1, 2, 3}
+		 * @param bestRatio The best ratio will be filled into this variable
+		 * @return Graph with the S/B ratio for every evaluated point
+		 */
+		TGraph * cutBenchmark(const std::vector<double> & columnSig, const std::vector<double> & columnBkg, double scaleFactorBkg, std::vector<double> steps, double & bestRatio);
+		/**
+		 * @}
+		 */
+		/**
+		 * @brief Cut benchmark. For list of limits
+		 * @details Finds the best signal to background ratio for a quantity and several limits, returns a graph of the ratios.
+		 * Every step can be printed with `enableInstrumentation(true, true)`.
+		 * 
+		 * There are different version of this method, for different uses cases. Usually only the steps parameter is different, e.g. sometimes a list of values, sometimes a range. The working principle of all methods is the same, though.
+		 *
+		 * With singlePass, the testCut quantity is read only once per tree (see sortedColumn()) instead of twice per step. The resulting graph is the same, but a lot faster for many steps.
+		 *
+		 * With enablePreselectionCache(), the defaultCut is evaluated only once per tree and session, and all steps only read the entries passing it (see scopedPreselection). This holds for all cut benchmarks with trees.
+		 * 
+		 * @param treeSig TTree holding testCut quantity to benchmark for SIGNAL
+		 * @param treeBkg TTree holding testCut quantity to benchmark for BACKGROUND
+		 * @param scaleFactorBkg Value with which the background is scaled
+		 * @param testCut The cut which is tested, e.g. 'mass'
+		 * @param defaultCut A pre-cut applied to all measurements of entries. Choose an empty string, if you don't need to apply any cuts. I'd like to define a TCut cutNone = ""
+		 * @param steps Vector of quantities, e.g. {1, 2, 3}
+		 * @param bestRatio The best ratio will be filled into this variable
+		 * @param singlePass Read the trees only once and use sorted columns
+		 * @return Graph with the S/B ratio for every evaluated point
+		 */
+		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, std::vector<double> steps, double & bestRatio, bool singlePass = false);
+		/**
+		 * @brief Cut benchmark. For a simple upper limit and lower limit. Deprecated, as this can also be done with the other functions.
+		 * @details singlePass as in the other cutBenchmark().
+		 **/
+		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, std::pair<double, double> rangeLimits, Int_t numberOfSteps, bool singlePass = false);
+		/**
+		 * @brief Cut benchmark on sorted columns. For a symmetrical range around a central value.
+		 * @details Same as the TTree version of cutBenchmarkSymmetric(), but for columns already read with sortedColumn(). The number of entries inside of every window is the difference of two positions in the sorted column, so the cost does not grow with numberOfSteps times tree size anymore.
+		 **/
+		TGraph * cutBenchmarkSymmetric(const std::vector<double> & columnSig, const std::vector<double> & columnBkg, double scaleFactorBkg, double centralValue, double rangeLimit, Int_t numberOfSteps, double & _lowerLimit, double & _upperLimit);
+		/**
+		 * @brief Cut benchmark. For a symmetrical range around a central value.
+		 * @details singlePass reads the testCut quantity once per tree and counts the entries of all windows in the sorted columns, see the column version of this function.
+		 **/
+		TGraph * cutBenchmarkSymmetric(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, double centralValue, double rangeLimit, Int_t numberOfSteps, double & _lowerLimit, double & _upperLimit, bool singlePass = false);
+		/**
+		 * @name Adaptive cut search
+		 * @details Instead of evaluating the figure of merit on numberOfSteps evenly spaced points, most of which lie far away from the optimum, the search starts with a coarse scan of the range and then refines only around the best point: the step is halved and the two new neighbours of the best point are evaluated, until the requested resolution is reached. Usually a few dozen evaluations suffice, where an even scan to the same resolution would need hundreds or thousands.
+		 *
+		 * The refinement also stops when the figure of merit is flat within its statistical uncertainty: if the best point is not better than both of its neighbours by more than its own uncertainty, the data cannot tell the optimum any more precisely.
+		 *
+		 * This pays off most where every evaluation reads the trees, i.e. for quantities which cannot be answered from a sorted column (derived or correlated variables, several cuts at once). All evaluated points are returned as graph, sorted by cut value.
+		 * @{
+		 */
+		/**
+		 * @brief Uncertainty of sigBkgRatio() for given uncertainties of signal and background
+		 */
+		double sigBkgRatioError(double sig, double bkg, double errorSig, double errorBkg);
+		/**
+		 * @brief Statistical uncertainty of sigBkgRatio(), from Poisson errors of the unscaled entries
+		 * 
+		 * @param sig Number of signal entries
+		 * @param bkg Number of background entries, already scaled with scaleFactorBkg
+		 * @param scaleFactorBkg Value with which the background was scaled
+		 */
+		double sigBkgRatioError(double sig, double bkg, double scaleFactorBkg);
+		/**
+		 * @brief Coarse-to-fine search for the maximum of a figure of merit in one cut value
+		 * 
+		 * @param figureOfMerit Returns the figure of merit for a cut value and sets the second argument to its uncertainty
+		 * @param lower Lowest cut value to test
+		 * @param upper Highest cut value to test
+		 * @param resolution Requested precision of the best cut value
+		 * @param best The best cut value will be filled into this variable
+		 * @param nCoarse Number of intervals of the first, even scan
+		 * @param maxEvaluations Maximum number of evaluations of figureOfMerit
+		 * @return Graph of the figure of merit at every evaluated point
+		 */
+		TGraph * adaptiveSearch(const std::function<double(double, double &)> & figureOfMerit, double lower, double upper, double resolution, double & best, int nCoarse = 10, int maxEvaluations = 40);
+		/**
+		 * @brief Cut benchmark with adaptive search. For a lower limit in a range
+		 * @details As the range version of cutBenchmark(), but with adaptiveSearch() instead of an even scan; testCut can be any TTree formula.
+		 * 
+		 * @param treeSig TTree holding testCut quantity to benchmark for SIGNAL
+		 * @param treeBkg TTree holding testCut quantity to benchmark for BACKGROUND
+		 * @param scaleFactorBkg Value with which the background is scaled
+		 * @param testCut The cut which is tested, e.g. 'Dpt', the cut is testCut > value
+		 * @param defaultCut A pre-cut applied to all measurements of entries
+		 * @param rangeLimits Range of cut values to search
+		 * @param resolution Requested precision of the best cut value
+		 * @param bestCut The best cut value will be filled into this variable
+		 * @param maxEvaluations Maximum number of steps, see adaptiveSearch()
+		 * @return Graph with the S/B ratio for every evaluated point
+		 */
+		TGraph * cutBenchmarkAdaptive(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, std::pair<double, double> rangeLimits, double resolution, double & bestCut, int maxEvaluations = 40);
+		/**
+		 * @brief Cut benchmark with adaptive search. For a symmetrical range around a central value.
+		 * @details As cutBenchmarkSymmetric(), but the half width of the window is found with adaptiveSearch(), between resolution and rangeLimit. The graph shows the figure of merit over the full width of the window, as the one of cutBenchmarkSymmetric().
+		 **/
+		TGraph * cutBenchmarkSymmetricAdaptive(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, double centralValue, double rangeLimit, double resolution, double & _lowerLimit, double & _upperLimit, int maxEvaluations = 40);
+		/**
+		 * @}
+		 */
+		/**
+		 * @name Quick look
+		 * @details Approximate cut benchmarks for interactive work: instead of all entries, only a fixed-size random sample of every tree is read (whole blocks of entries inside of a cluster, see blockSample(), so the cost does not grow with the size of the trees and only few baskets are read), and the number of passing entries is extrapolated to the full trees. The figure of merit comes with an error band from the sampling, which shows which part of the curve is already significant.
+		 *
+		 * With refine, the steps which are compatible with the best one within the error bands are evaluated again on full statistics.
+		 *
+		 * ~~~
+		 * andi::cuts::quickLookResult r = andi::cuts::cutBenchmarkQuickLook(treeSig, treeBkg, 0.1, "Dpt", defaultCut, steps, 20000);
+		 * r.estimate->Draw("A3");  // band
+		 * r.estimate->Draw("LX");  // central curve
+		 * ~~~
+		 * @{
+		 */
+		/**
+		 * @brief Result of the quick look cut benchmarks
+		 */
+		struct quickLookResult {
+			TGraphAsymmErrors * estimate; ///< Figure of merit estimated from the samples, with the sampling uncertainty as error band
+			TGraph * refined; ///< Figure of merit on full statistics for the steps compatible with the best estimate; 0 without refine
+			double bestCut; ///< Best step (of refined, if there is one)
+			Long64_t sampleSize[2]; ///< Number of sampled entries of signal, background
+			Long64_t population[2]; ///< Number of entries the samples were drawn from, of signal, background
+			Long64_t blocks[2]; ///< Number of sampled blocks of signal, background
+		};
+		/**
+		 * @brief First entries of all clusters of a tree or chain, followed by the number of entries
+		 * @details As clusterStarts(), but for a TChain the clusters of all its files, in entry numbers of the chain. Every file of the chain is opened for this, as TChain::GetEntries() does anyway.
+		 */
+		std::vector<Long64_t> allClusterStarts(TTree * tree);
+		/**
+		 * @brief Entry numbers of a random sample of blocks of a tree, sorted
+		 * @details The entries are split into blocks, contiguous ranges inside of one cluster with at most sampleSize / 20 entries, and whole blocks are drawn at random (without replacement) until the sample holds sampleSize entries. A uniform sample of single entries would touch almost every basket of the tree; blocks touch only the baskets of a few clusters, while there are still enough of them to estimate the uncertainty (see extrapolatedCount()). If the tree has an entry list (e.g. a preselection), the blocks are made of its entries.
+		 *
+		 * @param tree The tree (or chain)
+		 * @param sampleSize Number of entries to draw; all entries, if the tree has fewer
+		 * @param blocks Filled with the index (in the returned vector) of the first entry of every sampled block, followed by the size of the sample
+		 * @param nBlocks Filled with the number of blocks the sample was drawn from
+		 * @param seed Seed of the random generator
+		 */
+		std::vector<Long64_t> blockSample(TTree * tree, Long64_t sampleSize, std::vector<Long64_t> & blocks, Long64_t & nBlocks, unsigned int seed = 4357);
+		/**
+		 * @brief A quantity read for a random sample of blocks of a tree, see sampledColumn()
+		 */
+		struct sampledBlocks {
+			std::vector<std::vector<double> > columns; ///< Values passing the selection, sorted, per sampled block
+			std::vector<Long64_t> drawn; ///< Number of sampled entries per block, before the selection
+			Long64_t population; ///< Number of entries the sample was drawn from
+			Long64_t nBlocks; ///< Number of blocks the sample was drawn from
+		};
+		/**
+		 * @brief Reads a quantity of the entries of a random sample passing a selection, block by block
+		 * @details As sortedColumn(), but only for the entries of blockSample(), with one sorted column per sampled block.
+		 */
+		sampledBlocks sampledColumn(TTree * tree, TCut quantity, TCut selection, Long64_t sampleSize, unsigned int seed = 4357);
+		/**
+		 * @brief Extrapolates the number of passing entries of a sample of blocks to the whole population, with the sampling uncertainty
+		 * @details Ratio estimator of the passing fraction. The uncertainty comes from the spread of the number of passing entries between the blocks (with the correction for sampling without replacement), so it accounts for the entries of one block being alike, e.g. written close in time; for blocks of single entries, it is the binomial uncertainty. With a single sampled block, the binomial uncertainty of a single entry is taken.
+		 *
+		 * @param passed Number of passing entries per sampled block
+		 * @param drawn Number of sampled entries per block
+		 * @param population Number of entries the sample was drawn from
+		 * @param nBlocks Number of blocks the sample was drawn from
+		 * @param error Filled with the uncertainty of the extrapolated number
+		 */
+		double extrapolatedCount(const std::vector<Long64_t> & passed, const std::vector<Long64_t> & drawn, Long64_t population, Long64_t nBlocks, double & error);
+		/**
+		 * @brief Common part of the quick look cut benchmarks
+		 * 
+		 * @param xValues x value of every step in the graphs
+		 * @param cutValues Cut value of every step, as reported in bestCut
+		 * @param count Number of entries of a sorted column passing step iStep
+		 * @param zeroIfEmpty If steps without signal or without background get a ratio of 0, as in cutBenchmarkSymmetric()
+		 */
+		quickLookResult quickLook(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, const std::vector<double> & xValues, const std::vector<double> & cutValues, const std::function<Long64_t(const std::vector<double> &, size_t)> & count, Long64_t sampleSize, bool refine, unsigned int seed, bool zeroIfEmpty = false);
+		/**
+		 * @brief Quick look cut benchmark. For list of limits
+		 * @details As cutBenchmark(), but on random samples of sampleSize entries per tree, see the description of this group.
+		 * 
+		 * @param treeSig TTree holding testCut quantity to benchmark for SIGNAL
+		 * @param treeBkg TTree holding testCut quantity to benchmark for BACKGROUND
+		 * @param scaleFactorBkg Value with which the background is scaled
+		 * @param testCut The cut which is tested, e.g. 'mass'
+		 * @param defaultCut A pre-cut applied to all measurements of entries
+		 * @param steps Vector of quantities, e.g. {1, 2, 3}
+		 * @param sampleSize Number of entries to sample per tree
+		 * @param refine Evaluate the steps compatible with the best one again on full statistics
+		 * @param seed Seed of the random generator
+		 * @return Estimated curve with error band, refined curve and best cut
+		 */
+		quickLookResult cutBenchmarkQuickLook(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, std::vector<double> steps, Long64_t sampleSize = 10000, bool refine = false, unsigned int seed = 4357);
+		/**
+		 * @brief Quick look cut benchmark. For a symmetrical range around a central value.
+		 * @details As cutBenchmarkSymmetric(), but on random samples of sampleSize entries per tree: windows without signal or without background get a ratio of 0, the graphs show the ratio against the full width of the window, and the best window is filled into _lowerLimit and _upperLimit. bestCut is the full width of the best window.
+		 **/
+		quickLookResult cutBenchmarkSymmetricQuickLook(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, TCut testCut, TCut defaultCut, double centralValue, double rangeLimit, Int_t numberOfSteps, double & _lowerLimit, double & _upperLimit, Long64_t sampleSize = 10000, bool refine = false, unsigned int seed = 4357);
+		/**
+		 * @}
+		 */
+		/**
+		 * @name Cut Grids
+		 * @details Optimises the cuts on up to four quantities at the same time, instead of one after another with the other cuts frozen in the defaultCut.
+		 *
+		 * The quantities are read only once per tree (see columns()). Every entry is then sorted into an N-dimensional histogram by the number of thresholds it passes per axis. Cumulative sums along every axis then give the number of entries passing every cell of the grid. Filling, summing and evaluating the figure of merit run on all cores.
+		 *
+		 * A window on one quantity can be scanned by giving the quantity twice, once as lower and once as upper limit.
+		 * @{
+		 */
+		/**
+		 * @brief Reads several quantities of all entries passing a selection
+		 * @details Like sortedColumn(), but for up to four quantities at once, which are kept in the order of the entries (not sorted!), so that `values[0][i]` and `values[1][i]` belong to the same entry.
+		 * 
+		 * @param tree The TTree (or TChain) to read from
+		 * @param quantities Up to four quantities to read
+		 * @param selection Cut which entries need to pass to be read
+		 * @return One vector per quantity
+		 */
+		std::vector<std::vector<double> > columns(TTree * tree, std::vector<TString> quantities, TCut selection = "");
+		/**
+		 * @brief One axis of a cut grid
+		 */
+		struct gridAxis {
+			TString quantity; ///< The quantity to cut on, e.g. 'mass'
+			std::vector<double> steps; ///< The thresholds to test, any order
+			bool lowerLimit; ///< If true, the cut is quantity > step, otherwise quantity < step
+			gridAxis(TString _quantity = "", std::vector<double> _steps = std::vector<double>(), bool _lowerLimit = true) : quantity(_quantity), steps(_steps), lowerLimit(_lowerLimit) {}
+		};
+		/**
+		 * @brief Result of cutBenchmarkGrid()
+		 */
+		struct gridResult {
+			std::vector<double> bestCuts; ///< Best threshold per axis
+			double bestRatio; ///< Figure of merit of the best cell
+			TCut bestCut; ///< The best cell as a cut, ready to be used with TTree::Draw()
+			THnD * ratios; ///< Figure of merit of every cell of the grid. Axes follow the (sorted) steps.
+		};
+		/**
+		 * @brief Bin edges centered around sorted steps, as used for the axes of gridResult::ratios
+		 */
+		std::vector<double> stepBinEdges(const std::vector<double> & steps);
+		/**
+		 * @brief Counts the entries passing every cell of a cut grid
+		 * @details Internal method of cutBenchmarkGrid(). The thresholds in sortedSteps must be sorted in ascending order. The cells are numbered with the thresholds of lower limits ascending and the thresholds of upper limits descending, so that passing cell k of an axis always means passing all cells < k as well. The returned vector has (nSteps + 1) entries per axis; entry k (per axis) holds the number of entries passing cell k - 1.
+		 */
+		std::vector<Long64_t> gridCounts(const std::vector<std::vector<double> > & values, const std::vector<gridAxis> & axes, const std::vector<std::vector<double> > & sortedSteps, int nThreads);
+		/**
+		 * @brief Cut benchmark. For a grid of cuts on up to four quantities
+		 * @details Tests every combination of the steps of all axes and returns the one with the best signal to background ratio (sigBkgRatio()), together with the ratio of every combination. The trees are read only once, see the description of this group.
+		 * 
+		 * Like in the other cut benchmarks, the thresholds are rounded to six decimals (formattedValue()).
+		 * 
+		 * @param treeSig TTree holding the quantities to benchmark for SIGNAL
+		 * @param treeBkg TTree holding the quantities to benchmark for BACKGROUND
+		 * @param scaleFactorBkg Value with which the background is scaled
+		 * @param axes The quantities, thresholds and directions of the cuts; 1 to 4 axes
+		 * @param defaultCut A pre-cut applied to all measurements of entries
+		 * @param nThreads Number of threads, 0 = all cores
+		 * @param maxCells Largest number of grid cells to allocate; the counts of both trees, the ratios and the THnD each hold one value per cell, so the default of 16M cells needs about 0.5 GB. Larger grids are refused before anything is read.
+		 * @return Best cuts and figure of merit of every cell
+		 */
+		gridResult cutBenchmarkGrid(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, std::vector<gridAxis> axes, TCut defaultCut = "", int nThreads = 0, Long64_t maxCells = 16 * 1024 * 1024);
+		/**
+		 * @}
+		 */
+	}
+
+	/**
+	 * @name Containers for data from a particle
+	 * @details The structs and methods can be used to converts ROOT's `SetBranchAddress()` stuff again into C++ objects.
+	 * 
+	 * This is really for my specific analyses.
+	 * @{
+	*/
+	/**
+	 * @brief The properties of a particle
+	 * @details Small struct with publicly accessible member variables of the most important quantities of a particle.
+	 * 
+	 */
+	struct properties {
+		Float_t pt, px, py, pz, p, E;
+		Float_t m, chg, pdg;
+	};
+	/**
+	 * @brief A container for my whole D meson decay
+	 * @details Every decay arm has four particles: The actual D meson (the mother particle, m, and three daughters, d{0..2} (kaon, pion, pion)). All have the usual particle properties, as defined by the corresponding struct
+	 * 
+	 */
+	struct DInfoContainer {
+		properties m; // actual d meson (m=mother)
+
+		properties d0, d1, d2; // three daughters
+	};
+	const int nPropertiesFields = 9; ///< Number of Float_t fields of properties
+	/**
+	 * @brief Branch name suffixes of the fields of properties, in the order of the struct
+	 */
+	extern const char * propertiesFieldNames[nPropertiesFields];
+	/**
+	 * @brief The fields of properties, in the order of the struct; so that a field can be picked by number
+	 */
+	extern Float_t properties::* propertiesFields[nPropertiesFields];
+	const int nDInfoParticles = 4; ///< Number of particles in a DInfoContainer
+	/**
+	 * @brief Branch name infixes of the particles of DInfoContainer (mother, d0, d1, d2)
+	 */
+	extern const char * DInfoParticleNames[nDInfoParticles];
+	/**
+	 * @brief The particles of DInfoContainer, in the order of DInfoParticleNames
+	 */
+	extern properties DInfoContainer::* DInfoParticles[nDInfoParticles];
+	/**
+	 * @brief Bits to select fields of properties, e.g. `kFieldM | kFieldPt`
+	 */
+	enum propertiesFieldBits {
+		kFieldPt = 1 << 0, kFieldPx = 1 << 1, kFieldPy = 1 << 2, kFieldPz = 1 << 3, kFieldP = 1 << 4, kFieldE = 1 << 5,
+		kFieldM = 1 << 6, kFieldChg = 1 << 7, kFieldPdg = 1 << 8,
+		kFieldsAll = (1 << 9) - 1
+	};
+	/**
+	 * @brief Branch name infixes for nDaughters daughters: "d0", "d1", ...
+	 */
+	std::vector<TString> daughterNames(int nDaughters);
+	/**
+	 * @brief Snapshot of the branch status (TTree::SetBranchStatus()) of a tree
+	 * @details Taken before bindBranches() prunes the branches of a tree, and given to unbindBranches() to switch exactly the branches on again which were on before. Only the names of the branches which were switched off are kept.
+	 */
+	struct branchStatus {
+		bool valid;
+		std::vector<TString> disabled;
+		branchStatus() : valid(false) {}
+		explicit branchStatus(TTree * tree);
+		void save(TTree * tree);
+		void restore(TTree * tree) const;
+	};
+	/**
+	 * @brief Binds the branches of any number of particles to properties structs
+	 * @details The generalization of setBranchAddresses(): Every particle i is bound to the branches `baseString + particleNames[i] + field` (e.g. "D" + "d1" + "pt"), but only for the fields selected in fieldMask. Branches not found in the tuple are skipped with a warning.
+	 *
+	 * With pruneOthers, all other branches of the tuple are switched off (TTree::SetBranchStatus()), so ROOT does not read and decompress them anymore, and the bound ones are put into the TTreeCache. For very wide tuples this saves most of the I/O. Keep in mind that any branch you want to read in addition must be switched on again afterwards; take a branchStatus before and give it to unbindBranches() to get the previous status back.
+	 *
+	 * Particles can be everything which gives a properties & with `particles[i]`, e.g. `properties[4]` or `std::vector<properties>`.
+	 * 
+	 * @param tuple Pointer to the TTree holding all the info
+	 * @param particles The structs to bind to, one per particle name
+	 * @param baseString The string prefixing all the branches
+	 * @param particleNames Branch name infix per particle; empty for the mother, e.g. {"", "d0", "d1"}
+	 * @param fieldMask Which fields to bind, see propertiesFieldBits
+	 * @param pruneOthers Switch off all branches which are not bound, and cache the bound ones
+	 * @param cacheSize Size of the TTreeCache in bytes if pruneOthers, 0 = keep ROOT's default
+	 * @return Names of all bound branches
+	 */
+	template <typename Particles>
+	std::vector<TString> bindBranches(TTree * tuple, Particles & particles, TString baseString, const std::vector<TString> & particleNames, UInt_t fieldMask = kFieldsAll, bool pruneOthers = false, Long64_t cacheSize = 0) {
+		std::vector<TString> bound;
+		for (size_t iParticle = 0; iParticle < particleNames.size(); iParticle++) {
+			properties & particle = particles[iParticle];
+			for (int iField = 0; iField < nPropertiesFields; iField++) {
+				if (!(fieldMask & (1 << iField))) continue;
+				TString branchName = baseString + particleNames[iParticle] + propertiesFieldNames[iField];
+				if (tuple->GetBranch(branchName) == 0) {
+					std::cerr << "andi::bindBranches: No branch " << branchName << " in tree " << tuple->GetName() << ", skipping" << std::endl;
+					continue;
+				}
+				tuple->SetBranchAddress(branchName, &(particle.*propertiesFields[iField]));
+				bound.push_back(branchName);
+			}
+		}
+		if (pruneOthers) {
+			tuple->SetBranchStatus("*", 0);
+			for (size_t i = 0; i < bound.size(); i++) tuple->SetBranchStatus(bound[i], 1);
+			if (cacheSize > 0) tuple->SetCacheSize(cacheSize);
+			for (size_t i = 0; i < bound.size(); i++) tuple->AddBranchToCache(bound[i], kTRUE);
+			tuple->StopCacheLearningPhase();
+		}
+		return bound;
+	}
+	/**
+	 * @brief Binds the branches of a DInfoContainer, see the template version
+	 * @details The particles are taken in the order of DInfoParticleNames (mother, d0, d1, d2); nParticles = 1 binds only the mother.
+	 */
+	std::vector<TString> bindBranches(TTree * tuple, andi::DInfoContainer & container, TString baseString, UInt_t fieldMask = kFieldsAll, bool pruneOthers = false, int nParticles = nDInfoParticles, Long64_t cacheSize = 0);
+	/**
+	 * @brief Unbinds branches bound with bindBranches() and switches the branches on again
+	 * @details With a valid previous status (taken before bindBranches()), the branches switched off before stay off; otherwise all branches are switched on.
+	 */
+	void unbindBranches(TTree * tuple, const std::vector<TString> & bound, const branchStatus & previous = branchStatus());
+	/**
+	 * @brief Sets my needed branch addresses when running over NTuple explicitly
+	 * @details My experiment has data files containing NTuple / TTrees with lots of branches corresponding to different properties of different particles. This function maps a info container to the corresponding branches.
+	 *
+	 * Uses bindBranches(); see there for the fieldMask and pruneOthers parameters.
+	 * 
+	 * @param tuple Pointer to the TTree holding all the info (ALL the info)
+	 * @param container Address of a info container with all the needed methods
+	 * @param baseString The string prefixing all the branches
+	 * @param alsoDaugthers Set also daughter branches
+	 * @param fieldMask Which fields to bind, see propertiesFieldBits
+	 * @param pruneOthers Switch off all other branches of the tuple
+	 */
+	void setBranchAddresses(TTree * tuple, andi::DInfoContainer & container, TString baseString, bool alsoDaugthers = true, UInt_t fieldMask = kFieldsAll, bool pruneOthers = false);
+	/**
+	 * @}
+	 */
+
+	/**
+	 * @name Columnar event store
+	 * @details The same information as in DInfoContainer, but stored as columns: One contiguous array per property per particle, for all entries of a tuple. The tuple is read once with loadColumns(); afterwards, cuts, fills and kinematics can run over the arrays as often as needed, without calling TTree::GetEntry() again and touching only the properties they actually need.
+	 *
+	 * The arrays are aligned to cache lines (64 byte), so they can directly be used with vector instructions.
+	 *
+	 * Usage:
+	 * ~~~
+	 * andi::DColumnStore store;
+	 * andi::loadColumns(tuple, store, "D");
+	 * for (Long64_t first = 0; first < store.size; first += 4096) {
+	 *     andi::DColumnBatch b = store.batch(first, 4096);
+	 *     for (Long64_t i = 0; i < b.size; i++) hMass->Fill(b.m.m[i]);
+	 * }
+	 * ~~~
+	 * @{
+	 */
+	/**
+	 * @brief Allocator for std::vector which aligns the memory to cache lines
+	 */
+	template <typename T, size_t alignment = 64>
+	struct alignedAllocator {
+		typedef T value_type;
+		template <typename U> struct rebind { typedef alignedAllocator<U, alignment> other; };
+		alignedAllocator() {}
+		template <typename U> alignedAllocator(const alignedAllocator<U, alignment> &) {}
+		T * allocate(size_t n) {
+			void * memory = 0;
+			if (posix_memalign(&memory, alignment, (n > 0) ? n * sizeof(T) : alignment) != 0) throw std::bad_alloc();
+			return static_cast<T *>(memory);
+		}
+		void deallocate(T * memory, size_t) { free(memory); }
+		template <typename U> bool operator==(const alignedAllocator<U, alignment> &) const { return true; }
+		template <typename U> bool operator!=(const alignedAllocator<U, alignment> &) const { return false; }
+	};
+	typedef std::vector<Float_t, alignedAllocator<Float_t> > alignedColumn; ///< One column of the store
+	/**
+	 * @brief The columns of one particle, pointing to the first entry of a batch
+	 * @details Pointers are NULL for properties which are not loaded.
+	 */
+	struct propertiesColumns {
+		const Float_t * pt, * px, * py, * pz, * p, * E;
+		const Float_t * m, * chg, * pdg;
+		/**
+		 * @brief Column of field number iField, in the order of propertiesFieldNames
+		 */
+		const Float_t * field(int iField) const;
+	};
+	/**
+	 * @brief A view on size consecutive entries of a DColumnStore
+	 */
+	struct DColumnBatch {
+		Long64_t first; ///< Number of the first entry of the batch in the store
+		Long64_t size; ///< Number of entries in this batch
+		propertiesColumns m; ///< Mother (the D meson)
+		propertiesColumns d0, d1, d2; ///< Daughters
+		/**
+		 * @brief Particle number iParticle, in the order of DInfoParticleNames
+		 */
+		const propertiesColumns & particle(int iParticle) const;
+	};
+	/**
+	 * @brief View on the entries [first, first + n) of columns with size entries, given by pointers to their first entry (NULL for columns not loaded). n < 0 means up to the end.
+	 */
+	DColumnBatch columnBatch(const Float_t * const starts[nDInfoParticles][nPropertiesFields], Long64_t size, Long64_t first, Long64_t n);
+	/**
+	 * @brief Columnar store of DInfoContainer data of many entries
+	 * @details Fill it with loadColumns(), use it with batch().
+	 */
+	struct DColumnStore {
+		Long64_t size; ///< Number of entries in the store
+		alignedColumn columns[nDInfoParticles][nPropertiesFields]; ///< columns[particle][field], in the order of DInfoParticleNames and propertiesFieldNames
+		DColumnStore() : size(0) {}
+		/**
+		 * @brief Clears and resizes all loaded columns (the ones in fieldMask per particle in particleMask)
+		 */
+		void resize(Long64_t newSize, UInt_t particleMask = 0xF, UInt_t fieldMask = kFieldsAll);
+		/**
+		 * @brief View on the entries [first, first + n). n < 0 means up to the end.
+		 */
+		DColumnBatch batch(Long64_t first = 0, Long64_t n = -1) const;
+	};
+	/**
+	 * @brief Reads a whole tuple into a columnar store
+	 * @details Binds a temporary DInfoContainer with bindBranches() and copies every entry into the columns. This is the only time the tuple is read; everything afterwards runs on the store. Only the branches of the loaded fields are read from the tuple (all others are switched off while loading). If the tuple has an entry list (e.g. from applyPreselection()), only its entries are loaded.
+	 * 
+	 * @param tuple Pointer to the TTree holding all the info
+	 * @param store The store to fill; old content is dropped
+	 * @param baseString The string prefixing all the branches
+	 * @param alsoDaugthers Read also daughter columns
+	 * @param fieldMask Which fields to read, see propertiesFieldBits; the other columns stay empty
+	 * @return Number of entries read
+	 */
+	Long64_t loadColumns(TTree * tuple, DColumnStore & store, TString baseString, bool alsoDaugthers = true, UInt_t fieldMask = kFieldsAll);
+	/**
+	 * @brief Calls a function for all entries of a store, batch by batch
+	 * 
+	 * @param store The columnar store
+	 * @param function Function to call per batch
+	 * @param batchSize Number of entries per batch
+	 */
+	void forEachBatch(const DColumnStore & store, const std::function<void(const DColumnBatch &)> & function, Long64_t batchSize = 4096);
+	/**
+	 * @}
+	 */
+
+	/**
+	 * @name Column cache files
+	 * @details The selected candidates of a tuple (or a whole DColumnStore) written to a flat file: a small header, then every stored column as a raw Float_t array, uncompressed and aligned to 64 byte. mappedColumnStore maps such a file into memory and uses the columns in place, without copying or decompressing anything; the operating system reads the pages when they are first touched and keeps them cached between runs. Reopening a skim of millions of candidates for re-plotting, cut scans or refits takes milliseconds.
+	 *
+	 * The files are local caches: they are written in the byte order of the machine and not meant to be shipped around.
+	 *
+	 * Usage:
+	 * ~~~
+	 * andi::exportColumns(tuple, "skim.columns", "D", "Dpt > 2");  // once
+	 * andi::mappedColumnStore store("skim.columns");  // in every later run
+	 * andi::forEachBatch(store, [&](const andi::DColumnBatch & b) { for (Long64_t i = 0; i < b.size; i++) hMass->Fill(b.m.m[i]); });
+	 * ~~~
+	 * @{
+	 */
+	/**
+	 * @brief Header at the start of a column cache file
+	 */
+	struct columnCacheHeader {
+		char magic[8]; ///< "ANDICOL" and the version of the format
+		Long64_t size; ///< Number of entries
+		UInt_t particleMask; ///< Stored particles, one bit per particle in the order of DInfoParticleNames
+		UInt_t fieldMask; ///< Stored fields, see propertiesFieldBits
+		Long64_t offsets[nDInfoParticles][nPropertiesFields]; ///< Byte offset of every column in the file, 0 if not stored
+		Long64_t length; ///< Length of the whole file
+	};
+	const char columnCacheMagic[8] = {'A', 'N', 'D', 'I', 'C', 'O', 'L', '1'};
+	/**
+	 * @brief Writes a column cache file chunk by chunk; used by exportColumns()
+	 * @details The file is written as fileName.tmp and only renamed to fileName by close(), so an interrupted export never leaves a broken cache behind.
+	 */
+	struct columnCacheWriter {
+		TString fileName; ///< Final name of the file
+		int fd; ///< File descriptor of the temporary file
+		columnCacheHeader header; ///< Layout of the file
+		bool good; ///< No error so far
+
+		columnCacheWriter(TString fileName, Long64_t size, UInt_t particleMask, UInt_t fieldMask);
+		~columnCacheWriter();
+		/**
+		 * @brief Writes bytes bytes at a byte offset in the file
+		 */
+		bool write(const void * data, Long64_t bytes, Long64_t offset);
+		/**
+		 * @brief Writes a piece of n values of one column, starting at entry first
+		 */
+		bool write(int iParticle, int iField, Long64_t first, const Float_t * values, Long64_t n);
+		/**
+		 * @brief Writes the header and moves the file to its final name
+		 * @return If the whole file was written
+		 */
+		bool close();
+	private:
+		columnCacheWriter(const columnCacheWriter &);
+		columnCacheWriter & operator=(const columnCacheWriter &);
+	};
+	/**
+	 * @brief Writes the selected candidates of a tuple into a column cache file
+	 * @details The selection is evaluated once into a TEntryList (cached, see preselectionList()); then only the selected entries are read, with only the branches of the stored fields switched on, and written column by column in chunks. Memory use does not depend on the size of the tuple. If the tuple has an entry list, only its entries are considered.
+	 * 
+	 * @param tuple Pointer to the TTree (or TChain) holding all the info
+	 * @param fileName Column cache file to write
+	 * @param baseString The string prefixing all the branches
+	 * @param selection Preselection of the candidates; all entries if empty
+	 * @param alsoDaugthers Store also daughter columns
+	 * @param fieldMask Which fields to store, see propertiesFieldBits
+	 * @return Number of stored candidates, -1 on errors
+	 */
+	Long64_t exportColumns(TTree * tuple, TString fileName, TString baseString, TCut selection = "", bool alsoDaugthers = true, UInt_t fieldMask = kFieldsAll);
+	/**
+	 * @brief Writes all entries of a columnar store into a column cache file
+	 * @details Stores the columns which are loaded; particles and fields without any loaded column are left out.
+	 *
+	 * @return Number of stored entries, -1 on errors
+	 */
+	Long64_t exportColumns(const DColumnStore & store, TString fileName);
+	/**
+	 * @brief Read-only columnar store on a memory mapped column cache file
+	 * @details Offers the same views as DColumnStore (batch(), forEachBatch()), which point directly into the mapped file. The mapping is released when the store is closed or destroyed; views must not be used afterwards.
+	 */
+	struct mappedColumnStore {
+		Long64_t size; ///< Number of entries in the store
+		const Float_t * columns[nDInfoParticles][nPropertiesFields]; ///< First entry of every column, NULL if not stored
+		void * data; ///< Start of the mapping
+		size_t length; ///< Length of the mapping
+
+		mappedColumnStore();
+		mappedColumnStore(TString fileName);
+		~mappedColumnStore();
+		/**
+		 * @brief Maps a column cache file written by exportColumns()
+		 * @return If the file could be opened and is a valid column cache
+		 */
+		bool open(TString fileName);
+		/**
+		 * @brief Releases the mapping
+		 */
+		void close();
+		bool isOpen() const { return data != 0; } ///< If a file is mapped
+		/**
+		 * @brief View on the entries [first, first + n). n < 0 means up to the end.
+		 */
+		DColumnBatch batch(Long64_t first = 0, Long64_t n = -1) const;
+	private:
+		mappedColumnStore(const mappedColumnStore &);
+		mappedColumnStore & operator=(const mappedColumnStore &);
+	};
+	/**
+	 * @brief Calls a function for all entries of a mapped store, batch by batch
+	 * 
+	 * @param store The mapped columnar store
+	 * @param function Function to call per batch
+	 * @param batchSize Number of entries per batch
+	 */
+	void forEachBatch(const mappedColumnStore & store, const std::function<void(const DColumnBatch &)> & function, Long64_t batchSize = 4096);
+	/**
+	 * @brief If T is a columnar store (DColumnStore, mappedColumnStore)
+	 * @details Restricts the templates taking a store, so that e.g. a TChain * does not match them instead of the TTree * overloads.
+	 */
+	template <typename T> struct isColumnStore : std::false_type {};
+	template <> struct isColumnStore<DColumnStore> : std::true_type {};
+	template <> struct isColumnStore<mappedColumnStore> : std::true_type {};
+	/**
+	 * @}
+	 */
+
+	namespace cuts {
+		/**
+		 * @name Compiled cuts
+		 * @details Cuts parsed once into a small program and evaluated on whole batches of a columnar store (DColumnStore, mappedColumnStore) or of a tree, instead of formatting a new cut string for every step and letting TTree::GetEntries() compile it into a TTreeFormula again. Thresholds are parameters (`[0]`, `[1]`, …, as in TF1), whose values are only given at evaluation time; one compiled cut serves all steps of a scan.
+		 *
+		 * Every instruction of the program runs over a whole batch of entries before the next one, so the interpretation costs once per batch, and the loops over the entries are plain arithmetic the compiler can vectorise.
+		 *
+		 * Columns are named like the branches, `baseString + particle + field`, e.g. `Dpt` or `Dd0m` with baseString `D`. Supported are numbers, parameters, `+ - * /`, comparisons `< <= > >= == !=`, `&& || !`, parentheses and `abs()`, `sqrt()`. Everything is computed in double precision, as in TTreeFormula.
+		 *
+		 * ~~~
+		 * andi::cuts::compiledCut cut("Dpt > [0] && Dm > 1.8 && Dm < 1.94", "D");
+		 * double bestRatio;
+		 * TGraph * g = andi::cuts::cutBenchmark(storeSig, storeBkg, 1., cut, steps, bestRatio);
+		 * ~~~
+		 * @{
+		 */
+		/**
+		 * @brief Instructions of a compiled cut
+		 */
+		enum compiledCutOps {
+			kOpColumn, kOpConstant, kOpParameter,  // push
+			kOpAdd, kOpSubtract, kOpMultiply, kOpDivide,  // binary
+			kOpLess, kOpLessEqual, kOpGreater, kOpGreaterEqual, kOpEqual, kOpNotEqual,
+			kOpAnd, kOpOr,
+			kOpNegate, kOpNot, kOpAbs, kOpSqrt  // unary
+		};
+		/**
+		 * @brief Where a binary instruction takes its right operand from
+		 */
+		enum compiledCutOperands {
+			kOperandStack, ///< The top of the stack
+			kOperandConstant, ///< value of the instruction
+			kOperandParameter ///< Parameter number index
+		};
+		/**
+		 * @brief One instruction of a compiled cut
+		 */
+		struct compiledCutOp {
+			int op; ///< See compiledCutOps
+			int operand; ///< Right operand of binary instructions, see compiledCutOperands
+			int index; ///< Column (iParticle * nPropertiesFields + iField) or parameter number
+			double value; ///< Constant
+		};
+		/**
+		 * @brief A cut expression on the columns of DInfoContainer, compiled into a program for batch evaluation
+		 */
+		struct compiledCut {
+			TString expression; ///< The cut as given
+			TString baseString; ///< Prefix of all column names
+			std::vector<compiledCutOp> program; ///< Instructions, in reverse Polish notation
+			int nParameters; ///< Number of parameters used (highest number + 1)
+			UInt_t particleMask; ///< Particles whose columns are used, one bit per particle in the order of DInfoParticleNames
+			UInt_t fieldMask; ///< Fields whose columns are used, see propertiesFieldBits
+			int maxDepth; ///< Maximum depth of the stack, in batches
+			bool valid; ///< The expression could be compiled
+
+			/**
+			 * @brief Compiles an expression; on errors, the reason is printed and valid is false
+			 */
+			explicit compiledCut(TString expression = "1", TString baseString = "D");
+			/**
+			 * @brief Computes the value of the expression for all entries of a (non-empty) batch
+			 * @details The expression does not need to be a cut, e.g. `Dd0pt + Dd1pt` gives the sum for every entry.
+			 * 
+			 * @param b The batch; all used columns must be loaded
+			 * @param parameters Values of the parameters, at least nParameters
+			 * @param workspace Memory for the stack, resized as needed; reuse it for the next batches
+			 * @return The b.size values, inside of workspace; 0 on errors
+			 */
+			const double * values(const DColumnBatch & b, const double * parameters, std::vector<double> & workspace) const;
+			/**
+			 * @brief Evaluates the cut on all entries of a batch
+			 * 
+			 * @param b The batch; all used columns must be loaded
+			 * @param parameters Values of the parameters, at least nParameters
+			 * @param workspace Memory for the stack, resized as needed; reuse it for the next batches
+			 * @param passed If given, set to 1 or 0 for every entry of the batch
+			 * @return Number of entries passing the cut, -1 on errors
+			 */
+			Long64_t evaluate(const DColumnBatch & b, const double * parameters, std::vector<double> & workspace, char * passed = 0) const;
+			/**
+			 * @brief Number of the last particle used, + 1
+			 */
+			int nParticles() const;
+		private:
+			Ssiz_t position; ///< Position of the parser in expression
+
+			void fail(TString message);
+			void skipSpaces();
+			bool accept(const char * token);
+			void emit(int op, int index = 0, double value = 0);
+			/**
+			 * @brief Emits a binary instruction; a constant or parameter as right operand is folded into it
+			 */
+			void emitBinary(int op);
+			void parseOr();
+			void parseAnd();
+			void parseComparison();
+			void parseSum();
+			void parseProduct();
+			void parseUnary();
+			void parsePrimary();
+		};
+		/**
+		 * @brief Number of entries of a columnar store (DColumnStore or mappedColumnStore) passing a compiled cut
+		 * @details The store is split into one range per thread, every thread evaluates its range batch by batch.
+		 * 
+		 * @param store The store, with all columns used by cut loaded
+		 * @param cut The compiled cut
+		 * @param parameters Values of the parameters of cut
+		 * @param nThreads Number of threads, 0 = all cores
+		 * @param passed If given, resized to the size of the store and set to 1 or 0 for every entry
+		 * @return Number of entries passing, -1 on errors
+		 */
+		template <typename Store>
+		typename std::enable_if<isColumnStore<Store>::value, Long64_t>::type countPassing(const Store & store, const compiledCut & cut, const std::vector<double> & parameters = std::vector<double>(), int nThreads = 0, std::vector<char> * passed = 0) {
+			if (!cut.valid) return -1;
+			if ((int) parameters.size() < cut.nParameters) {
+				std::cerr << "andi::cuts::countPassing: " << cut.expression << " needs " << cut.nParameters << " parameters, got " << parameters.size() << std::endl;
+				return -1;
+			}
+			const Long64_t batchSize = 1024;
+			if (passed) passed->resize(store.size);
+			nThreads = std::max<int>(1, std::min<Long64_t>(numberOfThreads(nThreads), store.size / (16 * batchSize)));
+			std::vector<Long64_t> counts(nThreads, 0);
+			runInThreads(nThreads, [&](int iThread) {
+				std::vector<double> workspace;
+				std::pair<Long64_t, Long64_t> range = threadRange(store.size, iThread, nThreads);
+				for (Long64_t first = range.first; first < range.second && counts[iThread] >= 0; first += batchSize) {
+					Long64_t n = cut.evaluate(store.batch(first, std::min(batchSize, range.second - first)), parameters.empty() ? 0 : &parameters[0], workspace, passed ? &(*passed)[first] : 0);
+					counts[iThread] = (n < 0) ? -1 : counts[iThread] + n;
+				}
+			});
+			Long64_t nPassed = 0;
+			for (int i = 0; i < nThreads; i++) {
+				if (counts[i] < 0) return -1;
+				nPassed += counts[i];
+			}
+			return nPassed;
+		}
+		/**
+		 * @brief Number of entries of a tree passing a compiled cut
+		 * @details The used columns are read in batches into a small DColumnStore (only their branches switched on), the cut is evaluated per batch. If the tree has an entry list (see applyPreselection()), only its entries are read.
+		 * @return Number of entries passing, -1 on errors
+		 */
+		Long64_t countPassing(TTree * tree, const compiledCut & cut, const std::vector<double> & parameters = std::vector<double>(), Long64_t batchSize = 4096);
+		/**
+		 * @brief Cut benchmark with a compiled cut on columnar stores. For list of limits
+		 * @details Parameter [0] of cut is set to every step (rounded as in the other cut benchmarks, see formattedValue()), e.g. `Dpt > [0]` gives the same graph as the TTree version of cutBenchmark() with testCut `Dpt`. Any other condition (the defaultCut) can be part of cut, e.g. `Dpt > [0] && Dm > 1.8`.
+		 * 
+		 * @param storeSig Columns of SIGNAL
+		 * @param storeBkg Columns of BACKGROUND
+		 * @param scaleFactorBkg Value with which the background is scaled
+		 * @param cut Compiled cut with parameter [0] as threshold
+		 * @param steps Vector of thresholds, e.g. {1, 2, 3}
+		 * @param bestRatio The best threshold will be filled into this variable
+		 * @param nThreads Number of threads, 0 = all cores
+		 * @return Graph with the S/B ratio for every evaluated point
+		 */
+		template <typename Store>
+		typename std::enable_if<isColumnStore<Store>::value, TGraph *>::type cutBenchmark(const Store & storeSig, const Store & storeBkg, double scaleFactorBkg, const compiledCut & cut, std::vector<double> steps, double & bestRatio, int nThreads = 0) {
+			scopedTimer timer("cuts::cutBenchmark");
+			TGraph * tempGraph = new TGraph();
+			if (!cut.valid) return tempGraph;
+			std::vector<double> parameters(std::max(cut.nParameters, 1), 0.);
+			double lastRatio = -1.;
+			for (size_t iPoint = 0; iPoint < steps.size(); iPoint++) {
+				parameters[0] = formattedValue(steps[iPoint]);
+				double entriesSig = countPassing(storeSig, cut, parameters, nThreads);
+				double entriesBkg = scaleFactorBkg * countPassing(storeBkg, cut, parameters, nThreads);
+				double ratio = sigBkgRatio(entriesSig, entriesBkg);
+				traceStep(TString::Format("%s, [0] = %f", cut.expression.Data(), steps[iPoint]).Data(), entriesSig, entriesBkg, ratio);
+				if (ratio > lastRatio) {
+					bestRatio = steps[iPoint];
+					lastRatio = ratio;
+				}
+				tempGraph->SetPoint(iPoint, steps[iPoint], ratio);
+			}
+			return tempGraph;
+		}
+		/**
+		 * @brief Loads the columns needed by a compiled cut (or tree ensemble) of the entries passing defaultCut, with a cached entry list (see preselectionList())
+		 */
+		Long64_t loadSelectedColumns(TTree * tree, DColumnStore & store, TString baseString, TCut defaultCut, UInt_t particleMask, UInt_t fieldMask);
+		/**
+		 * @brief Cut benchmark with a compiled cut on trees. For list of limits
+		 * @details Reads the columns used by cut once per tree (only the entries passing defaultCut, with a cached entry list, see preselectionList()) and runs the columnar version on them.
+		 */
+		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, const compiledCut & cut, std::vector<double> steps, double & bestRatio, TCut defaultCut = "", int nThreads = 0);
+		/**
+		 * @brief Cut benchmark with a compiled cut on columnar stores, with adaptive search. For a threshold in a range
+		 * @details Parameter [0] of cut is the threshold, found with adaptiveSearch(). As every evaluation is a full pass over the stores, this is the method of choice for cuts on derived or several quantities, e.g. `Dd0pt + Dd1pt > [0] && Dm > 1.8`.
+		 *
+		 * @return Graph with the S/B ratio for every evaluated point
+		 */
+		template <typename Store>
+		typename std::enable_if<isColumnStore<Store>::value, TGraph *>::type cutBenchmarkAdaptive(const Store & storeSig, const Store & storeBkg, double scaleFactorBkg, const compiledCut & cut, std::pair<double, double> rangeLimits, double resolution, double & bestCut, int maxEvaluations = 40, int nThreads = 0) {
+			scopedTimer timer("cuts::cutBenchmarkAdaptive");
+			std::vector<double> parameters(std::max(cut.nParameters, 1), 0.);
+			return adaptiveSearch([&](double value, double & error) {
+				parameters[0] = formattedValue(value);
+				double entriesSig = countPassing(storeSig, cut, parameters, nThreads);
+				double entriesBkg = scaleFactorBkg * countPassing(storeBkg, cut, parameters, nThreads);
+				double ratio = sigBkgRatio(entriesSig, entriesBkg);
+				traceStep(TString::Format("%s, [0] = %f", cut.expression.Data(), value).Data(), entriesSig, entriesBkg, ratio);
+				error = sigBkgRatioError(entriesSig, entriesBkg, scaleFactorBkg);
+				return ratio;
+			}, rangeLimits.first, rangeLimits.second, resolution, bestCut, 10, maxEvaluations);
+		}
+		/**
+		 * @brief Cut benchmark with a compiled cut on columnar stores. For equidistant limits in a range
+		 * @details Parameter [0] of cut is set to numberOfSteps equidistant thresholds starting at rangeLimits.first, as in the TTree version of this function, see the list version for the rest.
+		 *
+		 * @return Graph with the S/B ratio for every evaluated point
+		 */
+		template <typename Store>
+		typename std::enable_if<isColumnStore<Store>::value, TGraph *>::type cutBenchmark(const Store & storeSig, const Store & storeBkg, double scaleFactorBkg, const compiledCut & cut, std::pair<double, double> rangeLimits, Int_t numberOfSteps, int nThreads = 0) {
+			double stepWidth = (rangeLimits.second - rangeLimits.first) / (double)numberOfSteps;
+			std::vector<double> steps;
+			for (int iStep = 0; iStep < numberOfSteps; iStep++) steps.push_back(rangeLimits.first + iStep * stepWidth);  // not summed up, so the steps do not drift
+			double bestRatio = 0;
+			return cutBenchmark(storeSig, storeBkg, scaleFactorBkg, cut, steps, bestRatio, nThreads);
+		}
+		/**
+		 * @brief Cut benchmark with a compiled cut on trees. For equidistant limits in a range
+		 * @details Reads the columns used by cut once per tree, as the list version.
+		 */
+		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, const compiledCut & cut, std::pair<double, double> rangeLimits, Int_t numberOfSteps, TCut defaultCut = "", int nThreads = 0);
+		/**
+		 * @brief Cut benchmark with a compiled cut on columnar stores. For a symmetrical range around a central value.
+		 * @details Parameters [0] and [1] of cut are the lower and upper limit of the window, e.g. `Dm > [0] && Dm < [1]`. As in the TTree version of cutBenchmarkSymmetric(), windows without signal or without background get a ratio of 0, and the graph shows the ratio against the full width of the window.
+		 *
+		 * @param cut Compiled cut with parameters [0] (lower limit) and [1] (upper limit)
+		 * @param _lowerLimit The lower limit of the best window will be filled into this variable
+		 * @param _upperLimit The upper limit of the best window will be filled into this variable
+		 * @return Graph with the S/B ratio for every evaluated window
+		 */
+		template <typename Store>
+		typename std::enable_if<isColumnStore<Store>::value, TGraph *>::type cutBenchmarkSymmetric(const Store & storeSig, const Store & storeBkg, double scaleFactorBkg, const compiledCut & cut, double centralValue, double rangeLimit, Int_t numberOfSteps, double & _lowerLimit, double & _upperLimit, int nThreads = 0) {
+			scopedTimer timer("cuts::cutBenchmarkSymmetric");
+			TGraph * tempGraph = new TGraph();
+			if (!cut.valid) return tempGraph;
+			if (cut.nParameters < 2) {
+				std::cerr << "andi::cuts::cutBenchmarkSymmetric: " << cut.expression << " needs parameters [0] (lower limit) and [1] (upper limit)" << std::endl;
+				return tempGraph;
+			}
+			std::vector<double> parameters(cut.nParameters, 0.);
+			double stepWidth = rangeLimit / (double)numberOfSteps;
+			double lastRatio = -1.;
+			for (int i = 1; i <= numberOfSteps; i++)	{
+				double upperLimit = centralValue + i * stepWidth;
+				double lowerLimit = centralValue - i * stepWidth;
+				parameters[0] = formattedValue(lowerLimit);
+				parameters[1] = formattedValue(upperLimit);
+				double entriesSig = countPassing(storeSig, cut, parameters, nThreads);
+				double entriesBkg = scaleFactorBkg * countPassing(storeBkg, cut, parameters, nThreads);
+				double ratio = sigBkgRatio(entriesSig, entriesBkg);
+				traceStep(TString::Format("%s, [0] = %f, [1] = %f", cut.expression.Data(), lowerLimit, upperLimit).Data(), entriesSig, entriesBkg, ratio);
+				if (entriesSig == 0) ratio = 0;
+				if (entriesBkg == 0) ratio = 0;
+				if (ratio > lastRatio) {
+					_lowerLimit = lowerLimit, _upperLimit = upperLimit;
+					lastRatio = ratio;
+				}
+				tempGraph->SetPoint(i - 1, upperLimit - lowerLimit, ratio);
+			}
+			return tempGraph;
+		}
+		/**
+		 * @brief Cut benchmark with a compiled cut on trees. For a symmetrical range around a central value.
+		 * @details Reads the columns used by cut once per tree, as the list version of cutBenchmark().
+		 */
+		TGraph * cutBenchmarkSymmetric(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, const compiledCut & cut, double centralValue, double rangeLimit, Int_t numberOfSteps, double & _lowerLimit, double & _upperLimit, TCut defaultCut = "", int nThreads = 0);
+		/**
+		 * @brief Cut benchmark with a compiled cut on columnar stores. For a grid of parameter values
+		 * @details Tests every combination of the steps of all parameters, parameter [j] taking the steps of steps[j], e.g. `Dpt > [0] && Dd0pt > [1]`. Unlike the TTree version of cutBenchmarkGrid(), every cell is a full pass over both stores, so the cut can combine the quantities freely, but large grids get slow; maxCells is set accordingly.
+		 *
+		 * The thresholds are rounded as in the other cut benchmarks (formattedValue()). The best cell is also returned as a cut string, with the parameters replaced by their values.
+		 *
+		 * @param cut Compiled cut with one parameter per axis
+		 * @param steps The values to test per parameter, any order; 1 to 4 parameters
+		 * @param nThreads Number of threads, 0 = all cores
+		 * @param maxCells Largest number of cells to evaluate; larger grids are refused
+		 * @return Best values of the parameters and figure of merit of every cell
+		 */
+		template <typename Store>
+		typename std::enable_if<isColumnStore<Store>::value, gridResult>::type cutBenchmarkGrid(const Store & storeSig, const Store & storeBkg, double scaleFactorBkg, const compiledCut & cut, const std::vector<std::vector<double> > & steps, int nThreads = 0, Long64_t maxCells = 65536) {
+			scopedTimer timer("cuts::cutBenchmarkGrid");
+			gridResult result;
+			result.bestRatio = -1.;
+			result.ratios = 0;
+			size_t nDim = steps.size();
+			if (!cut.valid) return result;
+			if (nDim == 0 || nDim > 4 || (int) nDim < cut.nParameters) {
+				std::cerr << "andi::cuts::cutBenchmarkGrid: Need 1 to 4 axes and one per parameter of " << cut.expression << ", got " << nDim << std::endl;
+				return result;
+			}
+			std::vector<std::vector<double> > sortedSteps(nDim);
+			std::vector<Int_t> nBins(nDim);
+			std::vector<double> xMin(nDim, 0.), xMax(nDim, 1.);
+			Long64_t nCells = 1;
+			for (size_t j = 0; j < nDim; j++) {
+				for (size_t k = 0; k < steps[j].size(); k++) sortedSteps[j].push_back(formattedValue(steps[j][k]));
+				std::sort(sortedSteps[j].begin(), sortedSteps[j].end());
+				sortedSteps[j].erase(std::unique(sortedSteps[j].begin(), sortedSteps[j].end()), sortedSteps[j].end());
+				if (sortedSteps[j].empty()) {
+					std::cerr << "andi::cuts::cutBenchmarkGrid: No steps for parameter [" << j << "]" << std::endl;
+					return result;
+				}
+				nBins[j] = sortedSteps[j].size();
+				nCells *= nBins[j];
+			}
+			if (nCells > maxCells) {
+				std::cerr << "andi::cuts::cutBenchmarkGrid: Grid of " << nCells << " cells exceeds the limit of " << maxCells << " cells, every cell is one pass over the stores; use fewer steps or raise maxCells" << std::endl;
+				return result;
+			}
+
+			result.ratios = new THnD("hnRatios", "S^{2}/(S+B) of cut grid", nDim, &nBins[0], &xMin[0], &xMax[0]);
+			for (size_t j = 0; j < nDim; j++) {
+				std::vector<double> edges = stepBinEdges(sortedSteps[j]);
+				result.ratios->GetAxis(j)->Set(nBins[j], &edges[0]);
+				result.ratios->GetAxis(j)->SetTitle(TString::Format("[%d]", (int) j));
+			}
+			std::vector<double> parameters(nDim, 0.);
+			std::vector<Int_t> bin(nDim);
+			Long64_t bestCell = -1;
+			for (Long64_t cell = 0; cell < nCells; cell++) {
+				Long64_t rest = cell;
+				for (size_t j = 0; j < nDim; j++) {
+					Long64_t k = rest % nBins[j];
+					rest /= nBins[j];
+					parameters[j] = sortedSteps[j][k];
+					bin[j] = k + 1;
+				}
+				double entriesSig = countPassing(storeSig, cut, parameters, nThreads);
+				double entriesBkg = scaleFactorBkg * countPassing(storeBkg, cut, parameters, nThreads);
+				double ratio = sigBkgRatio(entriesSig, entriesBkg);
+				if (entriesSig + entriesBkg == 0) ratio = 0;
+				result.ratios->SetBinContent(&bin[0], ratio);
+				if (ratio > result.bestRatio) {
+					result.bestRatio = ratio;
+					bestCell = cell;
+				}
+			}
+			if (bestCell < 0) return result;
+
+			TString bestCutString = cut.expression;
+			for (size_t j = 0; j < nDim; j++) {
+				result.bestCuts.push_back(sortedSteps[j][bestCell % nBins[j]]);
+				bestCell /= nBins[j];
+				bestCutString.ReplaceAll(TString::Format("[%d]", (int) j), TString::Format("%f", result.bestCuts[j]));
+			}
+			result.bestCut = bestCutString;
+			return result;
+		}
+		/**
+		 * @brief Cut benchmark with a compiled cut on trees. For a grid of parameter values
+		 * @details Reads the columns used by cut once per tree, as the list version of cutBenchmark().
+		 */
+		gridResult cutBenchmarkGrid(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, const compiledCut & cut, const std::vector<std::vector<double> > & steps, TCut defaultCut = "", int nThreads = 0, Long64_t maxCells = 65536);
+		/**
+		 * @}
+		 */
+		/**
+		 * @name Tree ensembles
+		 * @details Fast evaluation of boosted decision trees trained elsewhere (e.g. with XGBoost), as classifier for D candidates beyond rectangular cuts. The score is just another quantity for the cut benchmarks: cutBenchmark() with a treeEnsemble scans thresholds on it like on any column.
+		 *
+		 * The model is a text file: a header with the input variables, then the trees in the text dump format of XGBoost (`Booster.dump_model()`):
+		 * ~~~
+		 * # comments start with #
+		 * baseString D
+		 * variable Dpt
+		 * variable Dd0pt + Dd1pt + Dd2pt
+		 * base_score 0.5
+		 * objective logistic
+		 * booster[0]:
+		 * 0:[f0<2.5] yes=1,no=2,missing=1
+		 * 	1:leaf=-0.2
+		 * 	2:leaf=0.3
+		 * ~~~
+		 * Variables are expressions on the columns as in compiledCut, numbered in order (f0, f1, …); the trees may also name them directly, as in `[Dpt<2.5]`, undeclared names are added as variables. A node sends an entry to yes if the variable is smaller than the threshold, to missing if it is NaN. The score is the sum of the leaves plus the base score; with `objective logistic` (e.g. XGBoost's `binary:logistic`), it is transformed by 1 / (1 + exp(-score)). As in XGBoost, base_score is given as the score itself, so for logistic objectives it is a probability (default 0.5), which is converted with log(p / (1 - p)) before it is added to the leaves; otherwise it is added as it is (default 0).
+		 *
+		 * All trees are flattened into one contiguous array of nodes. Entries are scored in batches: the variables of a batch are computed column by column, then one tree after another walks over all entries of the batch, so the nodes of the tree stay in the cache. The batches are distributed over several threads; nothing is allocated per entry and there are no virtual calls.
+		 * @{
+		 */
+		/**
+		 * @brief One node of a flattened tree ensemble; a leaf has feature -1 and its value in threshold
+		 */
+		struct ensembleNode {
+			Float_t threshold; ///< Cut value, or leaf value
+			Int_t feature; ///< Number of the variable, -1 for leaves
+			Int_t yes; ///< Next node if variable < threshold
+			Int_t no; ///< Next node if variable >= threshold
+			Int_t missing; ///< Next node if variable is NaN
+		};
+		/**
+		 * @brief Per-thread memory of treeEnsemble::score()
+		 */
+		struct ensembleWorkspace {
+			std::vector<double> stack; ///< For the compiled variables
+			std::vector<Float_t> features; ///< features[iFeature * batch size + i]
+			std::vector<double> sums; ///< Score per entry of the batch
+		};
+		/**
+		 * @brief A boosted decision tree ensemble, flattened for batch evaluation
+		 */
+		struct treeEnsemble {
+			TString baseString; ///< Prefix of the column names
+			std::vector<compiledCut> variables; ///< Input variables
+			std::vector<ensembleNode> nodes; ///< Nodes of all trees
+			std::vector<Int_t> roots; ///< First node of every tree
+			double baseScore; ///< Added to the sum of the leaves, before the logistic function (base_score of the file converted to a margin)
+			bool logistic; ///< Transform the score with the logistic function
+			UInt_t particleMask; ///< Particles whose columns are used by the variables
+			UInt_t fieldMask; ///< Fields whose columns are used by the variables
+			bool valid; ///< The model could be read
+
+			treeEnsemble() : baseString("D"), baseScore(0), logistic(false), particleMask(0), fieldMask(0), valid(false) {}
+			/**
+			 * @brief Reads a model file, see the description of this group; on errors, the reason is printed and valid is false
+			 */
+			explicit treeEnsemble(TString fileName);
+			/**
+			 * @brief Reads a model from a stream
+			 * @return valid
+			 */
+			bool read(std::istream & input);
+			int nTrees() const { return roots.size(); } ///< Number of trees
+			/**
+			 * @brief Scores all entries of a (non-empty) batch
+			 * 
+			 * @param b The batch; all columns used by the variables must be loaded
+			 * @param scores Filled with b.size scores
+			 * @param workspace Memory of the calling thread, reuse it for the next batches
+			 * @return If the batch could be scored
+			 */
+			bool score(const DColumnBatch & b, Float_t * scores, ensembleWorkspace & workspace) const;
+		private:
+			bool fail(std::string message, int lineNumber);
+			/**
+			 * @brief Compiles a variable and adds it
+			 * @return Number of the variable, -1 on errors
+			 */
+			int addVariable(TString expression);
+			/**
+			 * @brief Parses a line like `2:[f3<1.75] yes=3,no=4,missing=3` or `3:leaf=0.25`
+			 */
+			bool parseNode(const std::string & line, std::pair<int, ensembleNode> & node, int lineNumber);
+			/**
+			 * @brief Appends the nodes of one tree, with the node ids turned into positions in nodes
+			 */
+			bool addTree(const std::vector<std::pair<int, ensembleNode> > & treeNodes, int lineNumber);
+		};
+		/**
+		 * @brief Scores of all entries of a columnar store (DColumnStore or mappedColumnStore)
+		 * 
+		 * @param store The store, with all columns used by the variables of the ensemble loaded
+		 * @param ensemble The tree ensemble
+		 * @param nThreads Number of threads, 0 = all cores
+		 * @return One score per entry; empty on errors
+		 */
+		template <typename Store>
+		typename std::enable_if<isColumnStore<Store>::value, std::vector<Float_t> >::type ensembleScores(const Store & store, const treeEnsemble & ensemble, int nThreads = 0) {
+			scopedTimer timer("cuts::ensembleScores");
+			std::vector<Float_t> scores(store.size);
+			if (!ensemble.valid) return std::vector<Float_t>();
+			const Long64_t batchSize = 1024;
+			nThreads = std::max<int>(1, std::min<Long64_t>(numberOfThreads(nThreads), store.size / (4 * batchSize)));
+			std::atomic<bool> good(true);
+			runInThreads(nThreads, [&](int iThread) {
+				ensembleWorkspace workspace;
+				std::pair<Long64_t, Long64_t> range = threadRange(store.size, iThread, nThreads);
+				for (Long64_t first = range.first; first < range.second && good; first += batchSize) {
+					if (!ensemble.score(store.batch(first, std::min(batchSize, range.second - first)), &scores[first], workspace)) good = false;
+				}
+			});
+			if (!good) return std::vector<Float_t>();
+			instruments().count("entries scored", store.size);
+			return scores;
+		}
+		/**
+		 * @brief Scores of all entries of a columnar store, sorted, ready for the sorted column version of cutBenchmark()
+		 */
+		template <typename Store>
+		typename std::enable_if<isColumnStore<Store>::value, std::vector<double> >::type sortedScores(const Store & store, const treeEnsemble & ensemble, int nThreads = 0) {
+			std::vector<Float_t> scores = ensembleScores(store, ensemble, nThreads);
+			std::vector<double> column;
+			column.reserve(scores.size());
+			for (size_t i = 0; i < scores.size(); i++) {
+				if (!std::isnan(scores[i])) column.push_back(scores[i]);
+			}
+			std::sort(column.begin(), column.end());
+			return column;
+		}
+		/**
+		 * @brief Cut benchmark on the score of a tree ensemble. For list of limits
+		 * @details Reads the columns used by the ensemble once per tree (only the entries passing defaultCut, see loadSelectedColumns()), scores them on several threads and scans the steps as lower limits on the score, see the sorted column version of cutBenchmark().
+		 *
+		 * @return Graph with the S/B ratio for every evaluated point
+		 */
+		TGraph * cutBenchmark(TTree * treeSig, TTree * treeBkg, double scaleFactorBkg, const treeEnsemble & ensemble, std::vector<double> steps, double & bestRatio, TCut defaultCut = "", int nThreads = 0);
+		/**
+		 * @}
+		 */
+	}
+
+	/**
+	 * @name Batch kinematics
+	 * @details Kinematic quantities for whole batches of a DColumnStore at once: invariant masses of two or more particles (e.g. daughter pairs or all three daughters), transverse and total momentum. The loops run with AVX-512 or AVX2 vector instructions if the CPU has them (checked at run time), otherwise with plain scalar code.
+	 *
+	 * Everything is computed in single precision, as the columns are. Masses follow the convention of TLorentzVector::M(): negative for space-like four-vectors.
+	 *
+	 * When the file is interpreted by ROOT (not compiled), only the scalar code is used; compile it (see the Makefile) to get the vector versions.
+	 * @{
+	 */
+	/**
+	 * @brief Vector instructions used by the batch kinematics and the unbinned fits: 0 = scalar, 1 = AVX2, 2 = AVX-512
+	 */
+	int simdLevel();
+	/**
+	 * @brief Invariant mass of the sum of nParticles four-vectors, scalar version; see massOfSum()
+	 */
+	void massOfSumScalar(Long64_t n, int nParticles, const Float_t * const * px, const Float_t * const * py, const Float_t * const * pz, const Float_t * const * E, Float_t * out, Long64_t first = 0);
+	/**
+	 * @brief Invariant mass of the sum of nParticles four-vectors, for n entries
+	 * @details The four-vector components are given as arrays of columns, e.g. `px[j][i]` is px of particle j in entry i. Picks the fastest available version, see simdLevel().
+	 */
+	void massOfSum(Long64_t n, int nParticles, const Float_t * const * px, const Float_t * const * py, const Float_t * const * pz, const Float_t * const * E, Float_t * out);
+	/**
+	 * @brief Total momentum of n entries; transverse momentum if pz is NULL
+	 */
+	void momentum(Long64_t n, const Float_t * px, const Float_t * py, const Float_t * pz, Float_t * out);
+	/**
+	 * @brief Invariant mass of the sum of some particles of a batch
+	 * @details E.g. `batchMass(b, {1, 2}, out)` for the mass of the d0 d1 pair, `batchMass(b, {1, 2, 3}, out)` for the mass of all three daughters. Particles are numbered as in DInfoParticleNames. px, py, pz and E of the particles need to be loaded.
+	 * 
+	 * @param b The batch
+	 * @param particles Numbers of the particles to add up
+	 * @param out Array with at least b.size entries for the result
+	 * @return false if a needed column is not loaded
+	 */
+	bool batchMass(const DColumnBatch & b, std::vector<int> particles, Float_t * out);
+	/**
+	 * @brief Mass of two particles of a batch, e.g. batchPairMass(b, 1, 2, out) for the d0 d1 pair
+	 */
+	bool batchPairMass(const DColumnBatch & b, int iParticleA, int iParticleB, Float_t * out);
+	/**
+	 * @brief Mass of all three daughters of a batch (the reconstructed D mass)
+	 */
+	bool batchThreeBodyMass(const DColumnBatch & b, Float_t * out);
+	/**
+	 * @brief Transverse momentum of a particle of a batch
+	 */
+	bool batchPt(const DColumnBatch & b, int iParticle, Float_t * out);
+	/**
+	 * @brief Total momentum of a particle of a batch
+	 */
+	bool batchP(const DColumnBatch & b, int iParticle, Float_t * out);
+	/**
+	 * @}
+	 */
+
+	/**
+	 * @name Unbinned Gauss Fits
+	 * @details Maximum likelihood fits of a single or double Gaussian directly to a column of values (e.g. a mass column of a DColumnStore or values collected in a loop over setBranchAddresses()), without filling a histogram first. The result does not depend on any binning.
+	 *
+	 * The negative log-likelihood and its analytic gradient are given to Minuit2. They are evaluated with AVX2 vector instructions if available (see simdLevel()) and, for large samples, split across threads. The Gaussians are normalised to the fit range, so values outside of the range can simply be left out.
+	 *
+	 * The fits return TF1s with the parameter layout of doubleGaussFit() (or gaussFit()); the constants are scaled to a histogram of the same values with the given bin width, so the functions can be drawn on top of it and passed on to doubleGaussToTwoGauss().
+	 * @{
+	 */
+	/**
+	 * @brief Sums over all values needed for the likelihood of a mixture of Gaussians and its gradient
+	 * @details For each Gaussian i: w = its fraction of the total probability density of the value, d = distance of the value to the mean of Gaussian i.
+	 */
+	struct gaussLikelihoodSums {
+		double logP; ///< Sum of the logarithms of the probability densities
+		double w[2]; ///< Sum of w
+		double wd[2]; ///< Sum of w * d
+		double wd2[2]; ///< Sum of w * d^2
+
+		gaussLikelihoodSums();
+		void add(const gaussLikelihoodSums & other);
+	};
+	/**
+	 * @brief Accumulates gaussLikelihoodSums of the values [first, last), scalar version
+	 * @details Gaussian i is `norm[i] * exp(-(x - mean[i])^2 * halfInverseVariance[i])`; with only one Gaussian, norm[1] is 0.
+	 */
+	void gaussLikelihoodSumsScalar(const double * values, Long64_t first, Long64_t last, const double * norm, const double * mean, const double * halfInverseVariance, gaussLikelihoodSums & sums);
+	/**
+	 * @brief Negative log-likelihood of one or two Gaussians, normalised to a range, with analytic gradient
+	 * @details Parameters for two Gaussians: fraction of the first (inner) one, mean and sigma of the first, mean and sigma of the second. For one Gaussian: mean and sigma.
+	 *
+	 * The value and the gradient are calculated together in one pass over the values; Minuit2 asks for them separately, so the last result is kept.
+	 *
+	 * Samples of less than 200000 values are evaluated on the calling thread only. Larger ones are split over a threadPool which is started once with the object (and shared by its clones) and reused for every evaluation.
+	 */
+	class gaussLikelihood : public ROOT::Math::IMultiGradFunction {
+	public:
+		/**
+		 * @param values Values to fit, all inside of [rangeStart, rangeEnd]; not copied, need to live as long as the object
+		 * @param nGaussians 1 or 2
+		 * @param nThreads Maximum number of threads for one evaluation; at most one per 100000 values is used
+		 */
+		gaussLikelihood(const std::vector<double> * values, double rangeStart, double rangeEnd, int nGaussians, int nThreads) : nEvaluations(0), values(values), rangeStart(rangeStart), rangeEnd(rangeEnd), nGaussians(nGaussians), pool(new threadPool(std::max(1, std::min<int>(nThreads, values->size() / 100000)))), threadSums(pool->size()), lastX(5, NAN), lastGradient(5, 0), lastValue(0) {}
+
+		unsigned int NDim() const { return (nGaussians == 2) ? 5 : 2; }
+		ROOT::Math::IMultiGenFunction * Clone() const { return new gaussLikelihood(*this); }
+		void Gradient(const double * x, double * gradient) const;
+		void FdF(const double * x, double & value, double * gradient) const;
+		mutable unsigned int nEvaluations; ///< Number of passes over the values
+
+	private:
+		double DoEval(const double * x) const { return evaluate(x); }
+		double DoDerivative(const double * x, unsigned int i) const;
+		/**
+		 * @brief Value for parameters x; also fills lastGradient
+		 */
+		double evaluate(const double * x) const;
+
+		const std::vector<double> * values;
+		double rangeStart, rangeEnd;
+		int nGaussians;
+		std::shared_ptr<threadPool> pool;  // shared with the clones, which Minuit2 evaluates one after another
+		mutable std::vector<gaussLikelihoodSums> threadSums;
+		mutable std::vector<double> lastX, lastGradient;
+		mutable double lastValue;
+	};
+	/**
+	 * @brief Unbinned maximum likelihood fit of a double Gaussian to a column of values
+	 * @details The returned function has the parameters of doubleGaussFit(); its constants correspond to a histogram with bin width binWidth. Inner is the Gaussian with the larger fraction of the starting parameters, which need not be the narrower one after the fit.
+	 * 
+	 * @param values Values to fit; values outside of the range are ignored
+	 * @param binWidth Bin width of the histogram the resulting function should describe
+	 * @param rangeStart Start of the fit range
+	 * @param rangeEnd End of the fit range
+	 * @param startParameters Six starting parameters as for doubleGaussFit(); determined with doubleGaussSeed() if NULL
+	 * @param verbose Print fitting parameters
+	 * @param nThreads Maximum number of threads per evaluation, see numberOfThreads()
+	 * @return A TF1 "gaus(0)+gaus(3)", owned by the caller
+	 */
+	TF1 * doubleGaussFitUnbinned(const std::vector<double> & values, double binWidth, double rangeStart, double rangeEnd, double * startParameters = 0, bool verbose = false, int nThreads = 0);
+	/**
+	 * @brief Unbinned double Gaussian fit to a column of n Float_t values, e.g. from a DColumnStore; see doubleGaussFitUnbinned()
+	 */
+	TF1 * doubleGaussFitUnbinned(const Float_t * values, Long64_t n, double binWidth, double rangeStart, double rangeEnd, double * startParameters = 0, bool verbose = false, int nThreads = 0);
+	/**
+	 * @brief Unbinned maximum likelihood fit of a single Gaussian to a column of values
+	 * @details As doubleGaussFitUnbinned(), with the parameters of gaussFit().
+	 * 
+	 * @param startParameters Three starting parameters (constant, mean, sigma); determined from the values if NULL
+	 * @return A TF1 "gaus", owned by the caller
+	 */
+	TF1 * gaussFitUnbinned(const std::vector<double> & values, double binWidth, double rangeStart, double rangeEnd, double * startParameters = 0, bool verbose = false, int nThreads = 0);
+	/**
+	 * @brief Unbinned single Gaussian fit to a column of n Float_t values; see gaussFitUnbinned()
+	 */
+	TF1 * gaussFitUnbinned(const Float_t * values, Long64_t n, double binWidth, double rangeStart, double rangeEnd, double * startParameters = 0, bool verbose = false, int nThreads = 0);
+	/**
+	 * @}
+	 */
+
+	/**
+	 * @name Parallel reading
+	 * @details The parallel companion of treeFromMultipleFiles(): The files of a file list are distributed over several threads, each thread opening its own files with its own DInfoContainer bound to them. Outputs are filled per thread and merged at the end, see parallelOutput. For an already existing tree or chain, see eventLoop.
+	 *
+	 * A serial macro like
+	 * ~~~
+	 * TTree * tree = andi::treeFromMultipleFiles("ntp", "files.txt");
+	 * andi::DInfoContainer c;
+	 * andi::setBranchAddresses(tree, c, "D");
+	 * for (Long64_t i = 0; i < tree->GetEntries(); i++) {
+	 *     tree->GetEntry(i);
+	 *     hMass->Fill(c.m.m);
+	 * }
+	 * ~~~
+	 * becomes
+	 * ~~~
+	 * andi::parallelOutput out;
+	 * out.book(hMass);
+	 * andi::processFilesParallel("ntp", "files.txt", "D", out, [&](const andi::parallelEntry & e) {
+	 *     out.hist(e.slot, 0)->Fill(e.container->m.m);
+	 * });
+	 * // hMass is filled now
+	 * ~~~
+	 * @{
+	 */
+	/**
+	 * @brief The file names of a file list as used by treeFromMultipleFiles()
+	 */
+	std::vector<TString> filesFromList(TString fileName);
+	/**
+	 * @brief One entry as seen by the function given to processFilesParallel()
+	 */
+	struct parallelEntry {
+		int slot; ///< Number of the thread, 0 to nThreads - 1. Use it to pick the per-thread outputs.
+		int iFile; ///< Number of the file in the file list
+		Long64_t entry; ///< Number of the entry in the tree of this file
+		TTree * tree; ///< The tree of this file; switch on and bind more branches if you need them
+		const DInfoContainer * container; ///< The bound container, already filled for this entry
+	};
+	/**
+	 * @brief Reads the trees of all files of a file list on several threads
+	 * @details First, all files are opened once (in parallel) to get their numbers of entries and clusters (clusterStarts()). The entries are then split into ranges of whole clusters of about a quarter of the entries per thread, so a single large file is read by several threads as in eventLoop::run(). Every thread takes the next range which is not yet processed, opens its file (kept open while the next range is in the same file), binds its own DInfoContainer with bindBranches() (only the fields in fieldMask, all other branches switched off) and calls entryFunction for every entry. The function is called concurrently from all threads, so it must only write to per-thread (per-slot) outputs.
+	 *
+	 * Files and ranges are processed in any order; use the returned numbers of entries per file to make global entry numbers (as in the TChain of treeFromMultipleFiles()) out of iFile and entry.
+	 * 
+	 * @param treeName Name of the tree in every file
+	 * @param fileName A text file with one file per line
+	 * @param baseString The string prefixing all the branches, as in setBranchAddresses()
+	 * @param entryFunction Function called for every entry
+	 * @param nThreads Number of threads, 0 = all cores
+	 * @param fieldMask Which fields to bind, see propertiesFieldBits
+	 * @param alsoDaugthers Bind also the daughters
+	 * @return Number of entries of every file, -1 for files which could not be read
+	 */
+	std::vector<Long64_t> processFilesParallel(TString treeName, TString fileName, TString baseString, const std::function<void(const parallelEntry &)> & entryFunction, int nThreads = 0, UInt_t fieldMask = kFieldsAll, bool alsoDaugthers = true);
+	/**
+	 * @brief Per-thread outputs of parallel loops, merged at the end: histograms, counts and selected entries
+	 * @details Histograms are booked once (book()); every thread then fills its own clone (hist()), so no locks are needed. merge() adds all clones to the booked histograms, which can be used with all the drawing helpers afterwards.
+	 */
+	struct parallelOutput {
+		int nSlots; ///< Number of threads the outputs are prepared for
+		std::vector<TH1 *> histograms; ///< The booked histograms; filled with the sum of all clones after merge()
+		std::vector<std::vector<TH1 *> > clones; ///< clones[slot][iHist]
+		std::vector<Long64_t> slotCounts; ///< Counter per thread
+		std::vector<std::vector<std::pair<int, Long64_t> > > slotSelected; ///< Selected (file, entry) per thread
+		Long64_t count; ///< Sum of all counters after merge()
+		std::vector<Long64_t> selectedEntries; ///< Selected entries after merge(), numbered as in the TChain of treeFromMultipleFiles(), sorted
+		parallelOutput(int _nSlots = 0) : nSlots(numberOfThreads(_nSlots)), clones(nSlots), slotCounts(nSlots, 0), slotSelected(nSlots), count(0) {}
+		~parallelOutput();
+		/**
+		 * @brief Books a histogram for filling in all threads
+		 * @return Number of the histogram, to be used in hist()
+		 */
+		int book(TH1 * hist);
+		TH1 * hist(int slot, int iHist) { return clones[slot][iHist]; } ///< The clone of histogram iHist of thread slot
+		void increment(int slot) { slotCounts[slot]++; } ///< Counts one (e.g. a selected entry) in thread slot
+		void select(const parallelEntry & e) { slotSelected[e.slot].push_back(std::make_pair(e.iFile, e.entry)); } ///< Remembers the current entry as selected
+		/**
+		 * @brief Adds up all per-thread outputs
+		 * @param entriesPerFile As returned by processFilesParallel(), to number the selected entries
+		 */
+		void merge(const std::vector<Long64_t> & entriesPerFile);
+	private:
+		parallelOutput(const parallelOutput &);  // owns the clones
+		parallelOutput & operator=(const parallelOutput &);
+	};
+	/**
+	 * @brief processFilesParallel() with one thread per slot of a parallelOutput, merging it at the end
+	 */
+	std::vector<Long64_t> processFilesParallel(TString treeName, TString fileName, TString baseString, parallelOutput & output, const std::function<void(const parallelEntry &)> & entryFunction, UInt_t fieldMask = kFieldsAll, bool alsoDaugthers = true);
+	/**
+	 * @brief Event loop over a tree or chain on several threads, with per-thread histograms
+	 * @details Book histograms with book(), then run() a function over all entries. The entries are split into one range per thread; every thread reads its range with its own TChain of the same files and fills only its own clones of the booked histograms, so no locks are needed while filling. At the end, the clones are merged into the booked histograms, which can be given to createCanvasDrawAndSave(), histogramsToStack() and friends as usual.
+	 *
+	 * ~~~
+	 * andi::eventLoop loop;
+	 * int iMass = loop.book(hMass);
+	 * int iPtM = loop.book(hPtVsMass);
+	 * loop.run(tree, "D", [&](const andi::parallelEntry & e) {
+	 *     loop.hist(e.slot, iMass)->Fill(e.container->m.m);
+	 *     ((TH2 *) loop.hist(e.slot, iPtM))->Fill(e.container->m.m, e.container->m.pt);
+	 * });
+	 * andi::createCanvasDrawAndSave(hMass, "Mass", "myMacro");
+	 * ~~~
+	 *
+	 * Trees which do not live in a file are read in the calling thread only.
+	 */
+	struct eventLoop {
+		parallelOutput output; ///< Booked histograms, counters and selected entries (all merged after run())
+		eventLoop(int nThreads = 0) : output(nThreads) {}
+		int book(TH1 * hist) { return output.book(hist); } ///< Books a histogram, see parallelOutput::book()
+		TH1 * hist(int slot, int iHist) { return output.hist(slot, iHist); } ///< The clone of histogram iHist of thread slot
+		/**
+		 * @brief Runs over all entries of a tree or chain
+		 * @details setupFunction is called once per thread with the thread's own tree, e.g. to bind branches to per-thread variables. eventFunction is then called for every entry of the thread's range, after GetEntry(). Both are called concurrently from all threads.
+		 *
+		 * If the tree has an entry list (e.g. from applyPreselection()), only its entries are processed, split evenly over the threads.
+		 * 
+		 * @param tree The tree or chain (e.g. from treeFromMultipleFiles())
+		 * @param setupFunction Called once per thread with (slot, tree of the thread)
+		 * @param eventFunction Called for every entry with (slot, entry number in tree)
+		 * @return Number of entries processed
+		 */
+		Long64_t run(TTree * tree, const std::function<void(int, TTree *)> & setupFunction, const std::function<void(int, Long64_t)> & eventFunction);
+		/**
+		 * @brief Runs over all entries of a tree or chain with a bound DInfoContainer per thread
+		 * @details As the other run(), but every thread binds its own container with bindBranches() (only the fields in fieldMask, other branches switched off). In the parallelEntry handed to eventFunction, entry is the entry number in the (whole) tree and iFile is always 0; select() therefore works as usual. An in-memory tree is read directly; its branch addresses and branch status are reset afterwards (unbindBranches()).
+		 */
+		Long64_t run(TTree * tree, TString baseString, const std::function<void(const parallelEntry &)> & eventFunction, UInt_t fieldMask = kFieldsAll, bool alsoDaugthers = true);
+	};
+	/**
+	 * @}
+	 */
+
+}
+
+#endif // ANDI_COMMON_H
@@ -11,3 +11,7 @@ alias rq="r -b -q"
 #  * --glibs tells to the compiler the location and names of the libraries used
 #  * --cflags lists the flags for the compiler, e.g. compile for C++11, but also ROOT's include dir
 alias compileWithRoot="`root-config --cxx --glibs --cflags`"
+
+# The andi helpers (common.cpp) are loaded by .rootrc in every session. Compile them once with "make" in their directory (alias andiBuild) and every r / rb / rq starts with the precompiled libAndiCommon instead of interpreting common.cpp.
+ANDI_COMMON_DIR=~/Documents/Coding/PhysicsAnalysis
+alias andiBuild="make -C $ANDI_COMMON_DIR"